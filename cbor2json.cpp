@@ -0,0 +1,162 @@
+/** @file cbor2json.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Turns captured CBOR payloads back into JSON
+ *
+ *  usage: cbor2json [-b] [capture ...]
+ *
+ *  Reads the payloads of CBORTOPIC back to back from each file, or stdin,
+ *  e.g. mosquitto_sub -N -t "Logger Data/cbor" > capture. A newline
+ *  between payloads is skipped. Each reading is written as the TOPIC JSON
+ *  object on its own line, -b writes each payload as one BATCHTOPIC
+ *  object instead.
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "dlbatch.h"
+#include "dlcbor.h"
+#include "dlformat.h"
+
+#define CBORREADSZ 65536
+
+/** @brief Prints usage to stderr
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * prog
+ *  @return void
+ */
+static void DlCborUsage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-b] [capture ...]\n", prog);
+}
+
+/** @brief Reads a whole stream into memory
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param FILE * in
+ *  @param size_t * len receives the bytes read
+ *  @return uint8_t * malloc'd buffer, NULL if out of memory
+ */
+static uint8_t *DlCborSlurp(FILE *in, size_t *len)
+{
+	uint8_t *buf = NULL, *grown;
+	size_t cap = 0;
+	size_t n;
+
+	*len = 0;
+	do {
+		if (cap - *len < CBORREADSZ) {
+			cap += cap + CBORREADSZ;
+			grown = (uint8_t *)realloc(buf, cap);
+			if (grown == NULL) {
+				free(buf);
+				return NULL;
+			}
+			buf = grown;
+		}
+		n = fread(buf + *len, 1, cap - *len, in);
+		*len += n;
+	} while (n > 0);
+	return buf;
+}
+
+/** @brief Converts every payload of one capture
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * name for messages
+ *  @param FILE * in
+ *  @param int batched write BATCHTOPIC objects
+ *  @return int 0 on success, 1 on a read or decode error
+ */
+static int DlCborConvert(const char *name, FILE *in, int batched)
+{
+	static dlbatch_s batch;
+	static reading_s rows[BATCHMAXRECORDS];
+	dlbatchcfg_s cfg = { BATCHMAXRECORDS, BATCHLINGERMS };
+	char text[PAYLOADSTRSZ];
+	const char *payload;
+	uint64_t serial, payloads = 0, readings = 0;
+	uint8_t *buf;
+	size_t len, off = 0, used, plen;
+	int n, i, tlen;
+
+	buf = DlCborSlurp(in, &len);
+	if (buf == NULL) {
+		fprintf(stderr, "%s: out of memory\n", name);
+		return 1;
+	}
+	while (off < len) {
+		if (buf[off] == '\n') {
+			off++;
+			continue;
+		}
+		n = DlCborDecodeBatch(buf + off, len - off, &used, &serial, rows, BATCHMAXRECORDS);
+		if (n < 0) {
+			fprintf(stderr, "%s: bad payload at byte %zu\n", name, off);
+			free(buf);
+			return 1;
+		}
+		if (batched && n > 0) {
+			DlBatchInit(&batch, &cfg, serial, DLENC_JSON);
+			for (i = 0; i < n; i++) {
+				DlBatchAdd(&batch, rows[i]);
+			}
+			payload = DlBatchFinish(&batch, &plen);
+			fwrite(payload, 1, plen, stdout);
+			fputc('\n', stdout);
+		}
+		for (i = 0; !batched && i < n; i++) {
+			tlen = DlFormatLoggerJson(rows[i], text, sizeof(text) - 1);
+			if (tlen > 0) {
+				text[tlen++] = '\n';
+			}
+			fwrite(text, 1, tlen, stdout);
+		}
+		off += used;
+		payloads++;
+		readings += n;
+	}
+	fprintf(stderr, "%s: %" PRIu64 " payloads, %" PRIu64 " readings\n", name, payloads, readings);
+	free(buf);
+	return 0;
+}
+
+/** @brief Converts every capture named on the command line, or stdin
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int argc
+ *  @param char ** argv
+ *  @return int 0 on success, 1 on a usage, file or decode error
+ */
+int main(int argc, char **argv)
+{
+	FILE *in;
+	int batched = 0;
+	int rc = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b")) != -1) {
+		if (opt == 'b') {
+			batched = 1;
+		} else {
+			DlCborUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind >= argc) {
+		return DlCborConvert("stdin", stdin, batched);
+	}
+	for (; optind < argc; optind++) {
+		in = fopen(argv[optind], "rb");
+		if (in == NULL) {
+			perror(argv[optind]);
+			rc = 1;
+			continue;
+		}
+		rc |= DlCborConvert(argv[optind], in, batched);
+		fclose(in);
+	}
+	return rc;
+}
@@ -0,0 +1,88 @@
+/** @file dlalert.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Harsh driving and crash detection on the IMU channels
+ */
+#include "dlalert.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "dltime.h"
+
+static const char *alertname[DLALERT_COUNT] = { "harsh", "crash" };
+static uint64_t lastalert[DLALERT_COUNT];
+static float gravity[3];       // low-pass baseline of the samples, g
+static uint64_t gravitytns;    // sample the baseline last took in, 0 none yet
+
+/** @brief Checks an accelerometer sample for a driving event, only the IMU
+ *  channel calls it, with every sample in time order
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint64_t tns CLOCK_MONOTONIC ns of the sample
+ *  @param float xa acceleration g
+ *  @param float ya
+ *  @param float za
+ *  @param dlalert_s * alert receives the event
+ *  @return int 1 if an alert was raised
+ */
+int DlAlertCheck(uint64_t tns, float xa, float ya, float za, dlalert_s *alert)
+{
+	float a[3] = { xa, ya, za }, d[3];
+	float k, norm, along, total, horizontal;
+	dlalertkind_e kind;
+	uint64_t dt;
+	int i;
+
+	if (std::isnan(xa) || std::isnan(ya) || std::isnan(za)) {
+		return 0;
+	}
+	if (gravitytns == 0 || tns <= gravitytns) {
+		memcpy(gravity, a, sizeof(gravity));
+		gravitytns = tns;
+		return 0;
+	}
+	// what the sample adds to the baseline before the baseline takes it in
+	dt = tns - gravitytns;
+	k = (float)dt / (float)(dt + ALERTGRAVITYMS * NSPERMS);
+	for (i = 0; i < 3; i++) {
+		d[i] = a[i] - gravity[i];
+		gravity[i] += k * d[i];
+	}
+	gravitytns = tns;
+	total = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+	norm = sqrtf(gravity[0] * gravity[0] + gravity[1] * gravity[1] + gravity[2] * gravity[2]);
+	along = norm > 0 ? (d[0] * gravity[0] + d[1] * gravity[1] + d[2] * gravity[2]) / norm : 0;
+	horizontal = sqrtf(fmaxf(total * total - along * along, 0));
+	if (total > ALERTCRASHG) {
+		kind = DLALERT_CRASH;
+	} else if (horizontal > ALERTHARSHG) {
+		kind = DLALERT_HARSH;
+	} else {
+		return 0;
+	}
+	if (lastalert[kind] && tns - lastalert[kind] < ALERTHOLDOFFMS * NSPERMS) {
+		return 0;
+	}
+	lastalert[kind] = tns;
+	alert->tns = tns;
+	alert->toffset = DlTimeOffset();
+	alert->kind = kind;
+	alert->g = kind == DLALERT_CRASH ? total : horizontal;
+	return 1;
+}
+
+/** @brief Formats an alert as the payload of ALERTTOPIC
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlalert_s & alert
+ *  @param char * jsondata output buffer
+ *  @param size_t len size of jsondata
+ *  @return int number of characters written, 0 if jsondata is too small
+ */
+int DlFormatAlert(const dlalert_s &alert, char *jsondata, size_t len)
+{
+	int n = snprintf(jsondata, len, "{\"time\":%" PRIu64 ",\"event\":\"%s\",\"g\":%.2f}",
+		DlTimeEpochMs(alert.tns, alert.toffset), alertname[alert.kind], alert.g);
+
+	return n > 0 && (size_t)n < len ? n : 0;
+}
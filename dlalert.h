@@ -0,0 +1,43 @@
+#ifndef DLALERT_H
+#define DLALERT_H
+/** @file dlalert.h
+ *  @brief Constants, structures, function prototypes for driving event alerts
+ *
+ *  The IMU channel checks every accelerometer sample for harsh
+ *  acceleration or braking and for crash level shocks. Gravity is taken
+ *  out first with a low-pass baseline of the samples, with time constant
+ *  ALERTGRAVITYMS, so a tilted unit reads zero at rest. Harsh driving is
+ *  what is left across the baseline, a crash is what is left in total.
+ *  An alert goes out on the alert lane ahead of live data and any backlog.
+ */
+#include <cinttypes>
+#include <cstddef>
+
+#define ALERTHARSHG 0.45f      ///< Horizontal acceleration of a harsh brake, turn or launch
+#define ALERTCRASHG 2.5f       ///< Acceleration of a crash, gravity removed
+#define ALERTGRAVITYMS 2000    ///< Time constant of the gravity baseline
+#define ALERTHOLDOFFMS 2000    ///< Quiet time after an alert of the same kind
+#define ALERTRINGSZ 16
+#define ALERTPAYLOADSZ 128
+
+enum dlalertkind_e
+{
+	DLALERT_HARSH,  ///< Harsh braking, cornering or acceleration
+	DLALERT_CRASH,  ///< Shock beyond ALERTCRASHG
+	DLALERT_COUNT
+};
+
+typedef struct dlalert
+{
+	uint64_t tns;         ///< CLOCK_MONOTONIC ns of the sample that raised it
+	int64_t toffset;      ///< UTC minus CLOCK_MONOTONIC ns
+	dlalertkind_e kind;
+	float g;              ///< Peak acceleration, g
+} dlalert_s;
+
+///\cond INTERNAL
+// Function Prototypes
+int DlAlertCheck(uint64_t tns, float xa, float ya, float za, dlalert_s *alert);
+int DlFormatAlert(const dlalert_s &alert, char *jsondata, size_t len);
+///\endcond
+#endif
@@ -0,0 +1,137 @@
+/** @file dlbatch.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Packs many readings into one MQTT payload
+ */
+#include "dlbatch.h"
+#include <cstdio>
+#include "dltime.h"
+
+/** @brief Sets up an empty batch
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbatch_s * b
+ *  @param const dlbatchcfg_s * cfg NULL for the defaults
+ *  @param uint64_t serial unit serial from DlGetSerial
+ *  @param dlencoding_e encoding payload layout
+ *  @return void
+ */
+void DlBatchInit(dlbatch_s *b, const dlbatchcfg_s *cfg, uint64_t serial, dlencoding_e encoding)
+{
+	b->cfg.records = cfg ? cfg->records : BATCHRECORDS;
+	b->cfg.lingerms = cfg ? cfg->lingerms : BATCHLINGERMS;
+	if (b->cfg.records < 1) {
+		b->cfg.records = 1;
+	}
+	if (b->cfg.records > BATCHMAXRECORDS) {
+		b->cfg.records = BATCHMAXRECORDS;
+	}
+	b->serial = serial;
+	b->encoding = encoding;
+	DlBatchReset(b);
+}
+
+/** @brief Appends a reading, the first one writes the shared header
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbatch_s * b
+ *  @param const reading_s & creads
+ *  @return int 1 once the batch is full and should be published
+ */
+int DlBatchAdd(dlbatch_s *b, const reading_s &creads)
+{
+	char names[BATCHHDRSZ];
+	uint8_t *bin = (uint8_t *)b->buf;
+	int n;
+
+	if (b->encoding == DLENC_CBOR) {
+		if (b->count == 0) {
+			b->t0ms = DlTimeEpochMs(creads.tns, creads.toffset);
+			b->opened = DlTimeNow();
+			b->len = DlCborBatchHead(b->serial, b->t0ms, bin, BATCHHDRSZ);
+		}
+		b->len += DlCborBatchRow(creads, b->t0ms, bin + b->len, sizeof(b->buf) - b->len);
+		b->count++;
+		return b->count >= b->cfg.records;
+	}
+	if (b->count == 0) {
+		b->t0ms = DlTimeEpochMs(creads.tns, creads.toffset);
+		b->opened = DlTimeNow();
+		DlFormatFieldNames(names, sizeof(names));
+		b->len = snprintf(b->buf, BATCHHDRSZ, "{\"serial\":\"%" PRIx64 "\",\"t0\":%" PRIu64 ",\"fields\":[%s],\"rows\":[",
+			b->serial, b->t0ms, names);
+	} else {
+		b->buf[b->len++] = ',';
+	}
+	n = DlFormatBatchRow(creads, b->t0ms, b->buf + b->len, sizeof(b->buf) - b->len);
+	b->len += n;
+	b->count++;
+	return b->count >= b->cfg.records;
+}
+
+/** @brief Checks whether a partial batch has waited lingerms
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlbatch_s * b
+ *  @return int 1 if the batch should be published
+ */
+int DlBatchDue(const dlbatch_s *b)
+{
+	return b->count > 0 && DlTimeNow() - b->opened >= b->cfg.lingerms * NSPERMS;
+}
+
+/** @brief Time the caller may sleep before the batch is due
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlbatch_s * b
+ *  @return uint32_t ms, at least 1 for a partial batch, 0 when empty (no deadline)
+ */
+uint32_t DlBatchWaitMs(const dlbatch_s *b)
+{
+	uint64_t age;
+
+	if (b->count == 0) {
+		return 0;
+	}
+	age = (DlTimeNow() - b->opened) / NSPERMS;
+	return age + 1 >= b->cfg.lingerms ? 1 : (uint32_t)(b->cfg.lingerms - age);
+}
+
+/** @brief Closes the payload, the batch must be reset after publishing
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbatch_s * b
+ *  @param size_t * len receives the payload length
+ *  @return const char * payload, NULL if the batch is empty. A CBOR
+ *  payload is binary and not terminated.
+ */
+const char *DlBatchFinish(dlbatch_s *b, size_t *len)
+{
+	if (b->count == 0) {
+		return NULL;
+	}
+	if (b->encoding == DLENC_CBOR) {
+		b->buf[b->len++] = (char)CBORBREAK;
+		*len = b->len;
+		return b->buf;
+	}
+	b->buf[b->len++] = ']';
+	b->buf[b->len++] = '}';
+	b->buf[b->len] = '\0';
+	*len = b->len;
+	return b->buf;
+}
+
+/** @brief Empties the batch
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbatch_s * b
+ *  @return void
+ */
+void DlBatchReset(dlbatch_s *b)
+{
+	b->count = 0;
+	b->len = 0;
+	b->t0ms = 0;
+	b->opened = 0;
+}
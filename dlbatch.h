@@ -0,0 +1,61 @@
+#ifndef DLBATCH_H
+#define DLBATCH_H
+/** @file dlbatch.h
+ *  @brief Constants, structures, function prototypes for batched MQTT payloads
+ *
+ *  A batch packs up to records readings, or lingerms worth of readings,
+ *  into one JSON payload. The shared fields are sent once:
+ *
+ *  {"serial":"e69836d","t0":1760709902000,
+ *   "fields":["dt","temperature",...,"heading"],
+ *   "rows":[[0,20.7,...,277.799988],[100,20.7,...]]}
+ *
+ *  t0 is the UTC epoch ms of the first row and dt the ms after it. A CBOR
+ *  batch carries the same rows in the binary layout of dlcbor.h.
+ */
+#include <cinttypes>
+#include <cstddef>
+#include "dlcbor.h"
+#include "dlformat.h"
+#include "logger.h"
+
+#define BATCHRECORDS 1         ///< Readings per message, 1 publishes each reading on its own
+#define BATCHLINGERMS 1000     ///< Longest a reading waits for its batch to fill
+#define BATCHMAXRECORDS 64
+#define BATCHHDRSZ 1024
+#define BATCHBUFSZ (BATCHHDRSZ + BATCHMAXRECORDS * (BATCHROWSZ + 1))
+
+enum dlencoding_e
+{
+	DLENC_JSON,  ///< Text rows, readable by dashboards
+	DLENC_CBOR   ///< Binary rows, for metered uplinks
+};
+
+typedef struct dlbatchcfg
+{
+	int records;        ///< Readings per message, 1 to BATCHMAXRECORDS
+	uint32_t lingerms;  ///< Publish a partial batch once its first reading is this old
+} dlbatchcfg_s;
+
+typedef struct dlbatch
+{
+	dlbatchcfg_s cfg;
+	dlencoding_e encoding;
+	uint64_t serial;        ///< Unit serial written in every header
+	uint64_t t0ms;          ///< UTC epoch ms of the first reading
+	uint64_t opened;        ///< CLOCK_MONOTONIC ns the first reading was added
+	int count;              ///< Readings in the batch
+	size_t len;             ///< Payload bytes so far
+	char buf[BATCHBUFSZ];   ///< Payload
+} dlbatch_s;
+
+///\cond INTERNAL
+// Function Prototypes
+void DlBatchInit(dlbatch_s *b, const dlbatchcfg_s *cfg, uint64_t serial, dlencoding_e encoding = DLENC_JSON);
+int DlBatchAdd(dlbatch_s *b, const reading_s &creads);
+int DlBatchDue(const dlbatch_s *b);
+uint32_t DlBatchWaitMs(const dlbatch_s *b);
+const char *DlBatchFinish(dlbatch_s *b, size_t *len);
+void DlBatchReset(dlbatch_s *b);
+///\endcond
+#endif
@@ -0,0 +1,311 @@
+/** @file dlbudget.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Token bucket uplink budget and the summaries sent when it runs low
+ */
+#include "dlbudget.h"
+#include <cmath>
+#include "dltime.h"
+
+/** @brief Adds the tokens earned since the last refill and picks the mode
+ *  for the new level, caller holds b->lock
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbudget_s * b
+ *  @param uint64_t now CLOCK_MONOTONIC ns
+ *  @return void
+ */
+static void DlBudgetRefill(dlbudget_s *b, uint64_t now)
+{
+	int mode = b->mode.load();
+	int next;
+	float level;
+
+	b->modens[mode] += now - b->lastns;
+	if (b->cfg.bytes == 0) {
+		b->lastns = now;
+		return;
+	}
+	b->tokens += (now - b->lastns) * b->rate;
+	if (b->tokens > b->depth) {
+		b->tokens = b->depth;
+	}
+	b->lastns = now;
+	level = (float)(b->tokens / b->depth);
+	if (level < BUDGETSUMMARYAT) {
+		next = DLBUDGET_SUMMARY;
+	} else if (level < BUDGETDECIMATEAT) {
+		next = mode == DLBUDGET_SUMMARY && level < BUDGETSUMMARYAT + BUDGETHYSTERESIS ?
+			DLBUDGET_SUMMARY : DLBUDGET_DECIMATE;
+	} else if (mode != DLBUDGET_RAW && level < BUDGETDECIMATEAT + BUDGETHYSTERESIS) {
+		next = DLBUDGET_DECIMATE;
+	} else {
+		next = DLBUDGET_RAW;
+	}
+	if (next != mode) {
+		b->mode = next;
+		b->changes++;
+	}
+}
+
+/** @brief Sets up a full bucket
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbudget_s * b
+ *  @param const dlbudgetcfg_s * cfg NULL for the defaults
+ *  @return void
+ */
+void DlBudgetInit(dlbudget_s *b, const dlbudgetcfg_s *cfg)
+{
+	int i;
+
+	b->cfg.bytes = cfg ? cfg->bytes : BUDGETBYTES;
+	b->cfg.periodsec = cfg ? cfg->periodsec : BUDGETPERIODSEC;
+	b->cfg.depthsec = cfg ? cfg->depthsec : BUDGETDEPTHSEC;
+	b->cfg.decimate = cfg ? cfg->decimate : BUDGETDECIMATE;
+	b->cfg.summaryms = cfg ? cfg->summaryms : BUDGETSUMMARYMS;
+	if (b->cfg.periodsec == 0) {
+		b->cfg.periodsec = BUDGETPERIODSEC;
+	}
+	if (b->cfg.decimate == 0) {
+		b->cfg.decimate = 1;
+	}
+	pthread_mutex_init(&b->lock, NULL);
+	b->rate = (double)b->cfg.bytes / b->cfg.periodsec / NSPERSEC;
+	b->depth = b->rate * b->cfg.depthsec * NSPERSEC;
+	if (b->depth < BUDGETMINDEPTH) {
+		b->depth = BUDGETMINDEPTH;
+	}
+	b->tokens = b->depth;
+	b->started = b->lastns = DlTimeNow();
+	for (i = 0; i < DLBUDGET_COUNT; i++) {
+		b->modens[i] = 0;
+	}
+	b->mode = DLBUDGET_RAW;
+	b->sent = 0;
+	b->sentbytes = 0;
+	b->forcedbytes = 0;
+	b->refused = 0;
+	b->refusedbytes = 0;
+	b->skipped = 0;
+	b->summarised = 0;
+	b->summaries = 0;
+	b->changes = 0;
+}
+
+/** @brief Takes the wire size of one message from the bucket
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbudget_s * b
+ *  @param size_t bytes
+ *  @param float reserve fraction of the bucket that must be left afterwards,
+ *  BUDGETFORCE to always grant
+ *  @return int 1 if the message may be sent, 0 if it is over budget
+ */
+int DlBudgetTake(dlbudget_s *b, size_t bytes, float reserve)
+{
+	int granted;
+
+	pthread_mutex_lock(&b->lock);
+	DlBudgetRefill(b, DlTimeNow());
+	granted = b->cfg.bytes == 0 || reserve < 0 || b->tokens - bytes >= reserve * b->depth;
+	if (granted && b->cfg.bytes) {
+		b->tokens -= bytes;
+		if (b->tokens < -b->depth) {
+			b->tokens = -b->depth;
+		}
+	}
+	pthread_mutex_unlock(&b->lock);
+	if (!granted) {
+		b->refused++;
+		b->refusedbytes += bytes;
+		return 0;
+	}
+	b->sent++;
+	b->sentbytes += bytes;
+	if (reserve < 0) {
+		b->forcedbytes += bytes;
+	}
+	return 1;
+}
+
+/** @brief Gives back the bytes of a message that was granted but not sent
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbudget_s * b
+ *  @param size_t bytes
+ *  @return void
+ */
+void DlBudgetRefund(dlbudget_s *b, size_t bytes)
+{
+	pthread_mutex_lock(&b->lock);
+	if (b->cfg.bytes) {
+		b->tokens += bytes;
+	}
+	pthread_mutex_unlock(&b->lock);
+	b->sent--;
+	b->sentbytes -= bytes;
+}
+
+/** @brief Refills the bucket and returns how readings should be published
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbudget_s * b
+ *  @return dlbudgetmode_e
+ */
+dlbudgetmode_e DlBudgetMode(dlbudget_s *b)
+{
+	pthread_mutex_lock(&b->lock);
+	DlBudgetRefill(b, DlTimeNow());
+	pthread_mutex_unlock(&b->lock);
+	return (dlbudgetmode_e)b->mode.load();
+}
+
+/** @brief Prints the bucket level, bytes used against the budget and the
+ *  time spent decimating or summarising
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbudget_s * b
+ *  @param FILE * fp
+ *  @return void
+ */
+void DlBudgetReport(dlbudget_s *b, FILE *fp)
+{
+	static const char *modename[] = { "raw", "decimate", "summary" };
+	uint64_t modens[DLBUDGET_COUNT];
+	uint64_t up, used = b->sentbytes.load();
+	double level;
+	int i;
+
+	pthread_mutex_lock(&b->lock);
+	DlBudgetRefill(b, DlTimeNow());
+	level = b->tokens / b->depth;
+	up = b->lastns - b->started;
+	for (i = 0; i < DLBUDGET_COUNT; i++) {
+		modens[i] = b->modens[i];
+	}
+	pthread_mutex_unlock(&b->lock);
+	if (b->cfg.bytes) {
+		fprintf(fp, "budget: %" PRIu64 " bytes per %" PRIu32 "s level %.0f%% mode %s\n", b->cfg.bytes,
+			b->cfg.periodsec, 100.0 * level, modename[b->mode.load()]);
+	} else {
+		fprintf(fp, "budget: unlimited\n");
+	}
+	fprintf(fp, "budget: sent %" PRIu64 " msgs %" PRIu64 " bytes (%.0f per %" PRIu32 "s) alerts %" PRIu64
+		" bytes refused %" PRIu64 " msgs %" PRIu64 " bytes\n", b->sent.load(), used,
+		up ? (double)used * b->cfg.periodsec * NSPERSEC / up : 0.0, b->cfg.periodsec, b->forcedbytes.load(),
+		b->refused.load(), b->refusedbytes.load());
+	fprintf(fp, "budget: skipped %" PRIu64 " summarised %" PRIu64 " readings in %" PRIu64 " summaries changes %" PRIu64
+		" time raw %.0fs decimate %.0fs summary %.0fs\n", b->skipped.load(), b->summarised.load(), b->summaries.load(),
+		b->changes.load(), (double)modens[DLBUDGET_RAW] / NSPERSEC, (double)modens[DLBUDGET_DECIMATE] / NSPERSEC,
+		(double)modens[DLBUDGET_SUMMARY] / NSPERSEC);
+}
+
+/** @brief Empties a summary
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlsummary_s * s
+ *  @return void
+ */
+void DlSummaryReset(dlsummary_s *s)
+{
+	int i;
+
+	s->n = 0;
+	for (i = 0; i < DLNFIELDS; i++) {
+		s->count[i] = 0;
+	}
+}
+
+/** @brief Folds a reading into the min, max and running mean of each field,
+ *  NaN values are left out
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlsummary_s * s
+ *  @param const reading_s & creads
+ *  @return void
+ */
+void DlSummaryAdd(dlsummary_s *s, const reading_s &creads)
+{
+	float value;
+	int i;
+
+	if (s->n == 0) {
+		s->opened = DlTimeNow();
+		s->first = creads;
+		s->min = creads;
+		s->max = creads;
+		s->mean = creads;
+	}
+	s->last = creads;
+	s->n++;
+	for (i = 0; i < DLNFIELDS; i++) {
+		value = creads.*dlfields[i].member;
+		if (std::isnan(value)) {
+			continue;
+		}
+		if (s->count[i]++ == 0) {
+			s->min.*dlfields[i].member = value;
+			s->max.*dlfields[i].member = value;
+			s->mean.*dlfields[i].member = value;
+			continue;
+		}
+		if (value < s->min.*dlfields[i].member) {
+			s->min.*dlfields[i].member = value;
+		}
+		if (value > s->max.*dlfields[i].member) {
+			s->max.*dlfields[i].member = value;
+		}
+		s->mean.*dlfields[i].member += (value - s->mean.*dlfields[i].member) / s->count[i];
+	}
+}
+
+/** @brief Checks whether a summary has covered summaryms
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlsummary_s * s
+ *  @param uint32_t summaryms
+ *  @return int 1 if the summary should be published
+ */
+int DlSummaryDue(const dlsummary_s *s, uint32_t summaryms)
+{
+	return s->n > 0 && DlTimeNow() - s->opened >= summaryms * NSPERMS;
+}
+
+/** @brief Formats a summary as
+ *  {"serial":"e69836d","t0":ms,"t1":ms,"n":readings,"min":{fields},"max":{fields},"mean":{fields}}
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlsummary_s * s
+ *  @param uint64_t serial unit serial from DlGetSerial
+ *  @param char * jsondata output buffer, SUMMARYSZ
+ *  @param size_t len size of jsondata
+ *  @return int number of characters written, 0 if empty or jsondata is too small
+ */
+int DlFormatSummary(const dlsummary_s *s, uint64_t serial, char *jsondata, size_t len)
+{
+	static const char *key[] = { ",\"min\":", ",\"max\":", ",\"mean\":" };
+	const reading_s *stat[] = { &s->min, &s->max, &s->mean };
+	size_t n;
+	int i, m;
+
+	if (s->n == 0) {
+		return 0;
+	}
+	n = snprintf(jsondata, len, "{\"serial\":\"%" PRIx64 "\",\"t0\":%" PRIu64 ",\"t1\":%" PRIu64 ",\"n\":%" PRIu32,
+		serial, DlTimeEpochMs(s->first.tns, s->first.toffset), DlTimeEpochMs(s->last.tns, s->last.toffset), s->n);
+	for (i = 0; i < 3 && n < len; i++) {
+		n += snprintf(jsondata + n, len - n, "%s", key[i]);
+		m = n < len ? DlFormatFieldObject(*stat[i], jsondata + n, len - n) : 0;
+		if (m == 0) {
+			return 0;
+		}
+		n += m;
+	}
+	if (n + 1 >= len) {
+		return 0;
+	}
+	jsondata[n++] = '}';
+	jsondata[n] = '\0';
+	return (int)n;
+}
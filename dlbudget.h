@@ -0,0 +1,98 @@
+#ifndef DLBUDGET_H
+#define DLBUDGET_H
+/** @file dlbudget.h
+ *  @brief Constants, structures, function prototypes for the uplink byte budget
+ *
+ *  A token bucket refilled at bytes per periodsec, holding at most
+ *  depthsec of refill. The publisher takes the wire size of every message
+ *  from it. Alerts are always sent and may leave the bucket in debt, live
+ *  data needs the bytes to be there and the backlog also leaves
+ *  BUDGETDECIMATEAT of the bucket to live data. As the bucket empties the
+ *  publish stage steps down from raw readings to one in decimate, then to
+ *  a min/max/mean summary every summaryms, and back up with hysteresis.
+ */
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <pthread.h>
+#include "dlformat.h"
+#include "logger.h"
+
+#define BUDGETBYTES 0             ///< Bytes per period, 0 unlimited but still metered
+#define BUDGETPERIODSEC 86400     ///< 60 for a per-minute budget, 86400 per day
+#define BUDGETDEPTHSEC 600        ///< Burst the bucket holds, in seconds of refill
+#define BUDGETMINDEPTH 4096       ///< Large enough for a batch whatever the rate
+#define BUDGETDECIMATE 10         ///< One reading in this many while decimating
+#define BUDGETSUMMARYMS 60000
+#define BUDGETDECIMATEAT 0.50f    ///< Bucket level below which readings are decimated
+#define BUDGETSUMMARYAT 0.20f     ///< Bucket level below which only summaries are sent
+#define BUDGETHYSTERESIS 0.10f    ///< Level above a threshold needed to step back up
+#define BUDGETFORCE -1.0f         ///< DlBudgetTake reserve that always grants
+#define SUMMARYTOPIC "Logger Data/summary"
+#define SUMMARYSZ (96 + 3 * (10 + FIELDOBJECTSZ))
+
+enum dlbudgetmode_e
+{
+	DLBUDGET_RAW,       ///< Every reading
+	DLBUDGET_DECIMATE,  ///< One reading in cfg.decimate
+	DLBUDGET_SUMMARY,   ///< min/max/mean every cfg.summaryms
+	DLBUDGET_COUNT
+};
+
+typedef struct dlbudgetcfg
+{
+	uint64_t bytes;       ///< Bytes per period, 0 unlimited
+	uint32_t periodsec;
+	uint32_t depthsec;    ///< Bucket size in seconds of refill
+	uint32_t decimate;    ///< Reading kept in each run while decimating
+	uint32_t summaryms;   ///< Readings folded into each summary
+} dlbudgetcfg_s;
+
+typedef struct dlbudget
+{
+	dlbudgetcfg_s cfg;
+	pthread_mutex_t lock;           ///< Guards tokens, lastns and the mode times
+	double rate;                    ///< Bytes per ns
+	double depth;                   ///< Bucket size in bytes
+	double tokens;                  ///< Bytes available, negative after alerts in debt
+	uint64_t lastns;                ///< CLOCK_MONOTONIC ns of the last refill
+	uint64_t modens[DLBUDGET_COUNT];  ///< Time spent in each mode
+	std::atomic<int> mode;          ///< dlbudgetmode_e
+	std::atomic<uint64_t> sent;     ///< Messages granted
+	std::atomic<uint64_t> sentbytes;
+	std::atomic<uint64_t> forcedbytes;   ///< Granted whatever the level, alerts
+	std::atomic<uint64_t> refused;       ///< Messages refused, spooled by the caller
+	std::atomic<uint64_t> refusedbytes;
+	std::atomic<uint64_t> skipped;       ///< Readings dropped by decimation
+	std::atomic<uint64_t> summarised;    ///< Readings folded into summaries
+	std::atomic<uint64_t> summaries;
+	std::atomic<uint64_t> changes;       ///< Mode changes
+	uint64_t started;
+} dlbudget_s;
+
+typedef struct dlsummary
+{
+	uint32_t n;          ///< Readings folded in, 0 empty
+	uint32_t count[DLNFIELDS];  ///< Values of each field that were not NaN
+	uint64_t opened;     ///< CLOCK_MONOTONIC ns of the first
+	reading_s first;     ///< Timestamps of the first and last reading
+	reading_s last;
+	reading_s min;
+	reading_s max;
+	reading_s mean;
+} dlsummary_s;
+
+///\cond INTERNAL
+// Function Prototypes
+void DlBudgetInit(dlbudget_s *b, const dlbudgetcfg_s *cfg);
+int DlBudgetTake(dlbudget_s *b, size_t bytes, float reserve);
+void DlBudgetRefund(dlbudget_s *b, size_t bytes);
+dlbudgetmode_e DlBudgetMode(dlbudget_s *b);
+void DlBudgetReport(dlbudget_s *b, FILE *fp);
+void DlSummaryReset(dlsummary_s *s);
+void DlSummaryAdd(dlsummary_s *s, const reading_s &creads);
+int DlSummaryDue(const dlsummary_s *s, uint32_t summaryms);
+int DlFormatSummary(const dlsummary_s *s, uint64_t serial, char *jsondata, size_t len);
+///\endcond
+#endif
@@ -0,0 +1,280 @@
+/** @file dlcbor.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief CBOR encoding and decoding of readings payloads
+ */
+#include "dlcbor.h"
+#include <cmath>
+#include <cstring>
+#include "dlformat.h"
+#include "dltime.h"
+
+/** @brief Writes a CBOR initial byte and its argument in the shortest form
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint8_t * p write position, NULL after an earlier overflow
+ *  @param uint8_t * end end of the buffer
+ *  @param int major CBOR major type 0-7
+ *  @param uint64_t value
+ *  @return uint8_t * new write position, NULL if the buffer is full
+ */
+uint8_t *DlCborPutHead(uint8_t *p, uint8_t *end, int major, uint64_t value)
+{
+	int n, ai, i;
+
+	if (value < 24) {
+		n = 0;
+		ai = (int)value;
+	} else if (value <= 0xFF) {
+		n = 1;
+		ai = 24;
+	} else if (value <= 0xFFFF) {
+		n = 2;
+		ai = 25;
+	} else if (value <= 0xFFFFFFFF) {
+		n = 4;
+		ai = 26;
+	} else {
+		n = 8;
+		ai = 27;
+	}
+	if (p == NULL || end - p < 1 + n) {
+		return NULL;
+	}
+	*p++ = (uint8_t)(major << 5 | ai);
+	for (i = n - 1; i >= 0; i--) {
+		*p++ = (uint8_t)(value >> (8 * i));
+	}
+	return p;
+}
+
+/** @brief Writes a single precision float
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint8_t * p write position, NULL after an earlier overflow
+ *  @param uint8_t * end end of the buffer
+ *  @param float value
+ *  @return uint8_t * new write position, NULL if the buffer is full
+ */
+uint8_t *DlCborPutFloat(uint8_t *p, uint8_t *end, float value)
+{
+	uint32_t bits;
+
+	if (p == NULL || end - p < 5) {
+		return NULL;
+	}
+	memcpy(&bits, &value, 4);
+	*p++ = CBORSIMPLE << 5 | 26;
+	*p++ = bits >> 24;
+	*p++ = bits >> 16;
+	*p++ = bits >> 8;
+	*p++ = bits;
+	return p;
+}
+
+/** @brief Writes the payload header and opens the row list
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint64_t serial unit serial
+ *  @param uint64_t t0ms UTC epoch ms of the first row
+ *  @param uint8_t * buf
+ *  @param size_t len size of buf
+ *  @return size_t bytes written, 0 if buf is too small
+ */
+size_t DlCborBatchHead(uint64_t serial, uint64_t t0ms, uint8_t *buf, size_t len)
+{
+	uint8_t *end = buf + len;
+	uint8_t *p = DlCborPutHead(buf, end, CBORARRAY, 4);
+
+	p = DlCborPutHead(p, end, CBORUINT, CBORVERSION);
+	p = DlCborPutHead(p, end, CBORUINT, serial);
+	p = DlCborPutHead(p, end, CBORUINT, t0ms);
+	if (p == NULL || p == end) {
+		return 0;
+	}
+	*p++ = CBORARRAY << 5 | 31;  // indefinite length, closed by CBORBREAK
+	return p - buf;
+}
+
+/** @brief Writes one reading as a row
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s & creads
+ *  @param uint64_t t0ms UTC epoch ms of the first row
+ *  @param uint8_t * buf
+ *  @param size_t len size of buf
+ *  @return size_t bytes written, 0 if buf is too small
+ */
+size_t DlCborBatchRow(const reading_s &creads, uint64_t t0ms, uint8_t *buf, size_t len)
+{
+	uint8_t *end = buf + len;
+	uint64_t ms = DlTimeEpochMs(creads.tns, creads.toffset);
+	uint8_t *p = DlCborPutHead(buf, end, CBORARRAY, 1 + DLNFIELDS);
+
+	p = DlCborPutHead(p, end, CBORUINT, ms > t0ms ? ms - t0ms : 0);
+	for (const dlfield_s &f : dlfields) {
+		p = DlCborPutFloat(p, end, creads.*f.member);
+	}
+	return p ? p - buf : 0;
+}
+
+/** @brief Reads a CBOR initial byte and its argument
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const uint8_t * p
+ *  @param const uint8_t * end
+ *  @param int * major receives the major type
+ *  @param int * ai receives the additional information, 31 for indefinite length
+ *  @param uint64_t * value receives the argument
+ *  @return const uint8_t * next item, NULL if truncated or malformed
+ */
+static const uint8_t *DlCborGetHead(const uint8_t *p, const uint8_t *end, int *major, int *ai, uint64_t *value)
+{
+	int n, i;
+
+	if (p == NULL || p >= end) {
+		return NULL;
+	}
+	*major = *p >> 5;
+	*ai = *p & 31;
+	p++;
+	*value = 0;
+	if (*ai < 24 || *ai == 31) {
+		*value = *ai < 24 ? *ai : 0;
+		return p;
+	}
+	if (*ai > 27) {
+		return NULL;
+	}
+	n = 1 << (*ai - 24);
+	if (end - p < n) {
+		return NULL;
+	}
+	for (i = 0; i < n; i++) {
+		*value = *value << 8 | *p++;
+	}
+	return p;
+}
+
+/** @brief Reads a number of any CBOR numeric encoding, null is NaN
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const uint8_t * p
+ *  @param const uint8_t * end
+ *  @param double * out
+ *  @return const uint8_t * next item, NULL if this is not a number
+ */
+static const uint8_t *DlCborGetNumber(const uint8_t *p, const uint8_t *end, double *out)
+{
+	uint64_t value;
+	uint32_t bits32;
+	float f;
+	int major, ai, exp, mant;
+
+	p = DlCborGetHead(p, end, &major, &ai, &value);
+	if (p == NULL) {
+		return NULL;
+	}
+	if (major == CBORUINT) {
+		*out = (double)value;
+	} else if (major == CBORNEGINT) {
+		*out = -1.0 - (double)value;
+	} else if (major == CBORSIMPLE && ai == 25) {
+		exp = (value >> 10) & 0x1F;
+		mant = value & 0x3FF;
+		*out = exp == 0 ? ldexp(mant, -24) : exp != 31 ? ldexp(mant + 1024, exp - 25) : mant ? NAN : INFINITY;
+		if (value & 0x8000) {
+			*out = -*out;
+		}
+	} else if (major == CBORSIMPLE && ai == 26) {
+		bits32 = (uint32_t)value;
+		memcpy(&f, &bits32, 4);
+		*out = f;
+	} else if (major == CBORSIMPLE && ai == 27) {
+		memcpy(out, &value, 8);
+	} else if (major == CBORSIMPLE && (ai == 22 || ai == 23)) {
+		*out = NAN;  // null, undefined
+	} else {
+		return NULL;
+	}
+	return p;
+}
+
+/** @brief Decodes one payload into readings. tns holds the UTC time and
+ *  toffset is 0, so DlTimeEpochMs gives back the epoch ms.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const uint8_t * buf
+ *  @param size_t len bytes available, may hold further payloads
+ *  @param size_t * used receives the bytes of this payload
+ *  @param uint64_t * serial receives the unit serial
+ *  @param reading_s * rows receives the readings
+ *  @param int max size of rows
+ *  @return int readings decoded, -1 if malformed, of another version or over max rows
+ */
+int DlCborDecodeBatch(const uint8_t *buf, size_t len, size_t *used, uint64_t *serial, reading_s *rows, int max)
+{
+	const uint8_t *end = buf + len;
+	const uint8_t *p = buf;
+	uint64_t value, t0, nrows = 0, ncols;
+	double number;
+	int major, ai, indefinite;
+	int count = 0;
+	uint64_t i;
+	int k;
+
+	p = DlCborGetHead(p, end, &major, &ai, &value);
+	if (p == NULL || major != CBORARRAY || value != 4) {
+		return -1;
+	}
+	p = DlCborGetHead(p, end, &major, &ai, &value);
+	if (p == NULL || major != CBORUINT || value != CBORVERSION) {
+		return -1;
+	}
+	p = DlCborGetHead(p, end, &major, &ai, serial);
+	if (p == NULL || major != CBORUINT) {
+		return -1;
+	}
+	p = DlCborGetHead(p, end, &major, &ai, &t0);
+	if (p == NULL || major != CBORUINT) {
+		return -1;
+	}
+	p = DlCborGetHead(p, end, &major, &ai, &nrows);
+	if (p == NULL || major != CBORARRAY) {
+		return -1;
+	}
+	indefinite = ai == 31;
+	while (indefinite || (uint64_t)count < nrows) {
+		if (p >= end) {
+			return -1;
+		}
+		if (indefinite && *p == CBORBREAK) {
+			p++;
+			break;
+		}
+		p = DlCborGetHead(p, end, &major, &ai, &ncols);
+		if (p == NULL || major != CBORARRAY || ai == 31 || ncols < 1 + DLNFIELDS || count >= max) {
+			return -1;
+		}
+		memset(&rows[count], 0, sizeof(rows[count]));
+		p = DlCborGetHead(p, end, &major, &ai, &value);
+		if (p == NULL || major != CBORUINT) {
+			return -1;
+		}
+		rows[count].tns = (t0 + value) * NSPERMS;
+		for (k = 0; k < DLNFIELDS; k++) {
+			if ((p = DlCborGetNumber(p, end, &number)) == NULL) {
+				return -1;
+			}
+			rows[count].*dlfields[k].member = (float)number;
+		}
+		for (i = 1 + DLNFIELDS; i < ncols; i++) {
+			if ((p = DlCborGetNumber(p, end, &number)) == NULL) {  // fields added by a newer unit
+				return -1;
+			}
+		}
+		count++;
+	}
+	*used = p - buf;
+	return count;
+}
@@ -0,0 +1,36 @@
+#ifndef DLCBOR_H
+#define DLCBOR_H
+/** @file dlcbor.h
+ *  @brief Constants, function prototypes for the CBOR (RFC 8949) readings payload
+ *
+ *  One payload carries one or more readings, the shared fields once:
+ *
+ *  [version, serial, t0, [_ [dt, f32, f32, ...], [dt, f32, ...], ... ]]
+ *
+ *  t0 is the UTC epoch ms of the first row, dt the ms after it and the
+ *  floats follow DLREADINGFIELDS order. The row list is an indefinite
+ *  length array so rows can be appended as readings arrive. A NaN value
+ *  is sent as a NaN float and comes back as null in JSON.
+ */
+#include <cinttypes>
+#include <cstddef>
+#include "logger.h"
+
+#define CBORVERSION 1
+#define CBORROWSZ (1 + 9 + DLNFIELDS * 5)  ///< Longest encoded row
+#define CBORHDRSZ 32                        ///< Longest payload header
+#define CBORUINT 0
+#define CBORNEGINT 1
+#define CBORARRAY 4
+#define CBORSIMPLE 7
+#define CBORBREAK 0xFF
+
+///\cond INTERNAL
+// Function Prototypes
+uint8_t *DlCborPutHead(uint8_t *p, uint8_t *end, int major, uint64_t value);
+uint8_t *DlCborPutFloat(uint8_t *p, uint8_t *end, float value);
+size_t DlCborBatchHead(uint64_t serial, uint64_t t0ms, uint8_t *buf, size_t len);
+size_t DlCborBatchRow(const reading_s &creads, uint64_t t0ms, uint8_t *buf, size_t len);
+int DlCborDecodeBatch(const uint8_t *buf, size_t len, size_t *used, uint64_t *serial, reading_s *rows, int max);
+///\endcond
+#endif
@@ -0,0 +1,281 @@
+/** @file dlchannel.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Multi-rate sensor channels and the snapshot merge stage
+ */
+#include "dlchannel.h"
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include "dlalert.h"
+#include "dlpipeline.h"
+
+#if SENSEHAT == 1
+#include "sensehat.h"
+extern SenseHat Sh;
+#endif
+
+static dlchannel_s channel[DLCH_COUNT] = {
+	{ "env", ENVPERIODMS, 0, 0 },
+	{ "imu", IMUPERIODMS, 0, 0 },
+	{ "gps", GPSPERIODMS, 0, 0 },
+};
+
+// Newest record of each channel, the IMU keeps a short history for alignment
+static envrecord_s envlast;
+static gpsrecord_s gpslast;
+static imurecord_s imuhist[IMUHISTORYSZ];
+static uint64_t imuhead = 0;
+
+/** @brief Sets the sampling period of a channel, call before DlChannelAttach
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int ch dlchannelid_e
+ *  @param uint32_t periodms
+ *  @return void
+ */
+void DlChannelSetRate(int ch, uint32_t periodms)
+{
+	if (ch >= 0 && ch < DLCH_COUNT && periodms > 0) {
+		channel[ch].periodms = periodms;
+	}
+}
+
+/** @brief Scheduler task, reads the slow environmental sensors
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg dlchannel_s
+ *  @return void
+ */
+static void DlChannelEnvTask(void *arg)
+{
+	dlchannel_s *ch = (dlchannel_s *)arg;
+	envrecord_s rec;
+
+	rec.tns = DlTimeNow();
+#if SENSEHAT == 1
+	rec.temperature = Sh.GetTemperature();
+	rec.humidity = Sh.GetHumidity();
+	rec.pressure = Sh.GetPressure();
+#else
+	rec.temperature = DTEMP;
+	rec.humidity = DHUMID;
+	rec.pressure = DPRESS;
+#endif
+	envlast = rec;
+	ch->records++;
+	ch->lasttns = rec.tns;
+}
+
+/** @brief Adds one IMU record to the alignment history and checks it for
+ *  a driving event, every sample is checked, not only the snapshots
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlchannel_s * ch IMU channel
+ *  @param const imurecord_s & rec
+ *  @return void
+ */
+static void DlChannelImuRecord(dlchannel_s *ch, const imurecord_s &rec)
+{
+	dlalert_s alert;
+
+	if (DlAlertCheck(rec.tns, rec.xa, rec.ya, rec.za, &alert)) {
+		DlPipelineAlert(alert);
+	}
+	imuhist[imuhead % IMUHISTORYSZ] = rec;
+	imuhead++;
+	ch->records++;
+	ch->lasttns = rec.tns;
+}
+
+/** @brief Scheduler task, collects every IMU sample read since the last run
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg dlchannel_s
+ *  @return void
+ */
+static void DlChannelImuTask(void *arg)
+{
+	dlchannel_s *ch = (dlchannel_s *)arg;
+	imurecord_s rec;
+#if SENSEHAT == 1
+	imusample_t batch[IMUBATCHSZ];
+	size_t n, i;
+
+	if (Sh.GetImuSnapshot(batch[0])) {
+		// IMU thread running, take every sample queued since the last run
+		while ((n = Sh.GetImuSamples(batch, IMUBATCHSZ)) > 0) {
+			for (i = 0; i < n; i++) {
+				rec.tns = batch[i].tns;
+				rec.xa = batch[i].ax;
+				rec.ya = batch[i].ay;
+				rec.za = batch[i].az;
+				rec.pitch = batch[i].gx;
+				rec.roll = batch[i].gy;
+				rec.yaw = batch[i].gz;
+				rec.xm = batch[i].mx;
+				rec.ym = batch[i].my;
+				rec.zm = batch[i].mz;
+				DlChannelImuRecord(ch, rec);
+			}
+		}
+		return;
+	}
+	rec.tns = DlTimeNow();
+	Sh.GetAcceleration(rec.xa, rec.ya, rec.za);
+	Sh.GetOrientation(rec.pitch, rec.roll, rec.yaw);
+	Sh.GetMagnetism(rec.xm, rec.ym, rec.zm);
+#else
+	rec.tns = DlTimeNow();
+	rec.xa = DXA;
+	rec.ya = DYA;
+	rec.za = DZA;
+	rec.pitch = DPITCH;
+	rec.roll = DROLL;
+	rec.yaw = DYAW;
+	rec.xm = DXM;
+	rec.ym = DYM;
+	rec.zm = DZM;
+#endif
+	DlChannelImuRecord(ch, rec);
+}
+
+/** @brief Scheduler task, takes the latest GPS fix from the service
+ *  thread's cell, never waits on the receiver
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg dlchannel_s
+ *  @return void
+ */
+static void DlChannelGpsTask(void *arg)
+{
+	dlchannel_s *ch = (dlchannel_s *)arg;
+#if GPSDEVICE == 1
+	dlgpsfix_s fix = DlGpsFix();
+
+	gpslast.tns = fix.tns;
+	gpslast.loc = fix.loc;
+	gpslast.mode = fix.mode;
+#else
+	gpslast.tns = DlTimeNow();
+	gpslast.mode = DLGPS_3D;
+	gpslast.loc.latitude = DLAT;
+	gpslast.loc.longitude = DLONG;
+	gpslast.loc.altitude = DALT;
+	gpslast.loc.speed = DSPEED;
+	gpslast.loc.course = DHEADING;
+#endif
+	ch->records++;
+	ch->lasttns = gpslast.tns;
+}
+
+/** @brief Registers one scheduler task per channel at the channel's period
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlsched_s * sched
+ *  @return int 1 on success, 0 if the scheduler is full
+ */
+int DlChannelAttach(dlsched_s *sched)
+{
+	static const dltaskfn_t task[DLCH_COUNT] = { DlChannelEnvTask, DlChannelImuTask, DlChannelGpsTask };
+	int i;
+
+	for (i = 0; i < DLCH_COUNT; i++) {
+		if (DlSchedAddTask(sched, channel[i].name, channel[i].periodms, task[i], &channel[i]) == -1) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/** @brief Finds the IMU record closest in time to tns
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint64_t tns
+ *  @return const imurecord_s * NULL if there are no records
+ */
+static const imurecord_s *DlChannelImuAt(uint64_t tns)
+{
+	const imurecord_s *best = NULL;
+	uint64_t i, n, dt, bestdt = UINT64_MAX;
+
+	n = imuhead < IMUHISTORYSZ ? imuhead : IMUHISTORYSZ;
+	for (i = 1; i <= n; i++) {
+		const imurecord_s *rec = &imuhist[(imuhead - i) % IMUHISTORYSZ];
+		dt = rec->tns > tns ? rec->tns - tns : tns - rec->tns;
+		if (dt > bestdt) {
+			break;  // history is in time order, moving away from tns now
+		}
+		bestdt = dt;
+		best = rec;
+	}
+	return best;
+}
+
+/** @brief Merge stage, builds a reading from every channel aligned on tns.
+ *  The IMU record nearest to tns is used, the slower channels contribute
+ *  their newest record.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint64_t tns CLOCK_MONOTONIC ns, usually DlTimeNow()
+ *  @return struct reading_s
+ */
+reading_s DlChannelSnapshot(uint64_t tns)
+{
+	reading_s creads;
+	const imurecord_s *imu = DlChannelImuAt(tns);
+
+	memset(&creads, 0, sizeof(creads));
+	creads.tns = tns;
+	creads.toffset = DlTimeOffset();
+	creads.temperature = envlast.temperature;
+	creads.humidity = envlast.humidity;
+	creads.pressure = envlast.pressure;
+	if (imu != NULL) {
+		creads.xa = imu->xa;
+		creads.ya = imu->ya;
+		creads.za = imu->za;
+		creads.pitch = imu->pitch;
+		creads.roll = imu->roll;
+		creads.yaw = imu->yaw;
+		creads.xm = imu->xm;
+		creads.ym = imu->ym;
+		creads.zm = imu->zm;
+	}
+	if (gpslast.mode >= DLGPS_2D && gpslast.tns + GPSSTALEMS * NSPERMS >= tns) {
+		creads.latitude = gpslast.loc.latitude;
+		creads.longitude = gpslast.loc.longitude;
+		creads.altitude = gpslast.mode == DLGPS_3D ? gpslast.loc.altitude : NAN;
+		creads.speed = gpslast.loc.speed;
+		creads.heading = gpslast.loc.course;
+	} else {
+		// no fix, or the receiver has gone quiet, do not repeat an old position
+		creads.latitude = NAN;
+		creads.longitude = NAN;
+		creads.altitude = NAN;
+		creads.speed = NAN;
+		creads.heading = NAN;
+	}
+	return creads;
+}
+
+/** @brief Prints the rate and freshness of every channel
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param FILE * fp
+ *  @return void
+ */
+void DlChannelReport(FILE *fp)
+{
+	uint64_t now = DlTimeNow();
+	int i;
+
+	fprintf(fp, "%-10s %8s %10s %10s\n", "channel", "period", "records", "age");
+	for (i = 0; i < DLCH_COUNT; i++) {
+		fprintf(fp, "%-10s %6" PRIu32 "ms %10" PRIu64 " %8.1fms\n", channel[i].name, channel[i].periodms,
+			channel[i].records, channel[i].lasttns ? (double)(now - channel[i].lasttns) / NSPERMS : 0.0);
+	}
+#if SENSEHAT == 1
+	fprintf(fp, "imu samples dropped %" PRIu64 "\n", Sh.GetImuDropped());
+#endif
+}
@@ -0,0 +1,70 @@
+#ifndef DLCHANNEL_H
+#define DLCHANNEL_H
+/** @file dlchannel.h
+ *  @brief Constants, structures, function prototypes for multi-rate sensor channels
+ *
+ *  Each sensor source is sampled by its own scheduler task at its own rate
+ *  and keeps timestamped records. DlChannelSnapshot merges the channels into
+ *  one reading_s aligned on a requested time for the CSV/JSON/MQTT outputs.
+ */
+#include <cinttypes>
+#include <cstdio>
+#include "dlgps.h"
+#include "dlsched.h"
+#include "dltime.h"
+#include "logger.h"
+
+// Default channel periods in milliseconds
+#define ENVPERIODMS 1000
+#define IMUPERIODMS 10
+#define GPSPERIODMS 200
+#define IMUHISTORYSZ 256
+#define IMUBATCHSZ 32
+
+enum dlchannelid_e
+{
+	DLCH_ENV,   ///< HTS221/LPS25H temperature, humidity, pressure
+	DLCH_IMU,   ///< LSM9DS1 accel, gyro, compass
+	DLCH_GPS,   ///< GPS fix
+	DLCH_COUNT
+};
+
+typedef struct envrecord
+{
+	uint64_t tns;       ///< CLOCK_MONOTONIC time of the read, ns
+	float temperature;  ///< Degrees Celsius
+	float humidity;     ///< Per cent relative humidity
+	float pressure;     ///< Kilo Pascals
+} envrecord_s;
+
+typedef struct imurecord
+{
+	uint64_t tns;       ///< CLOCK_MONOTONIC time of the read, ns
+	float xa, ya, za;   ///< Acceleration g
+	float pitch, roll, yaw; ///< Gyro axes
+	float xm, ym, zm;   ///< Micro Teslas
+} imurecord_s;
+
+typedef struct gpsrecord
+{
+	uint64_t tns;       ///< CLOCK_MONOTONIC time the receiver reported the fix, ns
+	loc_t loc;          ///< Location
+	dlgpsmode_e mode;   ///< Fix quality, position is only used from DLGPS_2D
+} gpsrecord_s;
+
+typedef struct dlchannel
+{
+	const char *name;   ///< Channel name for reports
+	uint32_t periodms;  ///< Sampling period
+	uint64_t records;   ///< Records produced
+	uint64_t lasttns;   ///< Time of the newest record
+} dlchannel_s;
+
+///\cond INTERNAL
+// Function Prototypes
+void DlChannelSetRate(int ch, uint32_t periodms);
+int DlChannelAttach(dlsched_s *sched);
+reading_s DlChannelSnapshot(uint64_t tns);
+void DlChannelReport(FILE *fp);
+///\endcond
+#endif
@@ -0,0 +1,86 @@
+/** @file dldeadband.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Deadband and heartbeat filter for per-channel publishing
+ */
+#include "dldeadband.h"
+#include <cmath>
+#include "dlformat.h"
+#include "dltime.h"
+
+/** @brief Sets up a filter that reports every channel on its next value
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dldeadband_s * d
+ *  @param const dldeadbandcfg_s * cfg NULL for the defaults
+ *  @return void
+ */
+void DlDeadbandInit(dldeadband_s *d, const dldeadbandcfg_s *cfg)
+{
+	int i;
+
+	d->cfg.heartbeatms = cfg ? cfg->heartbeatms : DEADBANDHEARTBEATMS;
+	d->cfg.scale = cfg ? cfg->scale : DEADBANDSCALE;
+	for (i = 0; i < DLNFIELDS; i++) {
+		d->last[i] = NAN;
+		d->lastns[i] = 0;
+	}
+	d->checked = 0;
+	d->reported = 0;
+	d->heartbeats = 0;
+}
+
+/** @brief Decides whether a channel value is reported and remembers it if so
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dldeadband_s * d
+ *  @param int field index in dlfields
+ *  @param float value
+ *  @param uint64_t now CLOCK_MONOTONIC ns
+ *  @return int 1 to publish the value
+ */
+int DlDeadbandUpdate(dldeadband_s *d, int field, float value, uint64_t now)
+{
+	const dlfield_s &f = dlfields[field];
+	float last = d->last[field];
+	float band;
+	bool report;
+
+	d->checked++;
+	if (d->lastns[field] == 0 || std::isnan(value) != std::isnan(last)) {
+		report = true;
+	} else if (std::isnan(value)) {
+		report = false;
+	} else {
+		band = f.absdb;
+		if (f.reldb * fabsf(last) > band) {
+			band = f.reldb * fabsf(last);
+		}
+		report = fabsf(value - last) > band * d->cfg.scale;
+	}
+	if (!report && d->cfg.heartbeatms && now - d->lastns[field] >= d->cfg.heartbeatms * NSPERMS) {
+		report = true;
+		d->heartbeats++;
+	}
+	if (report) {
+		d->last[field] = value;
+		d->lastns[field] = now;
+		d->reported++;
+	}
+	return report;
+}
+
+/** @brief Prints how many channel values were reported and suppressed
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dldeadband_s * d
+ *  @param FILE * fp
+ *  @return void
+ */
+void DlDeadbandReport(const dldeadband_s *d, FILE *fp)
+{
+	uint64_t checked = d->checked.load(), reported = d->reported.load();
+
+	fprintf(fp, "deadband: values %" PRIu64 " reported %" PRIu64 " (%.1f%%) heartbeats %" PRIu64 "\n", checked, reported,
+		checked ? 100.0 * reported / checked : 0.0, d->heartbeats.load());
+}
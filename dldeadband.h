@@ -0,0 +1,42 @@
+#ifndef DLDEADBAND_H
+#define DLDEADBAND_H
+/** @file dldeadband.h
+ *  @brief Constants, structures, function prototypes for report-by-exception channels
+ *
+ *  Each field of a reading is reported on its own only when it has moved
+ *  by more than its deadband since it was last reported, or when the
+ *  heartbeat expires. The deadbands come from DLREADINGFIELDS: the
+ *  absolute band, or the relative band times the last reported value if
+ *  that is larger, both multiplied by scale.
+ */
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include "logger.h"
+
+#define DEADBANDHEARTBEATMS 60000
+#define DEADBANDSCALE 1.0f
+
+typedef struct dldeadbandcfg
+{
+	uint32_t heartbeatms;  ///< Report an unchanged channel this often, 0 never
+	float scale;           ///< Multiplies every deadband, 0 reports every change
+} dldeadbandcfg_s;
+
+typedef struct dldeadband
+{
+	dldeadbandcfg_s cfg;
+	float last[DLNFIELDS];        ///< Value last reported
+	uint64_t lastns[DLNFIELDS];   ///< CLOCK_MONOTONIC ns it was reported, 0 never
+	std::atomic<uint64_t> checked;     ///< Field values seen
+	std::atomic<uint64_t> reported;    ///< Field values reported
+	std::atomic<uint64_t> heartbeats;  ///< Reported only because the heartbeat expired
+} dldeadband_s;
+
+///\cond INTERNAL
+// Function Prototypes
+void DlDeadbandInit(dldeadband_s *d, const dldeadbandcfg_s *cfg);
+int DlDeadbandUpdate(dldeadband_s *d, int field, float value, uint64_t now);
+void DlDeadbandReport(const dldeadband_s *d, FILE *fp);
+///\endcond
+#endif
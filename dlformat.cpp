@@ -0,0 +1,276 @@
+/** @file dlformat.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Text layouts of a reading shared by the logger, MQTT and vdl-export
+ */
+#include "dlformat.h"
+#include <charconv>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+#include "dltime.h"
+
+#define DLFIELDDESC(name, decimals, label, unit, newline, absdb, reldb, desc) \
+	{ #name, &reading_s::name, decimals, label, unit, newline, absdb, reldb },
+
+const dlfield_s dlfields[DLNFIELDS] = { DLREADINGFIELDS(DLFIELDDESC) };
+
+static const uint64_t decscale[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+/** @brief Appends a string
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param char * p write position, NULL after an earlier overflow
+ *  @param char * end end of the buffer
+ *  @param const char * s
+ *  @return char * new write position, NULL if the buffer is full
+ */
+static char *DlPutStr(char *p, char *end, const char *s)
+{
+	size_t n = strlen(s);
+
+	if (p == NULL || (size_t)(end - p) < n) {
+		return NULL;
+	}
+	memcpy(p, s, n);
+	return p + n;
+}
+
+/** @brief Appends an unsigned integer
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param char * p write position, NULL after an earlier overflow
+ *  @param char * end end of the buffer
+ *  @param uint64_t value
+ *  @return char * new write position, NULL if the buffer is full
+ */
+static char *DlPutU64(char *p, char *end, uint64_t value)
+{
+	std::to_chars_result r;
+
+	if (p == NULL) {
+		return NULL;
+	}
+	r = std::to_chars(p, end, value);
+	return r.ec == std::errc() ? r.ptr : NULL;
+}
+
+/** @brief Appends a float with a fixed number of decimals, rounded like %.Nf.
+ *  The value is scaled to an integer so only integer to_chars is needed.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param char * p write position, NULL after an earlier overflow
+ *  @param char * end end of the buffer
+ *  @param float value
+ *  @param int decimals 0 to 6
+ *  @param const char * nan written for NaN, infinities and out of range values
+ *  @return char * new write position, NULL if the buffer is full
+ */
+static char *DlPutFixed(char *p, char *end, float value, int decimals, const char *nan)
+{
+	double v = value;
+	uint64_t units;
+	uint64_t frac;
+	int i;
+
+	if (p == NULL || end - p < FIELDMAXSZ) {
+		return NULL;
+	}
+	if (!std::isfinite(v) || std::fabs(v) >= FIELDMAXABS) {
+		return DlPutStr(p, end, nan);
+	}
+	if (v < 0) {
+		*p++ = '-';
+		v = -v;
+	}
+	units = (uint64_t)std::llround(v * decscale[decimals]);
+	p = std::to_chars(p, end, units / decscale[decimals]).ptr;
+	if (decimals > 0) {
+		*p++ = '.';
+		frac = units % decscale[decimals];
+		for (i = decimals; i > 0; i--) {
+			p[i - 1] = '0' + frac % 10;
+			frac /= 10;
+		}
+		p += decimals;
+	}
+	return p;
+}
+
+/** @brief Formats a reading as one line of the .csv log
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s & creads
+ *  @param char * csvdata output buffer
+ *  @param size_t len size of csvdata
+ *  @return int number of characters written, 0 if csvdata is too small
+ */
+int DlFormatLoggerCsv(const reading_s &creads, char *csvdata, size_t len) {
+	char *end = csvdata + len - 1;
+	char *p = DlPutU64(csvdata, end, DlTimeEpochMs(creads.tns, creads.toffset));
+
+	for (const dlfield_s &f : dlfields) {
+		p = DlPutStr(p, end, ",");
+		p = DlPutFixed(p, end, creads.*f.member, f.decimals, "nan");
+	}
+	p = DlPutStr(p, end, "\n");
+	if (p == NULL) {
+		return 0;
+	}
+	*p = '\0';
+	return (int)(p - csvdata);
+}
+
+/** @brief Formats a reading as the JSON payload used by the .json log and MQTT
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s & creads
+ *  @param char * jsondata output buffer
+ *  @param size_t len size of jsondata
+ *  @return int number of characters written, 0 if jsondata is too small
+ */
+int DlFormatLoggerJson(const reading_s &creads, char *jsondata, size_t len) {
+	char *end = jsondata + len - 1;
+	char *p = DlPutStr(jsondata, end, "{\"time\":");
+
+	p = DlPutU64(p, end, DlTimeEpochMs(creads.tns, creads.toffset));
+	for (const dlfield_s &f : dlfields) {
+		p = DlPutStr(p, end, ",\"");
+		p = DlPutStr(p, end, f.name);
+		p = DlPutStr(p, end, "\":");
+		p = DlPutFixed(p, end, creads.*f.member, f.decimals, "null");
+	}
+	p = DlPutStr(p, end, ",\"active\": true}");
+	if (p == NULL) {
+		return 0;
+	}
+	*p = '\0';
+	return (int)(p - jsondata);
+}
+
+/** @brief Formats the fields of a reading for the console
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s & creads
+ *  @param char * text output buffer
+ *  @param size_t len size of text
+ *  @return int number of characters written, 0 if text is too small
+ */
+int DlFormatLoggerText(const reading_s &creads, char *text, size_t len) {
+	char *end = text + len - 1;
+	char *p = text;
+
+	for (const dlfield_s &f : dlfields) {
+		p = DlPutStr(p, end, f.label);
+		p = DlPutStr(p, end, ": ");
+		p = DlPutFixed(p, end, creads.*f.member, f.decimals, "nan");
+		p = DlPutStr(p, end, f.unit);
+		p = DlPutStr(p, end, f.newline ? "\n" : " \t");
+	}
+	if (p == NULL) {
+		return 0;
+	}
+	*p = '\0';
+	return (int)(p - text);
+}
+
+/** @brief Formats the fields of a reading as one JSON object, for summaries
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s & creads
+ *  @param char * jsondata output buffer
+ *  @param size_t len size of jsondata
+ *  @return int number of characters written, 0 if jsondata is too small
+ */
+int DlFormatFieldObject(const reading_s &creads, char *jsondata, size_t len) {
+	char *end = jsondata + len - 1;
+	char *p = DlPutStr(jsondata, end, "{");
+
+	for (const dlfield_s &f : dlfields) {
+		p = DlPutStr(p, end, p == jsondata + 1 ? "\"" : ",\"");
+		p = DlPutStr(p, end, f.name);
+		p = DlPutStr(p, end, "\":");
+		p = DlPutFixed(p, end, creads.*f.member, f.decimals, "null");
+	}
+	p = DlPutStr(p, end, "}");
+	if (p == NULL) {
+		return 0;
+	}
+	*p = '\0';
+	return (int)(p - jsondata);
+}
+
+/** @brief Lists the field names as JSON strings, for the batch header
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param char * names output buffer
+ *  @param size_t len size of names
+ *  @return int number of characters written, 0 if names is too small
+ */
+int DlFormatFieldNames(char *names, size_t len) {
+	char *end = names + len - 1;
+	char *p = DlPutStr(names, end, "\"dt\"");
+
+	for (const dlfield_s &f : dlfields) {
+		p = DlPutStr(p, end, ",\"");
+		p = DlPutStr(p, end, f.name);
+		p = DlPutStr(p, end, "\"");
+	}
+	if (p == NULL) {
+		return 0;
+	}
+	*p = '\0';
+	return (int)(p - names);
+}
+
+/** @brief Formats a reading as one row of a batch, milliseconds after the
+ *  first reading of the batch then the field values
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s & creads
+ *  @param uint64_t t0ms UTC epoch ms of the first reading in the batch
+ *  @param char * row output buffer
+ *  @param size_t len size of row
+ *  @return int number of characters written, 0 if row is too small
+ */
+int DlFormatBatchRow(const reading_s &creads, uint64_t t0ms, char *row, size_t len) {
+	char *end = row + len - 1;
+	uint64_t ms = DlTimeEpochMs(creads.tns, creads.toffset);
+	char *p = DlPutStr(row, end, "[");
+
+	p = DlPutU64(p, end, ms > t0ms ? ms - t0ms : 0);
+	for (const dlfield_s &f : dlfields) {
+		p = DlPutStr(p, end, ",");
+		p = DlPutFixed(p, end, creads.*f.member, f.decimals, "null");
+	}
+	p = DlPutStr(p, end, "]");
+	if (p == NULL) {
+		return 0;
+	}
+	*p = '\0';
+	return (int)(p - row);
+}
+
+/** @brief Formats one field of a reading as the payload of its channel topic
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s & creads
+ *  @param int field index in dlfields
+ *  @param char * jsondata output buffer
+ *  @param size_t len size of jsondata
+ *  @return int number of characters written, 0 if jsondata is too small
+ */
+int DlFormatChannel(const reading_s &creads, int field, char *jsondata, size_t len) {
+	char *end = jsondata + len - 1;
+	char *p = DlPutStr(jsondata, end, "{\"time\":");
+
+	p = DlPutU64(p, end, DlTimeEpochMs(creads.tns, creads.toffset));
+	p = DlPutStr(p, end, ",\"value\":");
+	p = DlPutFixed(p, end, creads.*dlfields[field].member, dlfields[field].decimals, "null");
+	p = DlPutStr(p, end, "}");
+	if (p == NULL) {
+		return 0;
+	}
+	*p = '\0';
+	return (int)(p - jsondata);
+}
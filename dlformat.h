@@ -0,0 +1,41 @@
+#ifndef DLFORMAT_H
+#define DLFORMAT_H
+/** @file dlformat.h
+ *  @brief Field descriptors and function prototypes for the reading layouts
+ *
+ *  dlfields is generated from DLREADINGFIELDS in logger.h. The formatters
+ *  walk it and never allocate; numbers are written with std::to_chars.
+ */
+#include <cstddef>
+#include "logger.h"
+
+#define FIELDMAXSZ 24         ///< Longest formatted value, sign, 12 digits, point, 6 decimals
+#define FIELDMAXABS 1e12      ///< Larger values are written as not a number
+#define BATCHROWSZ (24 + DLNFIELDS * (FIELDMAXSZ + 1))  ///< Longest batch row
+#define FIELDOBJECTSZ (2 + DLNFIELDS * (FIELDMAXSZ + 24))  ///< Longest DlFormatFieldObject, names up to 20 characters
+
+typedef struct dlfield
+{
+	const char *name;          ///< Key in the JSON and the binary header
+	float reading_s::*member;  ///< Value in reading_s
+	int decimals;              ///< Digits after the decimal point
+	const char *label;         ///< Console label
+	const char *unit;          ///< Console unit suffix
+	int newline;               ///< Console line ends after this field
+	float absdb;               ///< Change that is reported on the channel topic
+	float reldb;               ///< Same as a fraction of the last reported value, 0 off
+} dlfield_s;
+
+extern const dlfield_s dlfields[DLNFIELDS];
+
+///\cond INTERNAL
+// Function Prototypes
+int DlFormatLoggerCsv(const reading_s &creads, char *csvdata, size_t len);
+int DlFormatLoggerJson(const reading_s &creads, char *jsondata, size_t len);
+int DlFormatLoggerText(const reading_s &creads, char *text, size_t len);
+int DlFormatFieldObject(const reading_s &creads, char *jsondata, size_t len);
+int DlFormatFieldNames(char *names, size_t len);
+int DlFormatBatchRow(const reading_s &creads, uint64_t t0ms, char *row, size_t len);
+int DlFormatChannel(const reading_s &creads, int field, char *jsondata, size_t len);
+///\endcond
+#endif
@@ -0,0 +1,272 @@
+/** @file dlgnss.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief GNSS receiver baud, sentence and rate configuration, fix rate measurement
+ */
+#include "dlgnss.h"
+#include <cstring>
+#include <unistd.h>
+#include "dltime.h"
+#include "dlubx.h"
+#include "serial.h"
+
+/** @brief Sets up the receiver settings and an empty measurement
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlgnss_s * g
+ *  @param const dlgnsscfg_s * cfg NULL for GNSSPROTO, GNSSBAUD and GNSSRATEHZ, ratehz is clamped to 1 to GNSSRATEMAX
+ *  @return void
+ */
+void DlGnssInit(dlgnss_s *g, const dlgnsscfg_s *cfg)
+{
+	g->cfg.proto = cfg ? cfg->proto : GNSSPROTO;
+	g->cfg.baud = cfg ? cfg->baud : GNSSBAUD;
+	g->cfg.ratehz = cfg ? cfg->ratehz : GNSSRATEHZ;
+	g->cfg.lowlatency = cfg ? cfg->lowlatency : true;
+	g->cfg.pvt = cfg ? cfg->pvt && cfg->proto == DLGNSS_UBX : GNSSPVT && GNSSPROTO == DLGNSS_UBX;
+	if (g->cfg.ratehz < 1) {
+		g->cfg.ratehz = 1;
+	}
+	if (g->cfg.ratehz > GNSSRATEMAX) {
+		g->cfg.ratehz = GNSSRATEMAX;
+	}
+	g->configured = 0;
+	g->windowns = 0;
+	g->windowepochs = 0;
+	g->lastutcms = UINT32_MAX;
+	g->checked = false;
+	g->ratemhz = 0;
+	g->sentences = 0;
+	g->epochs = 0;
+	g->commands = 0;
+	g->shortfalls = 0;
+}
+
+/** @brief Queues a PMTK sentence, the '$', checksum and line end are added
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * body e.g. "PMTK220,100"
+ *  @return int 0, -1 if the port refused it
+ */
+int DlGnssPmtk(const char *body)
+{
+	char cmd[GNSSCMDSZ];
+	uint8_t sum = 0;
+	const char *p;
+	int n;
+
+	for (p = body; *p; p++) {
+		sum ^= (uint8_t)*p;
+	}
+	n = snprintf(cmd, sizeof(cmd), "$%s*%02X\r\n", body, sum);
+	if (n <= 0 || (size_t)n >= sizeof(cmd)) {
+		return -1;
+	}
+	return serial_write(cmd, n);
+}
+
+/** @brief Queues a UBX message, sync bytes, length and Fletcher checksum are added
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint8_t cls message class
+ *  @param uint8_t id message id
+ *  @param const uint8_t * payload
+ *  @param uint16_t len payload bytes
+ *  @return int 0, -1 if too long or the port refused it
+ */
+int DlGnssUbx(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len)
+{
+	uint8_t frame[GNSSCMDSZ];
+	size_t n = DlUbxFrame(cls, id, payload, len, frame, sizeof(frame));
+
+	return n ? serial_write(frame, n) : -1;
+}
+
+/** @brief Puts a little endian value into a UBX payload
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint8_t * p
+ *  @param uint32_t v
+ *  @param int bytes 2 or 4
+ *  @return void
+ */
+static void DlGnssPut(uint8_t *p, uint32_t v, int bytes)
+{
+	int i;
+
+	for (i = 0; i < bytes; i++) {
+		p[i] = (uint8_t)(v >> (8 * i));
+	}
+}
+
+/** @brief Tells the receiver to change baud, at the baud it is on now
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlgnss_s * g
+ *  @return int 0, -1 if the command could not be sent
+ */
+static int DlGnssBaud(dlgnss_s *g)
+{
+	uint8_t prt[20];
+	char body[GNSSCMDSZ];
+
+	if (g->cfg.proto == DLGNSS_MTK) {
+		snprintf(body, sizeof(body), "PMTK251,%" PRIu32, g->cfg.baud);
+		return DlGnssPmtk(body);
+	}
+	// CFG-PRT for UART1, 8N1, UBX and NMEA in, UBX and NMEA out, only UBX for NAV-PVT
+	memset(prt, 0, sizeof(prt));
+	prt[0] = 1;
+	DlGnssPut(prt + 4, 0x000008D0, 4);
+	DlGnssPut(prt + 8, g->cfg.baud, 4);
+	DlGnssPut(prt + 12, 0x0003, 2);
+	DlGnssPut(prt + 14, g->cfg.pvt ? 0x0001 : 0x0003, 2);
+	return DlGnssUbx(UBXCFG, UBXCFGPRT, prt, sizeof(prt));
+}
+
+/** @brief Trims the output to GGA and RMC, or to NAV-PVT, and sets the
+ *  navigation rate
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlgnss_s * g
+ *  @return int 0, -1 if a command could not be sent
+ */
+static int DlGnssRate(dlgnss_s *g)
+{
+	// standard NMEA ids GGA GLL GSA GSV RMC VTG and whether to keep each
+	static const uint8_t nmeaid[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 };
+	static const uint8_t keep[] = { 1, 0, 0, 0, 1, 0 };
+	uint32_t ms = 1000 / g->cfg.ratehz;
+	uint8_t msg[3], rate[6];
+	char body[GNSSCMDSZ];
+	size_t i;
+	int rc = 0;
+
+	if (g->cfg.proto == DLGNSS_MTK) {
+		// GLL RMC VTG GGA GSA GSV, then the rarer sentences all off
+		rc |= DlGnssPmtk("PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0");
+		snprintf(body, sizeof(body), "PMTK220,%" PRIu32, ms);
+		rc |= DlGnssPmtk(body);
+		g->commands += 2;
+		return rc;
+	}
+	for (i = 0; i < sizeof(nmeaid); i++) {
+		msg[0] = UBXNMEA;
+		msg[1] = nmeaid[i];
+		msg[2] = g->cfg.pvt ? 0 : keep[i];
+		rc |= DlGnssUbx(UBXCFG, UBXCFGMSG, msg, sizeof(msg));
+		g->commands++;
+	}
+	if (g->cfg.pvt) {
+		msg[0] = UBXNAV;
+		msg[1] = UBXNAVPVT;
+		msg[2] = 1;
+		rc |= DlGnssUbx(UBXCFG, UBXCFGMSG, msg, sizeof(msg));
+		g->commands++;
+	}
+	// measurement period, one navigation solution per measurement, GPS time
+	DlGnssPut(rate, ms, 2);
+	DlGnssPut(rate + 2, 1, 2);
+	DlGnssPut(rate + 4, 1, 2);
+	rc |= DlGnssUbx(UBXCFG, UBXCFGRATE, rate, sizeof(rate));
+	g->commands++;
+	return rc;
+}
+
+/** @brief Configures the receiver and the open serial port. The baud
+ *  command goes out at GNSSBOOTBAUD, the rest at cfg.baud, so a receiver
+ *  that kept cfg.baud from an earlier run still gets its rate settings.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlgnss_s * g
+ *  @return int 0, -1 if the port could not be set or a command not sent
+ */
+int DlGnssConfigure(dlgnss_s *g)
+{
+	serialcfg_s port = { GNSSBOOTBAUD, 8, 'N', 1, g->cfg.lowlatency };
+	int rc = 0;
+
+	g->configured = DlTimeNow();
+	g->windowns = 0;
+	g->checked = false;
+	if (g->cfg.proto != DLGNSS_NONE && g->cfg.baud != GNSSBOOTBAUD) {
+		if (serial_config(&port) != 0) {
+			return -1;
+		}
+		rc |= DlGnssBaud(g);
+		g->commands++;
+		serial_drain(GNSSDRAINMS);
+		usleep(GNSSSETTLEMS * 1000);
+	}
+	port.baud = g->cfg.baud;
+	if (serial_config(&port) != 0) {
+		return -1;
+	}
+	if (g->cfg.proto != DLGNSS_NONE) {
+		rc |= DlGnssRate(g);
+	}
+	if ((uint64_t)g->cfg.baud / 10 < (uint64_t)g->cfg.ratehz * GNSSEPOCHBYTES) {
+		fprintf(stdout, "gnss: %" PRIu32 " baud is too slow for %" PRIu32 " fixes/s\n", g->cfg.baud, g->cfg.ratehz);
+	}
+	return rc ? -1 : 0;
+}
+
+/** @brief Counts a sentence and, when its time is new, a fix. Closes the
+ *  measurement window every GNSSMEASUREMS and checks the first one after
+ *  configuring against cfg.ratehz.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlgnss_s * g
+ *  @param uint32_t utcms time of the sentence, ms since midnight UTC
+ *  @return void
+ */
+void DlGnssEpoch(dlgnss_s *g, uint32_t utcms)
+{
+	uint64_t now = DlTimeNow(), elapsed;
+	uint32_t mhz;
+
+	g->sentences++;
+	if (utcms == g->lastutcms) {
+		return;
+	}
+	g->lastutcms = utcms;
+	g->epochs++;
+	if (g->windowns == 0) {
+		g->windowns = now;
+		g->windowepochs = 0;
+		return;
+	}
+	g->windowepochs++;
+	elapsed = now - g->windowns;
+	if (elapsed < GNSSMEASUREMS * NSPERMS) {
+		return;
+	}
+	mhz = (uint32_t)((uint64_t)g->windowepochs * 1000 * NSPERSEC / elapsed);
+	g->ratemhz = mhz;
+	g->windowns = now;
+	g->windowepochs = 0;
+	if (!g->checked && g->configured) {
+		g->checked = true;
+		if (mhz < GNSSRATEOK * g->cfg.ratehz * 1000) {
+			g->shortfalls++;
+			fprintf(stdout, "gnss: receiver sends %.1f fixes/s, asked for %" PRIu32 "\n", mhz / 1000.0,
+				g->cfg.ratehz);
+		}
+	}
+}
+
+/** @brief Prints the settings asked for and the fix rate measured
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlgnss_s * g
+ *  @param FILE * fp
+ *  @return void
+ */
+void DlGnssReport(dlgnss_s *g, FILE *fp)
+{
+	static const char *protoname[] = { "none", "mtk", "ubx" };
+
+	fprintf(fp, "gnss: %s%s %" PRIu32 " baud asked %" PRIu32 "Hz measured %.1fHz sentences %" PRIu64 " fixes %" PRIu64
+		" commands %" PRIu64 " shortfalls %" PRIu64 "\n", protoname[g->cfg.proto], g->cfg.pvt ? " nav-pvt" : "", g->cfg.baud, g->cfg.ratehz,
+		g->ratemhz.load() / 1000.0, g->sentences.load(), g->epochs.load(), g->commands.load(), g->shortfalls.load());
+}
@@ -0,0 +1,84 @@
+#ifndef DLGNSS_H
+#define DLGNSS_H
+/** @file dlgnss.h
+ *  @brief Constants, structures, function prototypes for configuring a
+ *  serial GNSS receiver and measuring its update rate
+ *
+ *  At 9600 baud a receiver sending its default sentence set has room for
+ *  about one fix a second. DlGnssConfigure moves the receiver and the port
+ *  to cfg.baud, trims the output to GGA and RMC and sets the navigation
+ *  rate, with PMTK sentences for MediaTek receivers or UBX CFG messages
+ *  for u-blox, which can send binary NAV-PVT instead. DlGnssEpoch is
+ *  told the time of every sentence and works out the fixes per second
+ *  actually arriving, which is checked against cfg.ratehz once the first
+ *  GNSSMEASUREMS window has closed.
+ *  Under gpsd the receiver belongs to gpsd, only the measurement is used.
+ */
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+
+#define GNSSPROTO DLGNSS_MTK    ///< DLGNSS_UBX for u-blox, DLGNSS_NONE to leave the receiver as it is
+#define GNSSBAUD 115200
+#define GNSSRATEHZ 10           ///< 1 to GNSSRATEMAX fixes per second
+#define GNSSRATEMAX 10          ///< Fastest rate the receivers take, ratehz is clamped to it
+#define GNSSPVT 0               ///< u-blox only, 1 for binary NAV-PVT instead of GGA and RMC
+#define GNSSBOOTBAUD 9600       ///< Baud the receiver powers up at, where the baud command is sent
+#define GNSSEPOCHBYTES 160      ///< GGA and RMC for one fix with line ends, NAV-PVT is 100
+#define GNSSSETTLEMS 100        ///< Receiver switching baud after the command
+#define GNSSDRAINMS 1000        ///< Longest wait for a command to leave the port
+#define GNSSMEASUREMS 5000      ///< Window the fix rate is measured over
+#define GNSSRATEOK 0.9f         ///< Fraction of ratehz a measured window must reach
+#define GNSSCMDSZ 96
+#define UBXSYNC1 0xB5
+#define UBXSYNC2 0x62
+#define UBXCFG 0x06
+#define UBXCFGPRT 0x00
+#define UBXCFGMSG 0x01
+#define UBXCFGRATE 0x08
+#define UBXNMEA 0xF0            ///< Class of the standard NMEA sentences in CFG-MSG
+#define UBXHDRSZ 6              ///< Sync, class, id and length
+#define UBXCKSZ 2
+
+enum dlgnssproto_e
+{
+	DLGNSS_NONE,  ///< Receiver left as it is, port at cfg.baud
+	DLGNSS_MTK,   ///< PMTK251 baud, PMTK220 interval, PMTK314 sentences
+	DLGNSS_UBX    ///< UBX CFG-PRT, CFG-RATE and CFG-MSG
+};
+
+typedef struct dlgnsscfg
+{
+	dlgnssproto_e proto;
+	uint32_t baud;       ///< Receiver and port baud after configuring
+	uint32_t ratehz;     ///< Fixes per second asked for
+	bool lowlatency;     ///< Driver low latency mode on the port
+	bool pvt;            ///< DLGNSS_UBX only, NAV-PVT frames instead of NMEA text
+} dlgnsscfg_s;
+
+typedef struct dlgnss
+{
+	dlgnsscfg_s cfg;
+	uint64_t configured;     ///< CLOCK_MONOTONIC ns the commands were sent, 0 never
+	uint64_t windowns;       ///< Start of the measurement window, 0 none open
+	uint32_t windowepochs;   ///< Fixes in the window so far
+	uint32_t lastutcms;      ///< Time of the last sentence, a new time is a new fix
+	bool checked;            ///< Rate checked since the last configure
+	std::atomic<uint32_t> ratemhz;      ///< Fixes per 1000s over the last window
+	std::atomic<uint64_t> sentences;
+	std::atomic<uint64_t> epochs;
+	std::atomic<uint64_t> commands;     ///< Configuration messages sent
+	std::atomic<uint64_t> shortfalls;   ///< Checks that came in under GNSSRATEOK
+} dlgnss_s;
+
+///\cond INTERNAL
+// Function Prototypes
+void DlGnssInit(dlgnss_s *g, const dlgnsscfg_s *cfg);
+int DlGnssPmtk(const char *body);
+int DlGnssUbx(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len);
+int DlGnssConfigure(dlgnss_s *g);
+void DlGnssEpoch(dlgnss_s *g, uint32_t utcms);
+void DlGnssReport(dlgnss_s *g, FILE *fp);
+///\endcond
+#endif
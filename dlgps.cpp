@@ -2,36 +2,83 @@
  *  @brief Data logger gps Functions
  */
 #include "dlgps.h"
-#include "nmea.h"
+#include "dlnmea.h"
+#include "dlubx.h"
 #include "serial.h"
+#include "dltime.h"
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <atomic>
 #include <errno.h>
 #include <gps.h>
+#include <poll.h>
+#include <pthread.h>
 #include <unistd.h>
 
 #if SIMGPS
 // Global GPS Data File Pointer
 FILE * fpgps = NULL;
+#elif GPSDSERVER
+// gpsd session, opened once by DlGpsInit
+static struct gps_data_t gps_data;
+static int gpsopen = 0;
 #endif
 
-/** @brief Initializes GPS Module
+// Location being assembled from the receiver, only touched by the reader
+static loc_t gpsloc = {0.0};
+static dlgpsmode_e gpsmode = DLGPS_UNKNOWN;
+static dlnmea_s nmea;  // serial receiver stream
+static dlubx_s ubx;    // the same when the receiver sends NAV-PVT
+static dlgnss_s gnss;  // receiver settings and measured fix rate
+
+// Latest fix, one writer, read anywhere through DlGpsFix
+static dlgpsfix_s fixcell;
+static std::atomic<uint32_t> fixseq(0);  // odd while fixcell is being written
+
+static pthread_t gpsthread;
+static std::atomic<bool> gpsrun(false);
+static std::atomic<uint64_t> fixes(0);
+static std::atomic<uint64_t> reopens(0);
+
+/** @brief Initializes GPS Module, opens the gpsd session or serial port once
  *  @author Paul Moggach
  *  @date 25MAR2019
  *  @param None
- *  @return void
+ *  @return int descriptor to watch for GPS data, -1 if there is none
  */
-extern void DlGpsInit(void)
+extern int DlGpsInit(void)
 {
 #if SIMGPS
     fpgps = fopen("gpstestdata.txt","r");
     if(fpgps == NULL) { fprintf(stdout,"Unable to open gps test data file\n"); }
+    return -1;
+#elif GPSDSERVER
+	if (gpsopen)
+	{
+		return gps_data.gps_fd;
+	}
+	if ((gps_open("localhost", "2947", &gps_data)) == -1)
+	{
+		fprintf(stdout,"code: %d, reason: %s\n", errno, gps_errstr(errno));
+		return -1;
+	}
+	(void)gps_stream(&gps_data, WATCH_ENABLE | WATCH_JSON, NULL);
+	gpsopen = 1;
+	return gps_data.gps_fd;
 #else
-	// Serial GPS device or GPSD server
+	// Serial GPS device
 	serial_init();
-	serial_config();
+	if (DlGnssConfigure(&gnss) != 0)
+	{
+		serial_close();
+		return -1;
+	}
+	DlNmeaInit(&nmea);
+	DlUbxInit(&ubx);
+	return serial_fd();
 #endif
 }
 
@@ -46,87 +93,403 @@ extern void DlGpsOn(void)
     //Write on
 }
 
-/** @brief Compute the GPS location using decimal scale
- *  @author Robert Miller, from lab code
- *  @date 4APR2022
+/** @brief Converts an NMEA time of day and ddmmyy date to epoch nanoseconds
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint32_t utcms ms since midnight UTC
+ *  @param uint32_t date ddmmyy
+ *  @return uint64_t ns since 1970-01-01 UTC
+ */
+static uint64_t DlGpsNmeaEpochNs(uint32_t utcms, uint32_t date)
+{
+	struct tm t = {0};
+
+	t.tm_mday = date / 10000;
+	t.tm_mon = (date / 100) % 100 - 1;
+	t.tm_year = date % 100 + 100;
+	return (uint64_t)timegm(&t) * NSPERSEC + (uint64_t)utcms * NSPERMS;
+}
+
+/** @brief NMEA parser callback, folds one checked GGA or RMC sentence into
+ *  a location
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context loc_t being assembled
+ *  @param const dlnmeafix_s * fix
+ *  @return void
+ */
+static void DlGpsNmeaEvent(void *context, const dlnmeafix_s *fix)
+{
+	loc_t *cloc = (loc_t *)context;
+	uint32_t hhmmss;
+
+	if (fix->present & NMEA_HASTIME)
+	{
+		if (cloc == &gpsloc)
+		{
+			DlGnssEpoch(&gnss, fix->utcms);
+		}
+		hhmmss = fix->utcms / 3600000 * 10000 + fix->utcms / 60000 % 60 * 100;
+		cloc->utc = hhmmss + (fix->utcms % 60000) / 1000.0;
+	}
+	if (fix->present & NMEA_HASPOS)
+	{
+		cloc->latitude = (double)fix->lat / NMEAPOS_SCALE;
+		cloc->longitude = (double)fix->lon / NMEAPOS_SCALE;
+	}
+	if (fix->type == NMEA_GPGGA)
+	{
+		if (fix->present & NMEA_HASALT)
+		{
+			cloc->altitude = fix->altmm / 1000.0;
+		}
+		gpsmode = fix->quality == 0 || !(fix->present & NMEA_HASPOS) ? DLGPS_NOFIX :
+			fix->present & NMEA_HASALT ? DLGPS_3D : DLGPS_2D;
+		return;
+	}
+	if (fix->present & NMEA_HASSPEED)
+	{
+		cloc->speed = fix->speedmk / 1000.0;
+	}
+	if (fix->present & NMEA_HASCOURSE)
+	{
+		cloc->course = fix->coursemd / 1000.0;
+	}
+	if (fix->present & NMEA_HASDATE)
+	{
+		cloc->date = fix->date;
+		if ((fix->present & NMEA_HASTIME) && fix->status == 'A')
+		{
+			DlTimeDiscipline(DlGpsNmeaEpochNs(fix->utcms, fix->date), DlTimeNow());
+		}
+	}
+}
+
+/** @brief UBX decoder callback, takes one NAV-PVT as the fix for its
+ *  epoch, position, height, speed and heading at once
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context loc_t being assembled
+ *  @param const dlubxpvt_s * pvt
+ *  @return void
+ */
+static void DlGpsUbxEvent(void *context, const dlubxpvt_s *pvt)
+{
+	loc_t *cloc = (loc_t *)context;
+	struct tm t = {0};
+	uint32_t utcms = pvt->hour * 3600000 + pvt->min * 60000 + pvt->sec * 1000;
+	int64_t ns;
+
+	DlGnssEpoch(&gnss, utcms);
+	gpsmode = !(pvt->flags & UBXPVT_GNSSFIXOK) ? DLGPS_NOFIX : pvt->fixtype == 2 ? DLGPS_2D :
+		pvt->fixtype == 3 || pvt->fixtype == 4 ? DLGPS_3D : DLGPS_NOFIX;
+	if (gpsmode >= DLGPS_2D)
+	{
+		cloc->latitude = (double)pvt->lat / NMEAPOS_SCALE;
+		cloc->longitude = (double)pvt->lon / NMEAPOS_SCALE;
+		cloc->altitude = pvt->hmsl / 1000.0;
+		cloc->speed = pvt->gspeed / 1000.0;
+		cloc->course = pvt->headmot / 100000.0;
+	}
+	if ((pvt->valid & (UBXPVT_VALIDDATE | UBXPVT_VALIDTIME)) != (UBXPVT_VALIDDATE | UBXPVT_VALIDTIME))
+	{
+		return;
+	}
+	cloc->utc = pvt->hour * 10000 + pvt->min * 100 + pvt->sec + pvt->nano / 1e9;
+	cloc->date = pvt->day * 10000 + pvt->month * 100 + pvt->year % 100;
+	if (pvt->valid & UBXPVT_RESOLVED)
+	{
+		t.tm_year = pvt->year - 1900;
+		t.tm_mon = pvt->month - 1;
+		t.tm_mday = pvt->day;
+		t.tm_hour = pvt->hour;
+		t.tm_min = pvt->min;
+		t.tm_sec = pvt->sec;
+		ns = (int64_t)timegm(&t) * (int64_t)NSPERSEC + pvt->nano;
+		DlTimeDiscipline((uint64_t)ns, DlTimeNow());
+	}
+}
+
+/** @brief Copies the assembled location into the fix cell. The sequence
+ *  is odd while the copy is in progress so readers retry instead of seeing
+ *  half a fix.
+ *  @author Robert Miller
+ *  @date 17Oct2026
  *  @param void
- *  @return coord loc_t data structure
+ *  @return void
  */
-loc_t DlGpsLocation(void)
+static void DlGpsPublish(void)
 {
-    loc_t cloc = {0.0};
-    char buffer[GPSDATASZ] = {0};
+	uint32_t seq = fixseq.load(std::memory_order_relaxed);
+
+	fixseq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	fixcell.loc = gpsloc;
+	fixcell.mode = gpsmode;
+	fixcell.tns = DlTimeNow();
+	fixseq.store(seq + 2, std::memory_order_release);
+	fixes++;
+}
+
 #if GPSDSERVER
-	struct gps_data_t gps_data;
+/** @brief Takes the report gps_read just decoded into the fix cell
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+static void DlGpsGpsdReport(void)
+{
+	if (MODE_SET != (MODE_SET & gps_data.set))
+	{
+		// did not even get mode, nothing to see here
+		return;
+	}
+	if ((TIME_SET & gps_data.set) && std::isfinite(gps_data.fix.time) && gps_data.fix.time > 0)
+	{
+		DlTimeDiscipline((uint64_t)(gps_data.fix.time * NSPERSEC), DlTimeNow());
+		DlGnssEpoch(&gnss, (uint32_t)(fmod(gps_data.fix.time, 86400.0) * 1000));
+	}
+	gpsmode = gps_data.fix.mode >= MODE_3D ? DLGPS_3D : gps_data.fix.mode == MODE_2D ? DLGPS_2D :
+		gps_data.fix.mode == MODE_NO_FIX ? DLGPS_NOFIX : DLGPS_UNKNOWN;
+	if (std::isfinite(gps_data.fix.latitude) && std::isfinite(gps_data.fix.longitude))
+	{
+		gpsloc.latitude = gps_data.fix.latitude;
+		gpsloc.longitude = gps_data.fix.longitude;
+		gpsloc.altitude = gps_data.fix.altitude;
+		gpsloc.speed = gps_data.fix.speed;
+		gpsloc.course = gps_data.fix.track;
+		gpsloc.utc = gps_data.fix.time;
+	}
+	DlGpsPublish();
+}
+#endif
 
-	if ((gps_open("localhost", "2947", &gps_data)) == -1)
+/** @brief Reads whatever gpsd or the serial port has buffered and publishes
+ *  each complete fix
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int fd descriptor from DlGpsInit, readable
+ *  @return int 0, -1 if the session or port has failed and must be reopened
+ */
+static int DlGpsRead(int fd)
+{
+#if GPSDSERVER
+	// gps_read decodes one report, the rest of the same recv stays in
+	// libgps where poll cannot see it, so keep going until it is empty
+	do
 	{
-		fprintf(stdout,"code: %d, reason: %s\n", errno, gps_errstr(errno));
-		return cloc;
+		if (-1 == gps_read(&gps_data))
+		{
+			return -1;
+		}
+		DlGpsGpsdReport();
+	} while (gps_waiting(&gps_data, 0));
+#else
+	const char *data;
+	size_t n, sentences = 0;
+
+	if (serial_fill() < 0 || serial_flush() < 0)
+	{
+		return -1;
 	}
-	(void)gps_stream(&gps_data, WATCH_ENABLE | WATCH_JSON, NULL);
-    // Wait for data available.
-    while (gps_waiting(&gps_data, 5000000))
-    {
-        // will not block because we know data is available.
-        if (-1 == gps_read(&gps_data))
-        {
-            printf("Read error.  Bye, bye\n");
-            break;
-        }
-        if (MODE_SET != (MODE_SET & gps_data.set))
-        {
-            // did not even get mode, nothing to see here
-            continue;
-        }
-        break;
+	// parse in place, twice when the ring has wrapped
+	while ((n = serial_peek(&data)) > 0)
+	{
+		if (gnss.cfg.pvt)
+		{
+			sentences += DlUbxFeed(&ubx, (const uint8_t *)data, n, DlGpsUbxEvent, &gpsloc);
+		}
+		else
+		{
+			sentences += DlNmeaFeed(&nmea, data, n, DlGpsNmeaEvent, &gpsloc);
+		}
+		serial_consume(n);
+	}
+	if (sentences > 0)
+	{
+		DlGpsPublish();
+	}
+#endif
+	return 0;
+}
 
-    }
-    if (std::isfinite(gps_data.fix.latitude) &&
-        std::isfinite( gps_data.fix.longitude))
-    {
-		cloc.latitude = gps_data.fix.latitude;
-		cloc.longitude = gps_data.fix.longitude;
-		cloc.altitude = gps_data.fix.altitude;
-		cloc.speed = gps_data.fix.speed;
-		cloc.course = gps_data.fix.track;
-		cloc.utc = gps_data.fix.time;
-    }
+/** @brief Event loop handler, call when the descriptor from DlGpsInit is
+ *  readable, for loggers that read the GPS on their reactor rather than
+ *  with DlGpsStart
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int fd descriptor from DlGpsInit
+ *  @param uint32_t events ready events
+ *  @param void * arg unused
+ *  @return void
+ */
+void DlGpsEvent(int fd, uint32_t events, void *arg)
+{
+	if (DlGpsRead(fd) < 0)
+	{
+		reopens++;
+	}
+}
+
+/** @brief Service thread, keeps one session with the receiver open and
+ *  streams every fix into the cell. A failed session is closed and
+ *  reopened after GPSRETRYMS.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg unused
+ *  @return void * NULL
+ */
+static void *DlGpsService(void *arg)
+{
+	struct pollfd pfd = { -1, POLLIN, 0 };
+	uint64_t retry = 0;
+
+	while (gpsrun.load())
+	{
+		if (pfd.fd < 0)
+		{
+			if (DlTimeNow() < retry)
+			{
+				usleep(GPSPOLLMS * 1000);
+				continue;
+			}
+			pfd.fd = DlGpsInit();
+			if (pfd.fd < 0)
+			{
+				retry = DlTimeNow() + GPSRETRYMS * NSPERMS;
+				continue;
+			}
+		}
+#if !GPSDSERVER
+		pfd.events = serial_txqueued() ? POLLIN | POLLOUT : POLLIN;
+#endif
+		if (poll(&pfd, 1, GPSPOLLMS) > 0 && ((pfd.revents & (POLLERR | POLLHUP)) || DlGpsRead(pfd.fd) < 0))
+		{
+			DlGpsOff();
+			pfd.fd = -1;
+			retry = DlTimeNow() + GPSRETRYMS * NSPERMS;
+			reopens++;
+		}
+	}
+	if (pfd.fd >= 0)
+	{
+		DlGpsOff();
+	}
+	return NULL;
+}
+
+/** @brief Starts the GPS service thread, the receiver is opened and
+ *  configured by the thread
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlgnsscfg_s * cfg serial receiver settings, NULL for the defaults
+ *  @return int 1 on success, 0 if the thread could not be started
+ */
+int DlGpsStart(const dlgnsscfg_s *cfg)
+{
+	DlGnssInit(&gnss, cfg);
+#if SIMGPS
+	DlGpsInit();
+	return 1;
 #else
-   uint8_t status = _EMPTY;
-    gpgga_t gpgga;
-    gprmc_t gprmc;
+	gpsrun = true;
+	if (pthread_create(&gpsthread, NULL, DlGpsService, NULL) != 0)
+	{
+		gpsrun = false;
+		return 0;
+	}
+	return 1;
+#endif
+}
+
+/** @brief Latest fix, lock free and safe from any thread
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return dlgpsfix_s mode DLGPS_UNKNOWN and tns 0 before the first fix
+ */
+dlgpsfix_s DlGpsFix(void)
+{
+	dlgpsfix_s fix;
+	uint32_t seq;
 
-    while(status != _COMPLETED)
-    {
 #if SIMGPS
-        fgets(buffer,NMEAMSGSZ,fpgps);
-        if(feof(fpgps)) { rewind(fpgps); }
+	fix.loc = DlGpsLocation();
+	fix.mode = DLGPS_3D;
+	fix.tns = DlTimeNow();
 #else
-        serial_readln(buffer,GPSDATASZ);
+	do
+	{
+		seq = fixseq.load(std::memory_order_acquire);
+		fix = fixcell;
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((seq & 1) || seq != fixseq.load(std::memory_order_relaxed));
 #endif
-        switch (nmea_get_message_type(buffer))
-	{
-            case NMEA_GPGGA:
-                nmea_parse_gpgga(buffer, &gpgga);
-				cloc.utc = gpgga.utc;
-                DlGpsConvertDegToDec(&(gpgga.latitude), gpgga.lat, &(gpgga.longitude), gpgga.lon);
-                cloc.latitude = gpgga.latitude;
-                cloc.longitude = gpgga.longitude;
-                cloc.altitude = gpgga.altitude;
-				status |= NMEA_GPGGA;
-				break;
-            case NMEA_GPRMC:
-                nmea_parse_gprmc(buffer, &gprmc);
-				cloc.speed = gprmc.speed;
-                cloc.course = gprmc.course;
-				cloc.date = gprmc.date;
-                status |= NMEA_GPRMC;
- 				break;
-        }
-    }
+	return fix;
+}
+
+/** @brief Stops the service thread, which closes the receiver
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void DlGpsStop(void)
+{
+#if SIMGPS
+	DlGpsOff();
+#else
+	if (gpsrun.exchange(false))
+	{
+		pthread_join(gpsthread, NULL);
+	}
+#endif
+}
+
+/** @brief Prints the fix mode and age and how often the receiver was reopened
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param FILE * fp
+ *  @return void
+ */
+void DlGpsReport(FILE *fp)
+{
+	static const char *modename[] = { "unknown", "nofix", "2d", "3d" };
+	dlgpsfix_s fix = DlGpsFix();
+
+	fprintf(fp, "gps: mode %s age %.1fms fixes %" PRIu64 " reopens %" PRIu64 "\n", modename[fix.mode],
+		fix.tns ? (double)(DlTimeNow() - fix.tns) / NSPERMS : 0.0, fixes.load(), reopens.load());
+	DlGnssReport(&gnss, fp);
+#if !SIMGPS && !GPSDSERVER
+	serial_report(fp);
 #endif
+}
+
+/** @brief Compute the GPS location using decimal scale
+ *  @author Robert Miller, from lab code
+ *  @date 17Oct2026
+ *  @param void
+ *  @return coord loc_t data structure, the latest fix
+ */
+loc_t DlGpsLocation(void)
+{
+#if SIMGPS
+    loc_t cloc = {0.0};
+    char buffer[GPSDATASZ] = {0};
+    uint8_t status = _EMPTY;
+    dlnmea_s p;
+
+    DlNmeaInit(&p);
+    while(status != _COMPLETED)
+    {
+        if (fgets(buffer,GPSDATASZ,fpgps) == NULL) { rewind(fpgps); continue; }
+        if (DlNmeaFeed(&p, buffer, strlen(buffer), DlGpsNmeaEvent, &cloc) > 0) { status |= p.fix.type; }
+    }
     return cloc;
+#else
+    return DlGpsFix().loc;
+#endif
 }
 
 
@@ -140,8 +503,16 @@ extern void DlGpsOff(void)
 {
 #if SIMGPS
 	fclose(fpgps);
+#elif GPSDSERVER
+	if (gpsopen)
+	{
+		(void)gps_stream(&gps_data, WATCH_DISABLE, NULL);
+		gps_close(&gps_data);
+		gpsopen = 0;
+	}
+#else
+	serial_close();
 #endif
-//    serial_close();
 }
 
 /** @brief Convert lat e lon to decimals (from deg)
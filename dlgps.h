@@ -2,14 +2,25 @@
 #define DLGPS_H
 /** @file dlgps.h
  *  @brief Constants, structures, function prototypes for gps functions
+ *
+ *  DlGpsStart runs a service thread that opens gpsd, or the serial
+ *  receiver, once and keeps streaming from it, reopening it after an
+ *  error. Every fix goes into a seqlock cell, so DlGpsFix on the sampling
+ *  path is a copy of a few dozen bytes and never touches the socket.
  */
 #include <cmath>
+#include <cinttypes>
+#include <cstdio>
+#include "dlgnss.h"
 
 #define round(x) ((x < 0) ? (ceil((x)-0.5)) : (floor((x)+0.5)))
 #define SIMGPS 0
 #define GPSDSERVER 1
 #define GPSSERIAL 0
 #define GPSDATASZ 256
+#define GPSPOLLMS 200     ///< Service thread checks for stop this often
+#define GPSRETRYMS 2000   ///< Wait before reopening gpsd or the port after an error
+#define GPSSTALEMS 3000   ///< An older fix is reported as no position
 
 typedef struct location
 {
@@ -22,12 +33,32 @@ typedef struct location
     double course;
 } loc_t;
 
+enum dlgpsmode_e
+{
+	DLGPS_UNKNOWN,  ///< Nothing heard from the receiver yet
+	DLGPS_NOFIX,    ///< Receiver talking, no position
+	DLGPS_2D,       ///< Latitude and longitude
+	DLGPS_3D        ///< Altitude as well
+};
+
+typedef struct dlgpsfix
+{
+	loc_t loc;
+	dlgpsmode_e mode;
+	uint64_t tns;       ///< CLOCK_MONOTONIC ns the fix arrived, 0 never
+} dlgpsfix_s;
+
 ///\cond INTERNAL
 // Function Prototypes
-extern void DlGpsInit(void);
+extern int DlGpsInit(void);
 extern void DlGpsOn(void);
+void DlGpsEvent(int fd, uint32_t events, void *arg);
 loc_t DlGpsLocation(void);
 extern void DlGpsOff(void);
+int DlGpsStart(const dlgnsscfg_s *cfg);
+dlgpsfix_s DlGpsFix(void);
+void DlGpsStop(void);
+void DlGpsReport(FILE *fp);
 // -------------------------------------------------------------------------
 // Internal functions
 // -------------------------------------------------------------------------
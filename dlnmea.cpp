@@ -0,0 +1,386 @@
+/** @file dlnmea.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Byte at a time NMEA 0183 parser, GGA and RMC to fixed point
+ */
+#include "dlnmea.h"
+#include <cstring>
+
+#define NMEA_HASLAT 0x40  ///< Internal, latitude and hemisphere seen
+#define NMEA_HASLON 0x80  ///< Internal, longitude and hemisphere seen
+
+// up to 10^NMEAMAXDIGITS, a field may carry all its digits after the point
+static const int64_t nmeapow10[NMEAMAXDIGITS + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000,
+	100000000, 1000000000, 10000000000, 100000000000, 1000000000000, 10000000000000, 100000000000000,
+	1000000000000000, 10000000000000000, 100000000000000000, 1000000000000000000 };
+
+/** @brief Sets up a parser waiting for the first '$'
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlnmea_s * p
+ *  @return void
+ */
+void DlNmeaInit(dlnmea_s *p)
+{
+	memset(p, 0, sizeof(*p));
+	p->state = DLNMEA_HUNT;
+}
+
+/** @brief Empties the field accumulator for the next field
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlnmea_s * p
+ *  @return void
+ */
+static inline void DlNmeaFieldReset(dlnmea_s *p)
+{
+	p->first = 0;
+	p->digits = 0;
+	p->frac = -1;
+	p->neg = false;
+	p->bad = false;
+	p->mant = 0;
+}
+
+/** @brief Current field as a fixed point integer
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlnmea_s * p
+ *  @param int decimals digits wanted after the point, at most 9
+ *  @param int64_t * value field x 10^decimals, extra digits truncated
+ *  @return bool false if the field is empty, not a number or too large
+ */
+static bool DlNmeaFixed(const dlnmea_s *p, int decimals, int64_t *value)
+{
+	int frac = p->frac < 0 ? 0 : p->frac;
+
+	if (p->digits == 0 || p->bad || p->digits - frac + decimals > NMEAMAXDIGITS) {
+		return false;
+	}
+	*value = frac > decimals ? p->mant / nmeapow10[frac - decimals] : p->mant * nmeapow10[decimals - frac];
+	if (p->neg) {
+		*value = -*value;
+	}
+	return true;
+}
+
+/** @brief Current field as hhmmss.sss
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlnmea_s * p
+ *  @return void
+ */
+static void DlNmeaTime(dlnmea_s *p)
+{
+	int64_t t;
+	uint32_t hh, mm, ms;
+
+	if (!DlNmeaFixed(p, 3, &t) || t < 0) {
+		return;
+	}
+	hh = (uint32_t)(t / 10000000);
+	mm = (uint32_t)(t / 100000 % 100);
+	ms = (uint32_t)(t % 100000);
+	if (hh < 24 && mm < 60 && ms < 61000) {
+		p->fix.utcms = hh * 3600000 + mm * 60000 + ms;
+		p->fix.present |= NMEA_HASTIME;
+	}
+}
+
+/** @brief Current field as dddmm.mmmm, held until its hemisphere arrives
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlnmea_s * p
+ *  @return bool false if the field is empty or not an angle
+ */
+static bool DlNmeaDegrees(dlnmea_s *p)
+{
+	int64_t v, minutes;
+
+	if (!DlNmeaFixed(p, 7, &v) || v < 0) {
+		return false;
+	}
+	minutes = v % (100 * (int64_t)NMEAPOS_SCALE);
+	if (minutes >= 60 * (int64_t)NMEAPOS_SCALE) {
+		return false;
+	}
+	p->pending = v / (100 * (int64_t)NMEAPOS_SCALE) * NMEAPOS_SCALE + (minutes + 30) / 60;
+	return p->pending <= 180 * (int64_t)NMEAPOS_SCALE;
+}
+
+/** @brief Applies the hemisphere in the current field to the pending angle
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlnmea_s * p
+ *  @param char positive 'N' or 'E'
+ *  @param char negative 'S' or 'W'
+ *  @param int32_t * angle latitude or longitude
+ *  @param uint8_t bit NMEA_HASLAT or NMEA_HASLON
+ *  @return void
+ */
+static void DlNmeaHemisphere(dlnmea_s *p, char positive, char negative, int32_t *angle, uint8_t bit)
+{
+	if (p->pending < 0 || (p->first != positive && p->first != negative)) {
+		return;
+	}
+	*angle = (int32_t)(p->first == negative ? -p->pending : p->pending);
+	p->fix.present |= bit;
+}
+
+/** @brief Stores the field that has just ended into the fix
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlnmea_s * p
+ *  @return void
+ */
+static void DlNmeaField(dlnmea_s *p)
+{
+	dlnmeafix_s *fix = &p->fix;
+	int64_t v;
+
+	if (fix->type == NMEA_GPGGA) {
+		switch (p->field) {
+		case 1:
+			DlNmeaTime(p);
+			break;
+		case 2:
+		case 4:
+			if (!DlNmeaDegrees(p)) {
+				p->pending = -1;
+			}
+			break;
+		case 3:
+			DlNmeaHemisphere(p, 'N', 'S', &fix->lat, NMEA_HASLAT);
+			break;
+		case 5:
+			DlNmeaHemisphere(p, 'E', 'W', &fix->lon, NMEA_HASLON);
+			break;
+		case 6:
+			if (DlNmeaFixed(p, 0, &v) && v >= 0 && v <= 9) {
+				fix->quality = (uint8_t)v;
+			}
+			break;
+		case 7:
+			if (DlNmeaFixed(p, 0, &v) && v >= 0 && v <= 255) {
+				fix->satellites = (uint8_t)v;
+			}
+			break;
+		case 9:
+			if (DlNmeaFixed(p, 3, &v) && v > INT32_MIN && v < INT32_MAX) {
+				fix->altmm = (int32_t)v;
+				fix->present |= NMEA_HASALT;
+			}
+			break;
+		}
+	} else {
+		switch (p->field) {
+		case 1:
+			DlNmeaTime(p);
+			break;
+		case 2:
+			fix->status = p->first;
+			break;
+		case 3:
+		case 5:
+			if (!DlNmeaDegrees(p)) {
+				p->pending = -1;
+			}
+			break;
+		case 4:
+			DlNmeaHemisphere(p, 'N', 'S', &fix->lat, NMEA_HASLAT);
+			break;
+		case 6:
+			DlNmeaHemisphere(p, 'E', 'W', &fix->lon, NMEA_HASLON);
+			break;
+		case 7:
+			if (DlNmeaFixed(p, 3, &v) && v >= 0 && v <= UINT32_MAX) {
+				fix->speedmk = (uint32_t)v;
+				fix->present |= NMEA_HASSPEED;
+			}
+			break;
+		case 8:
+			if (DlNmeaFixed(p, 3, &v) && v >= 0 && v < 360000) {
+				fix->coursemd = (uint32_t)v;
+				fix->present |= NMEA_HASCOURSE;
+			}
+			break;
+		case 9:
+			if (DlNmeaFixed(p, 0, &v) && v >= 10100 && v <= 311299) {
+				fix->date = (uint32_t)v;
+				fix->present |= NMEA_HASDATE;
+			}
+			break;
+		}
+	}
+}
+
+/** @brief Value of a hex checksum digit
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param char c
+ *  @return int 0 to 15, -1 if c is not a hex digit
+ */
+static inline int DlNmeaHex(char c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	return -1;
+}
+
+/** @brief Picks the sentence type from the address, GGA and RMC from any talker
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlnmea_s * p
+ *  @return uint8_t NMEA_GPGGA, NMEA_GPRMC or NMEA_UNKNOWN
+ */
+static uint8_t DlNmeaType(const dlnmea_s *p)
+{
+	if (p->addrlen != NMEAADDRSZ) {
+		return NMEA_UNKNOWN;
+	}
+	if (memcmp(p->addr + 2, "GGA", 3) == 0) {
+		return NMEA_GPGGA;
+	}
+	if (memcmp(p->addr + 2, "RMC", 3) == 0) {
+		return NMEA_GPRMC;
+	}
+	return NMEA_UNKNOWN;
+}
+
+/** @brief Feeds bytes from the receiver, sentences may be split across calls
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlnmea_s * p
+ *  @param const char * buf bytes as read
+ *  @param size_t len
+ *  @param dlnmea_f * cb called for each GGA or RMC that passed its checksum
+ *  @param void * context passed to cb
+ *  @return size_t sentences handed to cb
+ */
+size_t DlNmeaFeed(dlnmea_s *p, const char *buf, size_t len, dlnmea_f *cb, void *context)
+{
+	size_t i, emitted = 0;
+	char c;
+	int h;
+
+	for (i = 0; i < len; i++) {
+		c = buf[i];
+		if (c == '$') {
+			if (p->state != DLNMEA_HUNT && p->state != DLNMEA_SKIP) {
+				p->malformed++;
+			}
+			p->state = DLNMEA_ADDRESS;
+			p->sum = 0;
+			p->len = 1;
+			p->addrlen = 0;
+			continue;
+		}
+		if (p->state == DLNMEA_HUNT || p->state == DLNMEA_SKIP) {
+			continue;
+		}
+		if (++p->len > NMEAMSGSZ || c < ' ' || c > '~') {
+			// overlong, or a line ended before the checksum
+			p->malformed++;
+			p->state = DLNMEA_HUNT;
+			continue;
+		}
+		switch (p->state) {
+		case DLNMEA_ADDRESS:
+			p->sum ^= c;
+			if (c != ',') {
+				if (p->addrlen == NMEAADDRSZ || !((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))) {
+					p->malformed++;
+					p->state = DLNMEA_HUNT;
+				} else {
+					p->addr[p->addrlen++] = c;
+				}
+				break;
+			}
+			memset(&p->fix, 0, sizeof(p->fix));
+			p->fix.type = DlNmeaType(p);
+			if (p->fix.type == NMEA_UNKNOWN) {
+				p->ignored++;
+				p->state = DLNMEA_SKIP;
+				break;
+			}
+			p->field = 1;
+			p->pending = -1;
+			DlNmeaFieldReset(p);
+			p->state = DLNMEA_FIELD;
+			break;
+		case DLNMEA_FIELD:
+			if (c == '*') {
+				DlNmeaField(p);
+				p->state = DLNMEA_CK1;
+				break;
+			}
+			p->sum ^= c;
+			if (c == ',') {
+				DlNmeaField(p);
+				p->field++;
+				DlNmeaFieldReset(p);
+				break;
+			}
+			if (p->first == 0) {
+				p->first = c;
+			}
+			if (c >= '0' && c <= '9') {
+				if (p->digits < NMEAMAXDIGITS) {
+					p->mant = p->mant * 10 + (c - '0');
+					p->digits++;
+					if (p->frac >= 0) {
+						p->frac++;
+					}
+				} else if (p->frac < 0) {
+					p->bad = true;
+				}
+			} else if (c == '.' && p->frac < 0) {
+				p->frac = 0;
+			} else if (c == '-' && p->first == c && !p->neg) {
+				p->neg = true;
+			} else {
+				p->bad = true;
+			}
+			break;
+		case DLNMEA_CK1:
+			h = DlNmeaHex(c);
+			if (h < 0) {
+				p->malformed++;
+				p->state = DLNMEA_HUNT;
+				break;
+			}
+			p->ck = (uint8_t)(h << 4);
+			p->state = DLNMEA_CK2;
+			break;
+		case DLNMEA_CK2:
+			h = DlNmeaHex(c);
+			p->state = DLNMEA_HUNT;
+			if (h < 0) {
+				p->malformed++;
+				break;
+			}
+			if ((p->ck | h) != p->sum) {
+				p->badsum++;
+				break;
+			}
+			if ((p->fix.present & (NMEA_HASLAT | NMEA_HASLON)) == (NMEA_HASLAT | NMEA_HASLON)) {
+				p->fix.present |= NMEA_HASPOS;
+			}
+			p->fix.present &= ~(NMEA_HASLAT | NMEA_HASLON);
+			p->sentences++;
+			emitted++;
+			if (cb != NULL) {
+				cb(context, &p->fix);
+			}
+			break;
+		}
+	}
+	return emitted;
+}
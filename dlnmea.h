@@ -0,0 +1,89 @@
+#ifndef DLNMEA_H
+#define DLNMEA_H
+/** @file dlnmea.h
+ *  @brief Constants, structures, function prototypes for the NMEA stream parser
+ *
+ *  DlNmeaFeed takes raw chunks from the receiver, one byte at a time,
+ *  whatever the chunk boundaries. The checksum is accumulated and each
+ *  field decoded to fixed point as its bytes arrive, so nothing is copied
+ *  into a line buffer and a truncated or corrupt sentence is simply
+ *  dropped at the next '$'. GGA and RMC from any talker (GP, GN, GL...)
+ *  are decoded; a sentence is only handed to the callback once its
+ *  checksum has matched.
+ */
+#include <cinttypes>
+#include <cstddef>
+#include "nmea.h"
+
+#define NMEAADDRSZ 5          ///< Talker and sentence, "GPGGA"
+#define NMEAMAXDIGITS 18      ///< Digits kept in a numeric field, the rest are ignored
+#define NMEAPOS_SCALE 10000000  ///< Latitude and longitude in 1e-7 degrees
+
+#define NMEA_HASTIME   0x01
+#define NMEA_HASPOS    0x02   ///< Latitude and longitude with both hemispheres
+#define NMEA_HASALT    0x04
+#define NMEA_HASSPEED  0x08
+#define NMEA_HASCOURSE 0x10
+#define NMEA_HASDATE   0x20
+
+enum dlnmeastate_e
+{
+	DLNMEA_HUNT,      ///< Waiting for '$'
+	DLNMEA_ADDRESS,   ///< Talker and sentence id
+	DLNMEA_FIELD,     ///< Comma separated fields up to '*'
+	DLNMEA_CK1,       ///< First checksum hex digit
+	DLNMEA_CK2,       ///< Second checksum hex digit
+	DLNMEA_SKIP       ///< Sentence we do not decode, wait for the next '$'
+};
+
+/** One decoded sentence, fields not in the sentence or left empty by the
+ *  receiver are missing from present
+ */
+typedef struct dlnmeafix
+{
+	uint8_t type;        ///< NMEA_GPGGA or NMEA_GPRMC, whatever the talker
+	uint8_t present;     ///< NMEA_HAS... bits
+	uint8_t quality;     ///< GGA fix quality, 0 no fix
+	uint8_t satellites;  ///< GGA satellites used
+	char status;         ///< RMC 'A' valid, 'V' warning
+	uint32_t utcms;      ///< ms since midnight UTC
+	uint32_t date;       ///< RMC ddmmyy
+	int32_t lat;         ///< 1e-7 degrees, south negative
+	int32_t lon;         ///< 1e-7 degrees, west negative
+	int32_t altmm;       ///< GGA mm above mean sea level
+	uint32_t speedmk;    ///< RMC knots x 1000
+	uint32_t coursemd;   ///< RMC 1e-3 degrees true
+} dlnmeafix_s;
+
+/** Called from DlNmeaFeed for each sentence that passed its checksum */
+typedef void dlnmea_f(void *context, const dlnmeafix_s *fix);
+
+typedef struct dlnmea
+{
+	uint8_t state;       ///< dlnmeastate_e
+	uint8_t sum;         ///< XOR of the bytes after '$'
+	uint8_t ck;          ///< Checksum received
+	uint8_t field;       ///< Field number, 1 after the address
+	uint8_t len;         ///< Bytes of the sentence so far
+	uint8_t addrlen;
+	char addr[NMEAADDRSZ];
+	char first;          ///< First byte of the current field
+	uint8_t digits;      ///< Digits in the current field
+	int8_t frac;         ///< Digits after the point, -1 before it
+	bool neg;
+	bool bad;            ///< Field held something other than a number
+	int64_t mant;        ///< Digits of the current field without the point
+	int64_t pending;     ///< Latitude or longitude waiting for its hemisphere
+	dlnmeafix_s fix;     ///< Sentence being decoded
+	uint64_t sentences;  ///< Passed checksum and handed to the callback
+	uint64_t ignored;    ///< Well formed sentences of other types, not checked
+	uint64_t badsum;
+	uint64_t malformed;  ///< Overlong, broken address or stray bytes
+} dlnmea_s;
+
+///\cond INTERNAL
+// Function Prototypes
+void DlNmeaInit(dlnmea_s *p);
+size_t DlNmeaFeed(dlnmea_s *p, const char *buf, size_t len, dlnmea_f *cb, void *context);
+///\endcond
+#endif
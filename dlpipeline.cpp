@@ -0,0 +1,459 @@
+/** @file dlpipeline.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Threaded processing, persistence and publish stages for logger readings
+ */
+#include "dlpipeline.h"
+#include <cmath>
+#include <cstring>
+#include <pthread.h>
+#include "dlformat.h"
+#include "dltime.h"
+#include "loggermqtt.h"
+
+static const dlpipecfg_s defcfg = {
+	{ PROCRINGSZ, PROCPOLICY },
+	{ SAVERINGSZ, SAVEPOLICY },
+	{ PUBRINGSZ, PUBPOLICY },
+	{ BATCHRECORDS, BATCHLINGERMS },
+	PUBENCODINGS,
+	{ SPOOLDIR, SPOOLSEGBYTES, SPOOLBUDGET, SPOOLRATE, DLSPOOL_OLDEST },
+	{ DEADBANDHEARTBEATMS, DEADBANDSCALE },
+	{ BUDGETBYTES, BUDGETPERIODSEC, BUDGETDEPTHSEC, BUDGETDECIMATE, BUDGETSUMMARYMS },
+};
+
+static DlRing<reading_s> *procring = NULL;
+static DlRing<reading_s> *savering = NULL;
+static DlRing<reading_s> *pubring = NULL;
+static DlRing<dlalert_s> *alertring = NULL;
+static dlalert_s pendingalert;   // refused by the broker, sent before anything else
+static bool alertpending;
+static pthread_t procthread, savethread, pubthread;
+static dlbatch_s jsonbatch, cborbatch;
+static int encodings;
+static dldeadband_s deadband;
+static char chantopic[DLNFIELDS][CHANNELTOPICSZ];
+static dlbudget_s budget;
+static dlsummary_s summary;
+static uint64_t summaryserial;
+
+/** @brief Keeps the last valid value when a sensor read returns NaN
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param float value new reading
+ *  @param float & last last valid reading, updated
+ *  @return float
+ */
+static float DlHoldValid(float value, float &last)
+{
+	if (std::isnan(value)) {
+		return last;
+	}
+	last = value;
+	return value;
+}
+
+/** @brief Processing stage, cleans readings and fans them out to the I/O stages
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg unused
+ *  @return void *
+ */
+static void *DlProcessStage(void *arg)
+{
+	reading_s creads;
+	float temperature = NAN, humidity = NAN, pressure = NAN;
+
+	while (procring->WaitPop(creads)) {
+		creads.temperature = DlHoldValid(creads.temperature, temperature);
+		creads.humidity = DlHoldValid(creads.humidity, humidity);
+		creads.pressure = DlHoldValid(creads.pressure, pressure);
+		savering->Push(creads);
+		pubring->Push(creads);
+	}
+	return NULL;
+}
+
+/** @brief Persistence stage, appends readings to the log files and applies
+ *  the flush policy while idle. The logs are flushed and synced when the
+ *  pipeline stops.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg unused
+ *  @return void *
+ */
+static void *DlSaveStage(void *arg)
+{
+	reading_s creads;
+
+	DlOpenLoggerData();
+	while (!savering->Closed() || savering->Size() > 0) {
+		if (savering->WaitPop(creads, SAVEPOLLMS)) {
+			DlSaveLoggerData(creads);
+		}
+		DlFlushLoggerData();
+	}
+	DlCloseLoggerData();
+	return NULL;
+}
+
+/** @brief Publishes a payload, spooling it if the broker does not take it
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * topic
+ *  @param const void * payload
+ *  @param size_t len
+ *  @return void
+ */
+static void DlPublishOrSpool(const char *topic, const void *payload, size_t len)
+{
+	if (DlPublishLoggerBatch(topic, payload, len) != MQTTASYNC_SUCCESS) {
+		DlSpoolPut(topic, payload, len);
+	}
+}
+
+/** @brief Publishes a batch if it is full or due, or unconditionally at shutdown
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbatch_s * b
+ *  @param const char * topic
+ *  @param bool force publish any partial batch
+ *  @return void
+ */
+static void DlPublishBatch(dlbatch_s *b, const char *topic, bool force)
+{
+	const char *payload;
+	size_t len;
+
+	if (b->count < b->cfg.records && !force && !DlBatchDue(b)) {
+		return;
+	}
+	if ((payload = DlBatchFinish(b, &len)) != NULL) {
+		DlPublishOrSpool(topic, payload, len);
+		DlBatchReset(b);
+	}
+}
+
+/** @brief Publishes the fields of a reading that left their deadband or
+ *  are due a heartbeat, each on its own topic
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s & creads
+ *  @return void
+ */
+static void DlPublishChannels(const reading_s &creads)
+{
+	char jsondata[FIELDMAXSZ + 48];
+	uint64_t now = DlTimeNow();
+	int i, len;
+
+	for (i = 0; i < DLNFIELDS; i++) {
+		if (DlDeadbandUpdate(&deadband, i, creads.*dlfields[i].member, now) &&
+			(len = DlFormatChannel(creads, i, jsondata, sizeof(jsondata))) > 0) {
+			DlPublishOrSpool(chantopic[i], jsondata, len);
+		}
+	}
+}
+
+/** @brief Sends every queued alert on the alert lane. An alert the broker
+ *  refuses is kept and retried first on the next pass, and spooled only
+ *  when the stage stops.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param bool final spool what cannot be sent
+ *  @return bool false if an alert is still waiting
+ */
+static bool DlPublishAlerts(bool final)
+{
+	char jsondata[ALERTPAYLOADSZ];
+	int len;
+
+	while (alertpending || alertring->Pop(pendingalert)) {
+		alertpending = true;
+		len = DlFormatAlert(pendingalert, jsondata, sizeof(jsondata));
+		if (len > 0 && DlPublishLane(DLLANE_ALERT, ALERTTOPIC, jsondata, len, pendingalert.tns) != MQTTASYNC_SUCCESS) {
+			if (!final) {
+				return false;
+			}
+			DlSpoolPut(ALERTTOPIC, jsondata, len);
+		}
+		alertpending = false;
+	}
+	return true;
+}
+
+/** @brief Sends the summary once it covers cfg.summaryms, or straight away
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param bool force send a partial summary, the mode has stepped up or the stage is stopping
+ *  @return void
+ */
+static void DlPublishSummary(bool force)
+{
+	char jsondata[SUMMARYSZ];
+	int len;
+
+	if (summary.n == 0 || (!force && !DlSummaryDue(&summary, budget.cfg.summaryms))) {
+		return;
+	}
+	len = DlFormatSummary(&summary, summaryserial, jsondata, sizeof(jsondata));
+	if (len > 0) {
+		DlPublishOrSpool(SUMMARYTOPIC, jsondata, len);
+		budget.summaries++;
+	}
+	DlSummaryReset(&summary);
+}
+
+/** @brief Sends spooled payloads on the backlog lane within the drain rate
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+static void DlDrainSpool(void)
+{
+	const char *topic;
+	const void *payload;
+	size_t len;
+	int n;
+
+	for (n = DlSpoolAllowance(); n > 0 && DlMqttRoom() > 0; n--) {
+		if (!DlSpoolPeek(&topic, &payload, &len) ||
+			DlPublishLane(DLLANE_BACKLOG, topic, payload, len, 0) != MQTTASYNC_SUCCESS) {
+			break;
+		}
+		DlSpoolPop();
+	}
+	DlSpoolSync();
+}
+
+/** @brief Publish stage, sends readings to the MQTT broker as JSON, CBOR or
+ *  both on their own topics, one per message or packed into batches of up
+ *  to cfg.records readings. A partial batch goes out once its first
+ *  reading is lingerms old. With PUBCHANNELS each field also goes to its
+ *  own topic when it changes. Every pass serves the lanes in priority
+ *  order: alerts, live payloads, then the spooled backlog. As the uplink
+ *  budget runs low live readings are decimated, then replaced by a
+ *  summary on SUMMARYTOPIC every cfg.summaryms.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg unused
+ *  @return void *
+ */
+static void *DlPublishStage(void *arg)
+{
+	reading_s creads;
+	char jsondata[PAYLOADSTRSZ];
+	bool jsonsingle = (encodings & PUBJSON) && jsonbatch.cfg.records <= 1;
+	bool jsonbatched = (encodings & PUBJSON) && jsonbatch.cfg.records > 1;
+	bool cbor = encodings & PUBCBOR;
+	bool channels = encodings & PUBCHANNELS;
+	bool got;
+	dlbudgetmode_e mode = DLBUDGET_RAW;
+	uint32_t waitms, cborwait, run = 0;
+	int len;
+
+	while (!pubring->Closed() || pubring->Size() > 0) {
+		waitms = jsonbatched ? DlBatchWaitMs(&jsonbatch) : 0;
+		cborwait = cbor ? DlBatchWaitMs(&cborbatch) : 0;
+		if (cborwait > 0 && (waitms == 0 || cborwait < waitms)) {
+			waitms = cborwait;
+		}
+		if (!DlSpoolEmpty() && (waitms == 0 || waitms > SPOOLPOLLMS)) {
+			waitms = SPOOLPOLLMS;
+		}
+		if (alertpending && (waitms == 0 || waitms > ALERTRETRYMS)) {
+			waitms = ALERTRETRYMS;
+		}
+		got = pubring->WaitPop(creads, waitms);
+		DlPublishAlerts(false);
+		if (got) {
+			mode = DlBudgetMode(&budget);
+			run = mode == DLBUDGET_DECIMATE ? run : 0;
+			if (mode == DLBUDGET_SUMMARY) {
+				DlSummaryAdd(&summary, creads);
+				budget.summarised++;
+			} else if (mode == DLBUDGET_DECIMATE && run++ % budget.cfg.decimate != 0) {
+				budget.skipped++;
+			} else {
+				if (jsonsingle && (len = DlFormatLoggerJson(creads, jsondata, sizeof(jsondata))) > 0) {
+					DlPublishOrSpool(TOPIC, jsondata, len);
+				}
+				if (jsonbatched) {
+					DlBatchAdd(&jsonbatch, creads);
+				}
+				if (cbor) {
+					DlBatchAdd(&cborbatch, creads);
+				}
+				if (channels) {
+					DlPublishChannels(creads);
+				}
+			}
+		}
+		DlPublishSummary(mode != DLBUDGET_SUMMARY);
+		DlPublishBatch(&jsonbatch, BATCHTOPIC, false);
+		DlPublishBatch(&cborbatch, CBORTOPIC, false);
+		DlDrainSpool();
+	}
+	DlPublishAlerts(true);
+	DlPublishSummary(true);
+	DlPublishBatch(&jsonbatch, BATCHTOPIC, true);
+	DlPublishBatch(&cborbatch, CBORTOPIC, true);
+	return NULL;
+}
+
+/** @brief Undoes a DlPipelineStart that could not start every stage, the
+ *  stages already running are drained and joined and the rings freed
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int started stage threads running, the save stage then the publish stage
+ *  @return void
+ */
+static void DlPipelineAbort(int started)
+{
+	savering->Close();
+	pubring->Close();
+	if (started > 0) {
+		pthread_join(savethread, NULL);
+	}
+	if (started > 1) {
+		pthread_join(pubthread, NULL);
+	}
+	DlSpoolStop();
+	DlMqttBudget(NULL);
+	delete procring;
+	delete savering;
+	delete pubring;
+	delete alertring;
+	procring = NULL;
+	savering = NULL;
+	pubring = NULL;
+	alertring = NULL;
+}
+
+/** @brief Creates the rings and starts the stage threads
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlpipecfg_s * cfg ring sizes and policies, NULL for defaults
+ *  @return int 1 on success, 0 if a stage could not be started, nothing is left running
+ */
+int DlPipelineStart(const dlpipecfg_s *cfg)
+{
+	uint64_t serial;
+	int i;
+
+	if (cfg == NULL) {
+		cfg = &defcfg;
+	}
+	procring = new DlRing<reading_s>(cfg->proc.capacity, cfg->proc.policy);
+	savering = new DlRing<reading_s>(cfg->save.capacity, cfg->save.policy);
+	pubring = new DlRing<reading_s>(cfg->pub.capacity, cfg->pub.policy);
+	alertring = new DlRing<dlalert_s>(ALERTRINGSZ, DLBP_DROPOLDEST);
+	encodings = cfg->encodings;
+	DlBatchInit(&jsonbatch, &cfg->batch, cfg->batch.records > 1 ? DlGetSerial() : 0, DLENC_JSON);
+	DlBatchInit(&cborbatch, &cfg->batch, encodings & PUBCBOR ? DlGetSerial() : 0, DLENC_CBOR);
+	DlSpoolStart(&cfg->spool);
+	DlDeadbandInit(&deadband, &cfg->deadband);
+	DlBudgetInit(&budget, &cfg->budget);
+	DlSummaryReset(&summary);
+	summaryserial = DlGetSerial();
+	DlMqttBudget(&budget);
+	if (encodings & PUBCHANNELS) {
+		// Every unit would share the same channel topics without its serial
+		if ((serial = DlGetSerial()) == 0) {
+			fprintf(stderr, "pipeline: unit serial unknown, channel topics disabled\n");
+			encodings &= ~PUBCHANNELS;
+		}
+		for (i = 0; serial && i < DLNFIELDS; i++) {
+			snprintf(chantopic[i], CHANNELTOPICSZ, CHANNELTOPIC, serial, dlfields[i].name);
+		}
+	}
+	if (pthread_create(&savethread, NULL, DlSaveStage, NULL) != 0) {
+		DlPipelineAbort(0);
+		return 0;
+	}
+	if (pthread_create(&pubthread, NULL, DlPublishStage, NULL) != 0) {
+		DlPipelineAbort(1);
+		return 0;
+	}
+	if (pthread_create(&procthread, NULL, DlProcessStage, NULL) != 0) {
+		DlPipelineAbort(2);
+		return 0;
+	}
+	return 1;
+}
+
+/** @brief Hands a reading from the acquisition stage to the pipeline
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s & creads
+ *  @return bool false if the reading was dropped
+ */
+bool DlPipelinePush(const reading_s &creads)
+{
+	return procring != NULL && procring->Push(creads);
+}
+
+/** @brief Hands an alert raised on an IMU sample to the publish stage,
+ *  which sends it on its next pass, at the latest with the next reading
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlalert_s & alert
+ *  @return bool false if the pipeline is not running or the alert was dropped
+ */
+bool DlPipelineAlert(const dlalert_s &alert)
+{
+	return alertring != NULL && alertring->Push(alert);
+}
+
+/** @brief Drains every ring and joins the stage threads
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void DlPipelineStop(void)
+{
+	if (procring == NULL) {
+		return;  // never started
+	}
+	procring->Close();
+	pthread_join(procthread, NULL);
+	savering->Close();
+	pubring->Close();
+	pthread_join(savethread, NULL);
+	pthread_join(pubthread, NULL);
+	DlSpoolStop();
+}
+
+/** @brief Prints queue depth and drop counters for every ring
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param FILE * fp
+ *  @return void
+ */
+void DlPipelineReport(FILE *fp)
+{
+	static const char *policy[] = { "block", "dropoldest", "dropnewest" };
+	const struct { const char *name; DlRing<reading_s> *ring; } rings[] = {
+		{ "process", procring },
+		{ "persist", savering },
+		{ "publish", pubring },
+	};
+
+	if (procring == NULL) {
+		return;
+	}
+	fprintf(fp, "%-10s %10s %8s %10s %10s %10s\n", "ring", "policy", "depth", "capacity", "pushed", "dropped");
+	for (const auto &r : rings) {
+		fprintf(fp, "%-10s %10s %8zu %10zu %10" PRIu64 " %10" PRIu64 "\n", r.name, policy[r.ring->Policy()],
+			r.ring->Size(), r.ring->Capacity(), r.ring->Pushed(), r.ring->Dropped());
+	}
+	fprintf(fp, "%-10s %10s %8zu %10zu %10" PRIu64 " %10" PRIu64 "\n", "alert", policy[alertring->Policy()],
+		alertring->Size(), alertring->Capacity(), alertring->Pushed(), alertring->Dropped());
+	DlSpoolReport(fp);
+	DlBudgetReport(&budget, fp);
+	if (encodings & PUBCHANNELS) {
+		DlDeadbandReport(&deadband, fp);
+	}
+}
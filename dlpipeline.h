@@ -0,0 +1,64 @@
+#ifndef DLPIPELINE_H
+#define DLPIPELINE_H
+/** @file dlpipeline.h
+ *  @brief Constants, structures, function prototypes for the logger pipeline
+ *
+ *  acquisition --> processing --+--> persistence
+ *                               +--> publish
+ *
+ *  Each arrow is a DlRing of reading_s served by its own thread, so a slow
+ *  disk or broker only fills its own ring and never delays acquisition.
+ *  Payloads the broker does not take go to the dlspool backlog and are
+ *  sent again, rate limited, once it has room. Alerts raised by the IMU
+ *  channel on every sample take their own ring and lane ahead of both.
+ */
+#include <cstdio>
+#include "dlalert.h"
+#include "dlbatch.h"
+#include "dlbudget.h"
+#include "dldeadband.h"
+#include "dlring.h"
+#include "dlspool.h"
+#include "logger.h"
+
+// Default ring sizes and backpressure policies
+#define PROCRINGSZ 64
+#define PROCPOLICY DLBP_DROPOLDEST
+#define SAVERINGSZ 256
+#define SAVEPOLICY DLBP_DROPNEWEST
+#define PUBRINGSZ 64
+#define PUBPOLICY DLBP_DROPOLDEST
+#define SAVEPOLLMS 250
+#define ALERTRETRYMS 5
+#define PUBJSON 0x01  ///< JSON on TOPIC, or BATCHTOPIC when batching
+#define PUBCBOR 0x02  ///< CBOR on CBORTOPIC
+#define PUBCHANNELS 0x04  ///< Each field on its CHANNELTOPIC, by exception
+#define PUBENCODINGS PUBJSON
+
+typedef struct dlringcfg
+{
+	size_t capacity;          ///< Queued readings
+	dlbackpressure_e policy;  ///< Action when the ring is full
+} dlringcfg_s;
+
+typedef struct dlpipecfg
+{
+	dlringcfg_s proc;  ///< acquisition -> processing
+	dlringcfg_s save;  ///< processing -> persistence
+	dlringcfg_s pub;   ///< processing -> publish
+	dlbatchcfg_s batch; ///< Readings per MQTT message
+	int encodings;      ///< PUBJSON and/or PUBCBOR
+	dlspoolcfg_s spool; ///< Store-and-forward of payloads the broker did not take
+	dldeadbandcfg_s deadband; ///< Channel topic filter
+	dlbudgetcfg_s budget;     ///< Uplink bytes per period and how readings step down near it
+} dlpipecfg_s;
+
+///\cond INTERNAL
+// Function Prototypes
+int DlPipelineStart(const dlpipecfg_s *cfg);
+bool DlPipelinePush(const reading_s &creads);
+bool DlPipelineAlert(const dlalert_s &alert);
+void DlPipelineStop(void);
+void DlPipelineReport(FILE *fp);
+///\endcond
+#endif
@@ -0,0 +1,225 @@
+/** @file dlreactor.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief epoll/timerfd event loop serving every logger device descriptor
+ */
+#include "dlreactor.h"
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+/** @brief Creates the epoll instance and clears the handler table
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlreactor_s * reactor
+ *  @return int 1 on success, 0 on failure
+ */
+int DlReactorInit(dlreactor_s *reactor)
+{
+	int i;
+
+	memset(reactor, 0, sizeof(*reactor));
+	for (i = 0; i < DLREACTORMAXFDS; i++) {
+		reactor->handler[i].fd = -1;
+	}
+	reactor->epfd = epoll_create1(EPOLL_CLOEXEC);
+	return reactor->epfd != -1;
+}
+
+/** @brief Watches a descriptor and calls fn when it becomes ready
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlreactor_s * reactor
+ *  @param int fd
+ *  @param uint32_t events EPOLLIN, EPOLLOUT, ...
+ *  @param dliofn_t fn
+ *  @param void * arg passed to fn
+ *  @return int 1 on success, 0 on failure
+ */
+int DlReactorAddFd(dlreactor_s *reactor, int fd, uint32_t events, dliofn_t fn, void *arg)
+{
+	struct epoll_event ev;
+	int i;
+
+	if (fd < 0) {
+		return 0;
+	}
+	for (i = 0; i < DLREACTORMAXFDS; i++) {
+		if (reactor->handler[i].fd == -1) {
+			break;
+		}
+	}
+	if (i == DLREACTORMAXFDS) {
+		return 0;
+	}
+	reactor->handler[i].fd = fd;
+	reactor->handler[i].timer = 0;
+	reactor->handler[i].fn = fn;
+	reactor->handler[i].arg = arg;
+	ev.events = events;
+	ev.data.ptr = &reactor->handler[i];
+	if (epoll_ctl(reactor->epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		reactor->handler[i].fd = -1;
+		return 0;
+	}
+	return 1;
+}
+
+/** @brief Stops watching a descriptor, timers created by the reactor are closed
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlreactor_s * reactor
+ *  @param int fd
+ *  @return int 1 if fd was watched
+ */
+int DlReactorDelFd(dlreactor_s *reactor, int fd)
+{
+	int i;
+
+	for (i = 0; i < DLREACTORMAXFDS; i++) {
+		if (reactor->handler[i].fd == fd) {
+			epoll_ctl(reactor->epfd, EPOLL_CTL_DEL, fd, NULL);
+			if (reactor->handler[i].timer) {
+				close(fd);
+			}
+			reactor->handler[i].fd = -1;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/** @brief Creates a CLOCK_MONOTONIC timerfd and watches it
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlreactor_s * reactor
+ *  @param uint32_t periodms period in milliseconds, 0 leaves the timer disarmed
+ *  @param dliofn_t fn called once per wakeup, missed expirations are merged
+ *  @param void * arg passed to fn
+ *  @return int timer descriptor, -1 on failure
+ */
+int DlReactorAddTimer(dlreactor_s *reactor, uint32_t periodms, dliofn_t fn, void *arg)
+{
+	struct itimerspec its;
+	int tfd, i;
+
+	tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (tfd == -1) {
+		return -1;
+	}
+	if (!DlReactorAddFd(reactor, tfd, EPOLLIN, fn, arg)) {
+		close(tfd);
+		return -1;
+	}
+	for (i = 0; i < DLREACTORMAXFDS; i++) {
+		if (reactor->handler[i].fd == tfd) {
+			reactor->handler[i].timer = 1;
+		}
+	}
+	if (periodms) {
+		its.it_interval.tv_sec = periodms / 1000;
+		its.it_interval.tv_nsec = (long)(periodms % 1000) * 1000000L;
+		its.it_value = its.it_interval;
+		timerfd_settime(tfd, 0, &its, NULL);
+	}
+	return tfd;
+}
+
+/** @brief Arms a reactor timer to fire once at an absolute monotonic time
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int tfd from DlReactorAddTimer
+ *  @param uint64_t deadline CLOCK_MONOTONIC nanoseconds
+ *  @return int 1 on success, 0 on failure
+ */
+int DlReactorArmTimer(int tfd, uint64_t deadline)
+{
+	struct itimerspec its;
+
+	memset(&its, 0, sizeof(its));
+	its.it_value.tv_sec = deadline / 1000000000ULL;
+	its.it_value.tv_nsec = deadline % 1000000000ULL;
+	// A zero it_value disarms the timer, a past deadline must still fire
+	if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0) {
+		its.it_value.tv_nsec = 1;
+	}
+	return timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL) == 0;
+}
+
+/** @brief Waits for ready descriptors and dispatches their handlers
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlreactor_s * reactor
+ *  @param int timeoutms -1 waits forever
+ *  @return int number of handlers called, -1 on error
+ */
+int DlReactorRunOnce(dlreactor_s *reactor, int timeoutms)
+{
+	struct epoll_event ev[DLREACTORMAXEVENTS];
+	uint64_t expirations;
+	int n, i;
+
+	n = epoll_wait(reactor->epfd, ev, DLREACTORMAXEVENTS, timeoutms);
+	if (n == -1) {
+		return errno == EINTR ? 0 : -1;
+	}
+	for (i = 0; i < n; i++) {
+		dlhandler_s *h = (dlhandler_s *)ev[i].data.ptr;
+		if (h->fd == -1) {
+			continue;
+		}
+		if (h->timer && read(h->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+			continue;
+		}
+		h->fn(h->fd, ev[i].events, h->arg);
+	}
+	return n;
+}
+
+/** @brief Dispatches events until DlReactorStop
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlreactor_s * reactor
+ *  @return void
+ */
+void DlReactorRun(dlreactor_s *reactor)
+{
+	reactor->running = 1;
+	while (reactor->running) {
+		if (DlReactorRunOnce(reactor, -1) == -1) {
+			break;
+		}
+	}
+}
+
+/** @brief Makes DlReactorRun return, safe to call from a signal handler
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlreactor_s * reactor
+ *  @return void
+ */
+void DlReactorStop(dlreactor_s *reactor)
+{
+	reactor->running = 0;
+}
+
+/** @brief Closes the reactor timers and the epoll instance
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlreactor_s * reactor
+ *  @return void
+ */
+void DlReactorClose(dlreactor_s *reactor)
+{
+	int i;
+
+	for (i = 0; i < DLREACTORMAXFDS; i++) {
+		if (reactor->handler[i].fd != -1) {
+			DlReactorDelFd(reactor, reactor->handler[i].fd);
+		}
+	}
+	close(reactor->epfd);
+	reactor->epfd = -1;
+}
@@ -0,0 +1,42 @@
+#ifndef DLREACTOR_H
+#define DLREACTOR_H
+/** @file dlreactor.h
+ *  @brief Constants, structures, function prototypes for the epoll event loop
+ */
+#include <cinttypes>
+#include <csignal>
+#include <sys/epoll.h>
+
+#define DLREACTORMAXFDS 16
+#define DLREACTORMAXEVENTS 8
+
+typedef void (*dliofn_t)(int fd, uint32_t events, void *arg);
+
+typedef struct dlhandler
+{
+	int fd;        ///< Watched descriptor, -1 when the slot is free
+	int timer;     ///< 1 if fd is a timerfd owned by the reactor
+	dliofn_t fn;   ///< Called with the ready events
+	void *arg;     ///< Argument passed to fn
+} dlhandler_s;
+
+typedef struct dlreactor
+{
+	int epfd;
+	dlhandler_s handler[DLREACTORMAXFDS];
+	volatile sig_atomic_t running;
+} dlreactor_s;
+
+///\cond INTERNAL
+// Function Prototypes
+int DlReactorInit(dlreactor_s *reactor);
+int DlReactorAddFd(dlreactor_s *reactor, int fd, uint32_t events, dliofn_t fn, void *arg);
+int DlReactorDelFd(dlreactor_s *reactor, int fd);
+int DlReactorAddTimer(dlreactor_s *reactor, uint32_t periodms, dliofn_t fn, void *arg);
+int DlReactorArmTimer(int tfd, uint64_t deadline);
+int DlReactorRunOnce(dlreactor_s *reactor, int timeoutms);
+void DlReactorRun(dlreactor_s *reactor);
+void DlReactorStop(dlreactor_s *reactor);
+void DlReactorClose(dlreactor_s *reactor);
+///\endcond
+#endif
@@ -0,0 +1,222 @@
+/** @file dlrecord.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Binary record log encoding and decoding
+ */
+#include "dlrecord.h"
+#include <cstring>
+#include "dlformat.h"
+
+static void DlPutLe16(uint8_t *p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void DlPutLe32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static void DlPutLe64(uint8_t *p, uint64_t v)
+{
+	DlPutLe32(p, (uint32_t)v);
+	DlPutLe32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t DlGetLe16(const uint8_t *p)
+{
+	return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t DlGetLe32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t DlGetLe64(const uint8_t *p)
+{
+	return (uint64_t)DlGetLe32(p) | (uint64_t)DlGetLe32(p + 4) << 32;
+}
+
+typedef struct dlcrctable
+{
+	uint32_t v[256];
+} dlcrctable_s;
+
+/** @brief Builds the byte at a time CRC-32 table
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return dlcrctable_s
+ */
+static dlcrctable_s DlCrc32Table(void)
+{
+	dlcrctable_s t;
+	uint32_t c;
+	int i, k;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (k = 0; k < 8; k++) {
+			c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		}
+		t.v[i] = c;
+	}
+	return t;
+}
+
+/** @brief Computes the IEEE 802.3 CRC-32 (same as zlib crc32). Safe from
+ *  any thread, the table is built once by the first caller and the others
+ *  wait for it.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const void * data
+ *  @param size_t len
+ *  @return uint32_t crc
+ */
+uint32_t DlCrc32(const void *data, size_t len)
+{
+	static const dlcrctable_s table = DlCrc32Table();
+	const uint8_t *p = (const uint8_t *)data;
+	uint32_t crc = 0xFFFFFFFF;
+
+	while (len--) {
+		crc = table.v[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+	}
+	return crc ^ 0xFFFFFFFF;
+}
+
+/** @brief Builds the segment header
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint8_t * buf at least RECHDRSZ bytes
+ *  @param uint64_t serial unit serial from DlGetSerial
+ *  @return size_t header size
+ */
+size_t DlRecordHeader(uint8_t *buf, uint64_t serial)
+{
+	uint8_t *p = buf + RECFIXEDHDRSZ;
+	int i;
+
+	memset(buf, 0, RECHDRSZ);
+	memcpy(buf, RECMAGIC, 4);
+	DlPutLe16(buf + 4, RECVERSION);
+	DlPutLe16(buf + 6, RECHDRSZ);
+	DlPutLe64(buf + 8, serial);
+	DlPutLe16(buf + 16, RECSIZE);
+	DlPutLe16(buf + 18, RECNFIELDS);
+	strncpy((char *)p, "tns", RECNAMESZ);
+	p[RECNAMESZ] = RECTYPEU64;
+	p += RECFIELDSZ;
+	strncpy((char *)p, "toffset", RECNAMESZ);
+	p[RECNAMESZ] = RECTYPEI64;
+	p += RECFIELDSZ;
+	for (i = 0; i < RECFLOATS; i++) {
+		strncpy((char *)p, dlfields[i].name, RECNAMESZ);
+		p[RECNAMESZ] = RECTYPEF32;
+		p += RECFIELDSZ;
+	}
+	return RECHDRSZ;
+}
+
+/** @brief Encodes one reading as a RECSIZE byte record
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s & creads
+ *  @param uint8_t * buf at least RECSIZE bytes
+ *  @return void
+ */
+void DlRecordEncode(const reading_s &creads, uint8_t *buf)
+{
+	uint8_t *p = buf;
+	uint32_t bits;
+	int i;
+
+	DlPutLe64(p, creads.tns);
+	DlPutLe64(p + 8, (uint64_t)creads.toffset);
+	p += 16;
+	for (i = 0; i < RECFLOATS; i++) {
+		memcpy(&bits, &(creads.*dlfields[i].member), 4);
+		DlPutLe32(p, bits);
+		p += 4;
+	}
+	DlPutLe32(p, DlCrc32(buf, p - buf));
+}
+
+/** @brief Decodes and checks one record
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const uint8_t * buf RECSIZE bytes
+ *  @param reading_s & creads
+ *  @return int 1 on success, 0 if the CRC does not match
+ */
+int DlRecordDecode(const uint8_t *buf, reading_s &creads)
+{
+	const uint8_t *p = buf + 16;
+	uint32_t bits;
+	int i;
+
+	if (DlCrc32(buf, RECSIZE - 4) != DlGetLe32(buf + RECSIZE - 4)) {
+		return 0;
+	}
+	memset(&creads, 0, sizeof(creads));
+	creads.tns = DlGetLe64(buf);
+	creads.toffset = (int64_t)DlGetLe64(buf + 8);
+	for (i = 0; i < RECFLOATS; i++) {
+		bits = DlGetLe32(p);
+		memcpy(&(creads.*dlfields[i].member), &bits, 4);
+		p += 4;
+	}
+	return 1;
+}
+
+/** @brief Reads and validates a segment header, leaves gz at the first
+ *  record. gz may be a gzipped or a plain segment. Header bytes past the
+ *  known fields are read and dropped rather than seeked over, so a pipe
+ *  works as well as a file.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param gzFile gz
+ *  @param dlrechdr_s * hdr
+ *  @return int 1 on success, 0 if this is not a readable segment
+ */
+int DlRecordReadHeader(gzFile gz, dlrechdr_s *hdr)
+{
+	uint8_t buf[RECFIXEDHDRSZ];
+	uint8_t field[RECFIELDSZ];
+	size_t skip, n;
+	int i;
+
+	if (gzread(gz, buf, RECFIXEDHDRSZ) != RECFIXEDHDRSZ || memcmp(buf, RECMAGIC, 4) != 0) {
+		return 0;
+	}
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->version = DlGetLe16(buf + 4);
+	hdr->hdrsize = DlGetLe16(buf + 6);
+	hdr->serial = DlGetLe64(buf + 8);
+	hdr->recsize = DlGetLe16(buf + 16);
+	hdr->nfields = DlGetLe16(buf + 18);
+	if (hdr->version != RECVERSION || hdr->recsize != RECSIZE || hdr->nfields != RECNFIELDS ||
+		hdr->hdrsize < RECHDRSZ) {
+		return 0;
+	}
+	for (i = 0; i < RECNFIELDS; i++) {
+		if (gzread(gz, field, RECFIELDSZ) != RECFIELDSZ) {
+			return 0;
+		}
+		memcpy(hdr->name[i], field, RECNAMESZ);
+		hdr->name[i][RECNAMESZ] = '\0';
+		hdr->type[i] = field[RECNAMESZ];
+	}
+	for (skip = hdr->hdrsize - RECHDRSZ; skip > 0; skip -= n) {
+		n = skip < sizeof(field) ? skip : sizeof(field);
+		if (gzread(gz, field, n) != (int)n) {
+			return 0;
+		}
+	}
+	return 1;
+}
@@ -0,0 +1,50 @@
+#ifndef DLRECORD_H
+#define DLRECORD_H
+/** @file dlrecord.h
+ *  @brief Constants, structures, function prototypes for the binary record log
+ *
+ *  A segment is a header followed by fixed size records, all little endian.
+ *
+ *  header: magic "VDLR", u16 version, u16 header size, u64 unit serial,
+ *          u16 record size, u16 field count, field count x { char name[15], u8 type }
+ *  record: u64 tns, i64 toffset, one f32 per reading field, u32 CRC-32 of the
+ *          preceding record bytes
+ */
+#include <cinttypes>
+#include <cstddef>
+#include <zlib.h>
+#include "logger.h"
+
+#define RECMAGIC "VDLR"
+#define RECVERSION 1
+#define RECNAMESZ 15
+#define RECFIELDSZ (RECNAMESZ + 1)
+#define RECFIXEDHDRSZ 20
+#define RECTYPEU64 'u'
+#define RECTYPEI64 'i'
+#define RECTYPEF32 'f'
+#define RECFLOATS DLNFIELDS
+#define RECNFIELDS (2 + RECFLOATS)
+#define RECHDRSZ (RECFIXEDHDRSZ + RECNFIELDS * RECFIELDSZ)
+#define RECSIZE (8 + 8 + RECFLOATS * 4 + 4)
+
+typedef struct dlrechdr
+{
+	uint16_t version;   ///< Schema version
+	uint16_t hdrsize;   ///< Bytes before the first record
+	uint64_t serial;    ///< Unit serial from DlGetSerial
+	uint16_t recsize;   ///< Bytes per record including the CRC
+	uint16_t nfields;   ///< Fields per record
+	char name[RECNFIELDS][RECFIELDSZ]; ///< Field names, NUL terminated
+	char type[RECNFIELDS];             ///< RECTYPE* per field
+} dlrechdr_s;
+
+///\cond INTERNAL
+// Function Prototypes
+uint32_t DlCrc32(const void *data, size_t len);
+size_t DlRecordHeader(uint8_t *buf, uint64_t serial);
+void DlRecordEncode(const reading_s &creads, uint8_t *buf);
+int DlRecordDecode(const uint8_t *buf, reading_s &creads);
+int DlRecordReadHeader(gzFile gz, dlrechdr_s *hdr);
+///\endcond
+#endif
@@ -0,0 +1,208 @@
+#ifndef DLRING_H
+#define DLRING_H
+/** @file dlring.h
+ *  @brief Bounded single producer / single consumer ring buffer
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *
+ *  Push and Pop are lock free. The mutex and condition variable are only
+ *  touched when a thread has to sleep in WaitPop or in a blocking Push, and
+ *  only when the other side is known to be asleep.
+ */
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <ctime>
+#include <pthread.h>
+#include <type_traits>
+
+enum dlbackpressure_e
+{
+	DLBP_BLOCK,       ///< Producer waits for room
+	DLBP_DROPOLDEST,  ///< Oldest queued item is discarded to make room
+	DLBP_DROPNEWEST   ///< Item being pushed is discarded
+};
+
+template <typename T>
+class DlRing
+{
+	static_assert(std::is_trivially_copyable<T>::value, "DlRing items are copied by value");
+
+public:
+	/** @brief Creates a ring, capacity is rounded up to a power of two
+	 *  @param size_t capacity minimum number of queued items
+	 *  @param dlbackpressure_e policy applied by Push when the ring is full
+	 */
+	DlRing(size_t capacity, dlbackpressure_e policy = DLBP_DROPOLDEST)
+	{
+		size_t cap = 1;
+		while (cap < capacity) { cap <<= 1; }
+		slot = new T[cap];
+		mask = cap - 1;
+		bp = policy;
+		head = 0;
+		tail = 0;
+		pushed = 0;
+		dropped = 0;
+		sleepers = 0;
+		closed = false;
+		pthread_mutex_init(&lock, NULL);
+		pthread_condattr_t attr;
+		pthread_condattr_init(&attr);
+		pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+		pthread_cond_init(&cond, &attr);
+		pthread_condattr_destroy(&attr);
+	}
+
+	~DlRing(void)
+	{
+		pthread_cond_destroy(&cond);
+		pthread_mutex_destroy(&lock);
+		delete[] slot;
+	}
+
+	DlRing(const DlRing &) = delete;
+	DlRing &operator=(const DlRing &) = delete;
+
+	/** @brief Queues a copy of item, producer thread only
+	 *  @param const T & item
+	 *  @return bool false if item was dropped or the ring is closed
+	 */
+	bool Push(const T &item)
+	{
+		uint64_t h = head.load(std::memory_order_relaxed);
+		uint64_t t;
+
+		while (h - (t = tail.load(std::memory_order_acquire)) > mask) {
+			if (closed.load()) {
+				return false;
+			}
+			if (bp == DLBP_DROPNEWEST) {
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			if (bp == DLBP_DROPOLDEST) {
+				// Races with the consumer for the oldest slot, whoever moves tail owns it
+				if (tail.compare_exchange_weak(t, t + 1)) {
+					dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+				continue;
+			}
+			Sleep(h, true, 0);
+		}
+		slot[h & mask] = item;
+		head.store(h + 1);
+		pushed.fetch_add(1, std::memory_order_relaxed);
+		Wake();
+		return true;
+	}
+
+	/** @brief Takes the oldest item without waiting, consumer thread only
+	 *  @param T & item receives the copy
+	 *  @return bool false if the ring was empty
+	 */
+	bool Pop(T &item)
+	{
+		uint64_t t = tail.load(std::memory_order_acquire);
+
+		while (t != head.load(std::memory_order_acquire)) {
+			item = slot[t & mask];
+			// A failed exchange means a drop-oldest Push took this slot, the copy is discarded
+			if (tail.compare_exchange_weak(t, t + 1)) {
+				Wake();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** @brief Takes the oldest item, sleeping while the ring is empty
+	 *  @param T & item receives the copy
+	 *  @param uint32_t timeoutms 0 waits until an item arrives or Close
+	 *  @return bool false on timeout or when closed and drained
+	 */
+	bool WaitPop(T &item, uint32_t timeoutms = 0)
+	{
+		while (!Pop(item)) {
+			if (closed.load() && Size() == 0) {
+				return false;
+			}
+			if (!Sleep(tail.load(), false, timeoutms)) {
+				return Pop(item);
+			}
+		}
+		return true;
+	}
+
+	/** @brief Wakes every waiter, later Push calls fail and WaitPop drains then fails */
+	void Close(void)
+	{
+		closed.store(true);
+		pthread_mutex_lock(&lock);
+		pthread_cond_broadcast(&cond);
+		pthread_mutex_unlock(&lock);
+	}
+
+	size_t Size(void) const { return (size_t)(head.load() - tail.load()); }
+	bool Closed(void) const { return closed.load(); }
+	size_t Capacity(void) const { return mask + 1; }
+	uint64_t Pushed(void) const { return pushed.load(std::memory_order_relaxed); }
+	uint64_t Dropped(void) const { return dropped.load(std::memory_order_relaxed); }
+	dlbackpressure_e Policy(void) const { return bp; }
+
+private:
+	/** @brief Sleeps until the watched index moves, Close, or the timeout
+	 *  @param uint64_t seen value of head (producer) or tail (consumer) already checked
+	 *  @param bool producer true to wait for room, false to wait for data
+	 *  @param uint32_t timeoutms 0 for no timeout
+	 *  @return bool false on timeout
+	 */
+	bool Sleep(uint64_t seen, bool producer, uint32_t timeoutms)
+	{
+		struct timespec ts;
+		int rc = 0;
+
+		if (timeoutms) {
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			ts.tv_sec += timeoutms / 1000;
+			ts.tv_nsec += (long)(timeoutms % 1000) * 1000000L;
+			if (ts.tv_nsec >= 1000000000L) {
+				ts.tv_sec++;
+				ts.tv_nsec -= 1000000000L;
+			}
+		}
+		pthread_mutex_lock(&lock);
+		sleepers.fetch_add(1);
+		while (rc == 0 && !closed.load()) {
+			if (producer ? (seen - tail.load() <= mask) : (head.load() != seen)) {
+				break;
+			}
+			rc = timeoutms ? pthread_cond_timedwait(&cond, &lock, &ts) : pthread_cond_wait(&cond, &lock);
+		}
+		sleepers.fetch_sub(1);
+		pthread_mutex_unlock(&lock);
+		return rc != ETIMEDOUT;
+	}
+
+	void Wake(void)
+	{
+		if (sleepers.load() > 0) {
+			pthread_mutex_lock(&lock);
+			pthread_cond_broadcast(&cond);
+			pthread_mutex_unlock(&lock);
+		}
+	}
+
+	T *slot;
+	uint64_t mask;
+	dlbackpressure_e bp;
+	std::atomic<uint64_t> head;
+	std::atomic<uint64_t> tail;
+	std::atomic<uint64_t> pushed;
+	std::atomic<uint64_t> dropped;
+	std::atomic<int> sleepers;
+	std::atomic<bool> closed;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+};
+#endif
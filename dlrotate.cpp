@@ -0,0 +1,314 @@
+/** @file dlrotate.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Log rotation into dated segments, background gzip and retention
+ */
+#include "dlrotate.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "dlring.h"
+#include "dltime.h"
+
+typedef struct dlsegname
+{
+	char path[ROTATENAMESZ];  ///< Segment waiting to be compressed
+} dlsegname_s;
+
+static const dlrotatepolicy_s defpolicy = { ROTATEBYTES, ROTATEMS, ROTATEBUDGET, ROTATELEVEL };
+
+static dlrotatepolicy_s rotpolicy = defpolicy;
+static DlRing<dlsegname_s> *segring = NULL;
+static pthread_t rotthread;
+static std::atomic<uint64_t> rotated(0);
+static std::atomic<uint64_t> compressed(0);
+static std::atomic<uint64_t> rawbytes(0);
+static std::atomic<uint64_t> gzbytes(0);
+static std::atomic<uint64_t> deleted(0);
+static std::atomic<uint64_t> failed(0);
+
+/** @brief scandir filter for finished segments
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const struct dirent * d
+ *  @return int non zero to keep the entry
+ */
+static int DlRotateFilter(const struct dirent *d)
+{
+	size_t len = strlen(d->d_name);
+
+	return strncmp(d->d_name, ROTATEPREFIX, strlen(ROTATEPREFIX)) == 0 &&
+		!(len > 5 && strcmp(d->d_name + len - 5, ".part") == 0);
+}
+
+/** @brief Checks whether a segment name is in use, compressed or not
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * path
+ *  @return int 1 if path or path.gz exists
+ */
+static int DlRotateTaken(const char *path)
+{
+	char gz[ROTATENAMESZ + sizeof(ROTATEGZ)];
+
+	snprintf(gz, sizeof(gz), "%s" ROTATEGZ, path);
+	return access(path, F_OK) == 0 || access(gz, F_OK) == 0;
+}
+
+/** @brief Checks whether a segment has been compressed
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * name
+ *  @return int 1 if name ends in ROTATEGZ
+ */
+static int DlRotateIsGz(const char *name)
+{
+	size_t len = strlen(name);
+
+	return len >= strlen(ROTATEGZ) && strcmp(name + len - strlen(ROTATEGZ), ROTATEGZ) == 0;
+}
+
+/** @brief gzips a segment to path.gz and removes the original
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * path
+ *  @return int 1 on success, 0 on failure
+ */
+static int DlRotateCompress(const char *path)
+{
+	static char buf[ROTATEBUFSZ];
+	char dst[ROTATENAMESZ + sizeof(ROTATEGZ)];
+	char part[sizeof(dst) + 5];
+	char mode[16];
+	struct stat st;
+	gzFile gz;
+	ssize_t n;
+	int fd;
+	int ok = 1;
+
+	if (rotpolicy.level <= 0) {
+		return 1;
+	}
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		return errno == ENOENT;  // already removed by retention
+	}
+	snprintf(dst, sizeof(dst), "%s" ROTATEGZ, path);
+	snprintf(part, sizeof(part), "%s.part", dst);
+	snprintf(mode, sizeof(mode), "wb%d", rotpolicy.level > 9 ? 9 : rotpolicy.level);
+	gz = gzopen(part, mode);
+	if (gz == NULL) {
+		close(fd);
+		return 0;
+	}
+	while ((n = read(fd, buf, sizeof(buf))) != 0) {
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			ok = 0;
+			break;
+		}
+		if (gzwrite(gz, buf, n) != n) {
+			ok = 0;
+			break;
+		}
+		rawbytes += n;
+	}
+	close(fd);
+	if (gzclose(gz) != Z_OK) {
+		ok = 0;
+	}
+	if (!ok || rename(part, dst) != 0) {
+		unlink(part);
+		return 0;
+	}
+	if (stat(dst, &st) == 0) {
+		gzbytes += st.st_size;
+	}
+	unlink(path);
+	compressed++;
+	return 1;
+}
+
+/** @brief Deletes the oldest segments while all segments exceed the budget
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int pending non zero to also compress segments left uncompressed
+ *  @return void
+ */
+static void DlRotateRetain(int pending)
+{
+	struct dirent **list;
+	struct stat st;
+	uint64_t total = 0;
+	int n, i;
+
+	if (pending && rotpolicy.level > 0) {
+		n = scandir(".", &list, DlRotateFilter, alphasort);
+		for (i = 0; i < n; i++) {
+			if (!DlRotateIsGz(list[i]->d_name)) {
+				if (!DlRotateCompress(list[i]->d_name)) {
+					failed++;
+				}
+			}
+			free(list[i]);
+		}
+		if (n >= 0) {
+			free(list);
+		}
+	}
+	if (rotpolicy.budget == 0) {
+		return;
+	}
+	// Names sort by their UTC stamp, so the list runs oldest first
+	n = scandir(".", &list, DlRotateFilter, alphasort);
+	if (n < 0) {
+		return;
+	}
+	for (i = 0; i < n; i++) {
+		if (stat(list[i]->d_name, &st) == 0) {
+			total += st.st_size;
+		}
+	}
+	for (i = 0; i < n; i++) {
+		// Segments still waiting for compression count against the budget but are kept
+		if (total > rotpolicy.budget && (rotpolicy.level <= 0 || DlRotateIsGz(list[i]->d_name)) &&
+			stat(list[i]->d_name, &st) == 0 && unlink(list[i]->d_name) == 0) {
+			total -= st.st_size;
+			deleted++;
+		}
+		free(list[i]);
+	}
+	free(list);
+}
+
+/** @brief Compression thread, runs at the lowest CPU priority
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg unused
+ *  @return void *
+ */
+static void *DlRotateThread(void *arg)
+{
+	dlsegname_s seg;
+
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), ROTATENICE);
+	DlRotateRetain(1);
+	while (segring->WaitPop(seg)) {
+		if (!DlRotateCompress(seg.path)) {
+			failed++;
+		}
+		DlRotateRetain(0);
+	}
+	return NULL;
+}
+
+/** @brief Sets the rotation policy and starts the compression thread
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlrotatepolicy_s * policy NULL for the defaults
+ *  @return int 1 on success, 0 on failure
+ */
+int DlRotateStart(const dlrotatepolicy_s *policy)
+{
+	rotpolicy = policy ? *policy : defpolicy;
+	segring = new DlRing<dlsegname_s>(ROTATEQUEUESZ, DLBP_DROPNEWEST);
+	if (pthread_create(&rotthread, NULL, DlRotateThread, NULL) != 0) {
+		delete segring;
+		segring = NULL;
+		return 0;
+	}
+	return 1;
+}
+
+/** @brief Checks whether an active log should be rotated
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint64_t bytes current size of the active log
+ *  @param uint64_t openedns CLOCK_MONOTONIC ns the active log was started
+ *  @return int 1 if the log is due
+ */
+int DlRotateDue(uint64_t bytes, uint64_t openedns)
+{
+	if (rotpolicy.maxbytes && bytes >= rotpolicy.maxbytes) {
+		return 1;
+	}
+	return rotpolicy.maxms && DlTimeNow() - openedns >= rotpolicy.maxms * NSPERMS;
+}
+
+/** @brief Renames a closed log to a dated segment and queues it for compression
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * path active log, e.g. loggerdata.vdl
+ *  @return int 1 on success, 0 if the log could not be renamed
+ */
+int DlRotateSegment(const char *path)
+{
+	dlsegname_s seg;
+	const char *ext = strrchr(path, '.');
+	char stamp[24];
+	struct tm tm;
+	time_t secs = (time_t)(DlTimeEpochMs(DlTimeNow(), DlTimeOffset()) / 1000);
+	int stemlen;
+
+	if (ext == NULL) {
+		ext = path + strlen(path);
+	}
+	stemlen = (int)(ext - path);
+	// A name already taken moves the stamp on a second, keeping names in time order
+	do {
+		gmtime_r(&secs, &tm);
+		strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", &tm);
+		snprintf(seg.path, sizeof(seg.path), "%.*s-%s%s", stemlen, path, stamp, ext);
+		secs++;
+	} while (DlRotateTaken(seg.path));
+	if (rename(path, seg.path) != 0) {
+		failed++;
+		return 0;
+	}
+	rotated++;
+	if (segring != NULL) {
+		segring->Push(seg);  // a dropped name is compressed on the next start
+	}
+	return 1;
+}
+
+/** @brief Drains the compression queue and joins the thread
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void DlRotateStop(void)
+{
+	if (segring != NULL) {
+		segring->Close();
+		pthread_join(rotthread, NULL);
+		delete segring;
+		segring = NULL;
+	}
+}
+
+/** @brief Prints rotation, compression and retention counters
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param FILE * fp
+ *  @return void
+ */
+void DlRotateReport(FILE *fp)
+{
+	fprintf(fp, "rotate: segments %" PRIu64 " compressed %" PRIu64 " (%" PRIu64 " -> %" PRIu64 " bytes) deleted %" PRIu64
+		" failed %" PRIu64 " queued %zu dropped %" PRIu64 "\n", rotated.load(), compressed.load(), rawbytes.load(),
+		gzbytes.load(), deleted.load(), failed.load(), segring ? segring->Size() : 0, segring ? segring->Dropped() : 0);
+}
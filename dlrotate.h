@@ -0,0 +1,41 @@
+#ifndef DLROTATE_H
+#define DLROTATE_H
+/** @file dlrotate.h
+ *  @brief Constants, structures, function prototypes for log rotation
+ *
+ *  A log that grows past maxbytes or maxms is renamed to a dated segment,
+ *  e.g. loggerdata.vdl -> loggerdata-20261017T140502Z.vdl. A low priority
+ *  thread gzips segments and deletes the oldest ones while the segments
+ *  use more than the disk budget.
+ */
+#include <cinttypes>
+#include <cstdio>
+
+#define ROTATEBYTES (16 * 1024 * 1024)
+#define ROTATEMS (60 * 60 * 1000)
+#define ROTATEBUDGET (UINT64_C(1024) * 1024 * 1024)
+#define ROTATELEVEL 6
+#define ROTATENICE 19
+#define ROTATEQUEUESZ 16
+#define ROTATEBUFSZ 65536
+#define ROTATENAMESZ 96
+#define ROTATEPREFIX "loggerdata-"
+#define ROTATEGZ ".gz"
+
+typedef struct dlrotatepolicy
+{
+	uint64_t maxbytes;  ///< Rotate once the active log reaches this size, 0 never
+	uint32_t maxms;     ///< Rotate once the active log is this old, 0 never
+	uint64_t budget;    ///< Bytes all segments may use, 0 keeps everything
+	int level;          ///< gzip level 1..9, 0 leaves segments uncompressed
+} dlrotatepolicy_s;
+
+///\cond INTERNAL
+// Function Prototypes
+int DlRotateStart(const dlrotatepolicy_s *policy);
+int DlRotateDue(uint64_t bytes, uint64_t openedns);
+int DlRotateSegment(const char *path);
+void DlRotateStop(void);
+void DlRotateReport(FILE *fp);
+///\endcond
+#endif
@@ -0,0 +1,237 @@
+/** @file dlsched.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Deadline driven task scheduler for the data logger main loop
+ */
+#include "dlsched.h"
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+/** @brief Clears the task table
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlsched_s * sched
+ *  @return void
+ */
+void DlSchedInit(dlsched_s *sched)
+{
+	memset(sched, 0, sizeof(*sched));
+	sched->tfd = -1;
+}
+
+/** @brief Adds a periodic task, released first when DlSchedRun starts
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlsched_s * sched
+ *  @param const char * name used in reports
+ *  @param uint32_t periodms release period in milliseconds
+ *  @param dltaskfn_t fn task body
+ *  @param void * arg passed to fn
+ *  @return int task index, -1 if the table is full
+ */
+int DlSchedAddTask(dlsched_s *sched, const char *name, uint32_t periodms, dltaskfn_t fn, void *arg)
+{
+	dltask_s *t;
+
+	if (sched->ntasks >= DLSCHEDMAXTASKS || periodms == 0) {
+		return -1;
+	}
+	t = &sched->task[sched->ntasks];
+	memset(t, 0, sizeof(*t));
+	t->name = name;
+	t->fn = fn;
+	t->arg = arg;
+	t->period = periodms * NSPERMS;
+	t->permin = UINT64_MAX;
+	return sched->ntasks++;
+}
+
+/** @brief Runs one release of a task and advances its deadline
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dltask_s * t
+ *  @return void
+ */
+static void DlSchedRelease(dltask_s *t)
+{
+	uint64_t start, end, lat, missed;
+
+	start = DlTimeNow();
+	lat = start - t->deadline;
+	t->latsum += lat;
+	if (lat > t->latmax) { t->latmax = lat; }
+	if (t->runs > 0) {
+		uint64_t per = start - t->lastrun;
+		if (per < t->permin) { t->permin = per; }
+		if (per > t->permax) { t->permax = per; }
+	}
+	t->lastrun = start;
+	t->runs++;
+
+	t->fn(t->arg);
+
+	end = DlTimeNow();
+	if (end - start > t->execmax) { t->execmax = end - start; }
+
+	// Next release stays on the absolute grid, releases already missed are
+	// counted and skipped instead of being run back to back.
+	t->deadline += t->period;
+	if (t->deadline <= end) {
+		missed = (end - t->deadline) / t->period + 1;
+		t->overruns += missed;
+		t->deadline += missed * t->period;
+	}
+}
+
+/** @brief Finds the earliest release time of all tasks
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlsched_s * sched
+ *  @return uint64_t deadline, UINT64_MAX if there are no tasks
+ */
+static uint64_t DlSchedNextDeadline(const dlsched_s *sched)
+{
+	uint64_t next = UINT64_MAX;
+	int i;
+
+	for (i = 0; i < sched->ntasks; i++) {
+		if (sched->task[i].deadline < next) { next = sched->task[i].deadline; }
+	}
+	return next;
+}
+
+/** @brief Releases every task whose deadline has passed
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlsched_s * sched
+ *  @return void
+ */
+static void DlSchedReleaseDue(dlsched_s *sched)
+{
+	uint64_t now = DlTimeNow();
+	int i;
+
+	for (i = 0; i < sched->ntasks && sched->running; i++) {
+		if (sched->task[i].deadline <= now) {
+			DlSchedRelease(&sched->task[i]);
+		}
+	}
+}
+
+/** @brief Sets the first release of every task to now
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlsched_s * sched
+ *  @return void
+ */
+static void DlSchedStart(dlsched_s *sched)
+{
+	uint64_t now = DlTimeNow();
+	int i;
+
+	for (i = 0; i < sched->ntasks; i++) {
+		sched->task[i].deadline = now;
+	}
+	sched->running = 1;
+}
+
+/** @brief Sleeps until the earliest deadline and releases every due task,
+ *  returns after DlSchedStop
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlsched_s * sched
+ *  @return void
+ */
+void DlSchedRun(dlsched_s *sched)
+{
+	uint64_t next;
+	struct timespec ts;
+
+	DlSchedStart(sched);
+	while (sched->running) {
+		next = DlSchedNextDeadline(sched);
+		if (next == UINT64_MAX) {
+			break;
+		}
+		ts.tv_sec = next / NSPERSEC;
+		ts.tv_nsec = next % NSPERSEC;
+		if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+			continue;
+		}
+		DlSchedReleaseDue(sched);
+	}
+}
+
+/** @brief Reactor timer handler, releases due tasks and re-arms for the next deadline
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int fd timerfd
+ *  @param uint32_t events unused
+ *  @param void * arg dlsched_s
+ *  @return void
+ */
+static void DlSchedTimerEvent(int fd, uint32_t events, void *arg)
+{
+	dlsched_s *sched = (dlsched_s *)arg;
+
+	DlSchedReleaseDue(sched);
+	if (sched->running && sched->ntasks > 0) {
+		DlReactorArmTimer(fd, DlSchedNextDeadline(sched));
+	}
+}
+
+/** @brief Drives the tasks from an absolute timerfd in a reactor instead of
+ *  DlSchedRun, the reactor loop then serves device I/O between releases
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlsched_s * sched
+ *  @param dlreactor_s * reactor
+ *  @return int 1 on success, 0 on failure
+ */
+int DlSchedAttach(dlsched_s *sched, dlreactor_s *reactor)
+{
+	DlSchedStart(sched);
+	sched->tfd = DlReactorAddTimer(reactor, 0, DlSchedTimerEvent, sched);
+	if (sched->tfd == -1) {
+		return 0;
+	}
+	return DlReactorArmTimer(sched->tfd, DlSchedNextDeadline(sched));
+}
+
+/** @brief Makes DlSchedRun return, safe to call from a signal handler
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlsched_s * sched
+ *  @return void
+ */
+void DlSchedStop(dlsched_s *sched)
+{
+	sched->running = 0;
+}
+
+/** @brief Prints period, jitter and overrun statistics for every task
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlsched_s * sched
+ *  @param FILE * fp
+ *  @return void
+ */
+void DlSchedReport(const dlsched_s *sched, FILE *fp)
+{
+	int i;
+
+	fprintf(fp, "%-10s %8s %10s %10s %10s %10s %10s %10s %8s\n", "task", "period", "runs",
+		"permin", "permax", "latavg", "latmax", "execmax", "overrun");
+	for (i = 0; i < sched->ntasks; i++) {
+		const dltask_s *t = &sched->task[i];
+		fprintf(fp, "%-10s %6" PRIu64 "ms %10" PRIu64 " %8.3fms %8.3fms %8.3fms %8.3fms %8.3fms %8" PRIu64 "\n",
+			t->name, t->period / NSPERMS, t->runs,
+			t->runs > 1 ? (double)t->permin / NSPERMS : 0.0,
+			(double)t->permax / NSPERMS,
+			t->runs ? (double)t->latsum / t->runs / NSPERMS : 0.0,
+			(double)t->latmax / NSPERMS,
+			(double)t->execmax / NSPERMS,
+			t->overruns);
+	}
+}
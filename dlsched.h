@@ -0,0 +1,50 @@
+#ifndef DLSCHED_H
+#define DLSCHED_H
+/** @file dlsched.h
+ *  @brief Constants, structures, function prototypes for the deadline scheduler
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <csignal>
+#include "dlreactor.h"
+#include "dltime.h"
+
+#define DLSCHEDMAXTASKS 12
+
+typedef void (*dltaskfn_t)(void *);
+
+typedef struct dltask
+{
+	const char *name;    ///< Task name for reports
+	dltaskfn_t fn;       ///< Task body
+	void *arg;           ///< Argument passed to fn
+	uint64_t period;     ///< Release period ns
+	uint64_t deadline;   ///< Next absolute release, CLOCK_MONOTONIC ns
+	uint64_t lastrun;    ///< Time of the previous release ns
+	uint64_t runs;       ///< Number of releases
+	uint64_t overruns;   ///< Releases missed because the task ran late
+	uint64_t latsum;     ///< Sum of release latencies ns
+	uint64_t latmax;     ///< Worst release latency ns
+	uint64_t execmax;    ///< Worst execution time ns
+	uint64_t permin;     ///< Shortest measured period ns
+	uint64_t permax;     ///< Longest measured period ns
+} dltask_s;
+
+typedef struct dlsched
+{
+	dltask_s task[DLSCHEDMAXTASKS];
+	int ntasks;
+	int tfd;  ///< Reactor timer when attached with DlSchedAttach
+	volatile sig_atomic_t running;
+} dlsched_s;
+
+///\cond INTERNAL
+// Function Prototypes
+void DlSchedInit(dlsched_s *sched);
+int DlSchedAddTask(dlsched_s *sched, const char *name, uint32_t periodms, dltaskfn_t fn, void *arg);
+void DlSchedRun(dlsched_s *sched);
+int DlSchedAttach(dlsched_s *sched, dlreactor_s *reactor);
+void DlSchedStop(dlsched_s *sched);
+void DlSchedReport(const dlsched_s *sched, FILE *fp);
+///\endcond
+#endif
@@ -0,0 +1,627 @@
+/** @file dlspool.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Crash-safe on-disk queue of MQTT payloads the broker did not take
+ *
+ *  Only the publish stage calls the spool, DlSpoolReport may run on any thread.
+ */
+#include "dlspool.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "dlrecord.h"
+#include "dltime.h"
+
+static const dlspoolcfg_s defcfg = { SPOOLDIR, SPOOLSEGBYTES, SPOOLBUDGET, SPOOLRATE, DLSPOOL_OLDEST };
+
+static dlspoolcfg_s spcfg = defcfg;
+static int rfd = -1;           // oldest segment
+static int wfd = -1;           // newest segment, the same file as rfd when first == last
+static uint32_t first, last;   // segment numbers, every number in between exists
+static uint64_t head;          // read cursor in the oldest segment
+static uint64_t wsize;         // bytes in the newest segment
+static uint64_t peekoff;       // record returned by DlSpoolPeek
+static uint64_t peeksize;
+static int sincecursor;
+static bool dirty;
+static uint64_t lastsync;
+static double tokens;
+static uint64_t lastfill;
+static uint8_t rec[SPOOLRECOVERHEAD + SPOOLTOPICSZ + 1 + SPOOLMAXPAYLOAD];
+static char topicbuf[SPOOLTOPICSZ + 1];
+static std::atomic<uint64_t> queued(0);    // bytes waiting
+static std::atomic<uint32_t> segments(0);
+static std::atomic<uint64_t> spooled(0);
+static std::atomic<uint64_t> drained(0);
+static std::atomic<uint64_t> lost(0);      // bytes deleted to stay in the budget
+static std::atomic<uint64_t> corrupt(0);   // bytes skipped as torn or damaged
+static std::atomic<uint64_t> refused(0);   // payloads too large or not written
+
+/** @brief Little endian helpers for the record framing
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ */
+static void DlSpoolPutLe32(uint8_t *p, uint32_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+static uint32_t DlSpoolGetLe32(const uint8_t *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/** @brief Builds the path of a segment
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param char * path
+ *  @param uint32_t seg
+ *  @return char * path
+ */
+static char *DlSpoolPath(char *path, uint32_t seg)
+{
+	snprintf(path, SPOOLNAMESZ, "%s/%010" PRIu32 ".q", spcfg.dir, seg);
+	return path;
+}
+
+/** @brief Opens a segment
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint32_t seg
+ *  @param int flags open flags
+ *  @return int fd, -1 on error
+ */
+static int DlSpoolOpenSeg(uint32_t seg, int flags)
+{
+	char path[SPOOLNAMESZ];
+
+	return open(DlSpoolPath(path, seg), flags, 0644);
+}
+
+/** @brief Size of an open segment
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int fd
+ *  @return uint64_t bytes, 0 on error
+ */
+static uint64_t DlSpoolSize(int fd)
+{
+	struct stat st;
+
+	return fd >= 0 && fstat(fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+/** @brief Reads and checks the record at off
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int fd
+ *  @param uint64_t off
+ *  @param uint64_t end end of the valid bytes
+ *  @return uint64_t record size, 0 if truncated or damaged. The record is left in rec.
+ */
+static uint64_t DlSpoolRead(int fd, uint64_t off, uint64_t end)
+{
+	uint32_t len;
+	uint64_t size;
+
+	if (end - off < SPOOLRECOVERHEAD || pread(fd, rec, 8, off) != 8) {
+		return 0;
+	}
+	len = DlSpoolGetLe32(rec);
+	size = (uint64_t)len + SPOOLRECOVERHEAD - 2;
+	if (len < 2 || size > sizeof(rec) || size > end - off || pread(fd, rec, size, off) != (ssize_t)size) {
+		return 0;
+	}
+	if (DlCrc32(rec + 8, len) != DlSpoolGetLe32(rec + 4) || DlSpoolGetLe32(rec + size - 4) != len ||
+		(size_t)(rec[8] | rec[9] << 8) > SPOOLTOPICSZ || (size_t)(rec[8] | rec[9] << 8) > len - 2) {
+		return 0;
+	}
+	return size;
+}
+
+/** @brief Finds the next record that checks out, past a damaged one.
+ *  Offsets are first screened in memory for a len whose trailing copy
+ *  matches, only those are read and checked in full.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int fd
+ *  @param uint64_t off first byte to try
+ *  @param uint64_t end end of the valid bytes
+ *  @return uint64_t offset of the next good record, end if there is none
+ */
+static uint64_t DlSpoolResync(int fd, uint64_t off, uint64_t end)
+{
+	uint8_t buf[SPOOLSCANSZ + 3], trailer[4];
+	uint64_t base, at, size;
+	uint32_t len;
+	ssize_t got;
+	size_t i;
+
+	for (base = off; base < end; base += SPOOLSCANSZ) {
+		got = pread(fd, buf, end - base < sizeof(buf) ? end - base : sizeof(buf), base);
+		if (got < 4) {
+			break;
+		}
+		for (i = 0; i < SPOOLSCANSZ && i + 4 <= (size_t)got; i++) {
+			at = base + i;
+			len = DlSpoolGetLe32(buf + i);
+			size = (uint64_t)len + SPOOLRECOVERHEAD - 2;
+			if (len < 2 || size > sizeof(rec) || size > end - at) {
+				continue;
+			}
+			if (i + size <= (size_t)got) {
+				memcpy(trailer, buf + i + size - 4, 4);
+			} else if (pread(fd, trailer, 4, at + size - 4) != 4) {
+				continue;
+			}
+			if (DlSpoolGetLe32(trailer) == len && DlSpoolRead(fd, at, end) == size) {
+				return at;
+			}
+		}
+	}
+	return end;
+}
+
+/** @brief Walks the records of a segment, resyncing past damaged ones
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int fd
+ *  @param uint64_t off first record
+ *  @param uint64_t end end of the valid bytes
+ *  @return uint64_t end of the last record that checks out, off if none
+ */
+static uint64_t DlSpoolLastGood(int fd, uint64_t off, uint64_t end)
+{
+	uint64_t good = off, size;
+
+	while (off < end) {
+		if ((size = DlSpoolRead(fd, off, end)) > 0) {
+			off += size;
+			good = off;
+		} else {
+			off = DlSpoolResync(fd, off + 1, end);
+		}
+	}
+	return good;
+}
+
+/** @brief Saves the read cursor, written to a temporary file then renamed
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+static void DlSpoolSaveCursor(void)
+{
+	char path[SPOOLNAMESZ], tmp[SPOOLNAMESZ];
+	char line[48];
+	int fd, n;
+
+	snprintf(path, sizeof(path), "%s/cursor", spcfg.dir);
+	snprintf(tmp, sizeof(tmp), "%s/cursor.part", spcfg.dir);
+	n = snprintf(line, sizeof(line), "%" PRIu32 " %" PRIu64 "\n", first, head);
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return;
+	}
+	if (write(fd, line, n) == n && fdatasync(fd) == 0) {
+		close(fd);
+		rename(tmp, path);
+	} else {
+		close(fd);
+	}
+	sincecursor = 0;
+}
+
+/** @brief Deletes the oldest segment and moves on to the next one
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return uint64_t unread bytes the segment held
+ */
+static uint64_t DlSpoolDropFirst(void)
+{
+	char path[SPOOLNAMESZ];
+	uint64_t size = DlSpoolSize(rfd);
+	uint64_t unread = size > head ? size - head : 0;
+
+	close(rfd);
+	unlink(DlSpoolPath(path, first));
+	first++;
+	head = 0;
+	rfd = DlSpoolOpenSeg(first, O_RDONLY);
+	queued -= unread;
+	segments--;
+	DlSpoolSaveCursor();
+	return unread;
+}
+
+/** @brief Deletes the empty newest segment and appends to the one before
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+static void DlSpoolDropLast(void)
+{
+	char path[SPOOLNAMESZ];
+
+	close(wfd);
+	unlink(DlSpoolPath(path, last));
+	last--;
+	wfd = DlSpoolOpenSeg(last, O_RDWR);
+	wsize = DlSpoolSize(wfd);
+	segments--;
+}
+
+/** @brief Cuts a torn or damaged tail off the newest segment, damaged
+ *  records before the last good one are left for DlSpoolPeek to skip
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint64_t from first byte to check
+ *  @return void
+ */
+static void DlSpoolRecover(uint64_t from)
+{
+	uint64_t off = DlSpoolLastGood(wfd, from, wsize);
+
+	if (off < wsize) {
+		corrupt += wsize - off;
+		if (ftruncate(wfd, off) == 0) {
+			fdatasync(wfd);
+		}
+		wsize = off;
+	}
+}
+
+/** @brief scandir filter for segment files
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const struct dirent * d
+ *  @return int non zero to keep the entry
+ */
+static int DlSpoolFilter(const struct dirent *d)
+{
+	size_t len = strlen(d->d_name);
+
+	return len == 12 && strspn(d->d_name, "0123456789") == 10 && strcmp(d->d_name + 10, ".q") == 0;
+}
+
+/** @brief Opens the spool and recovers the backlog left by an earlier run
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlspoolcfg_s * cfg NULL for the defaults, a NULL dir disables the spool
+ *  @return int 1 on success, 0 if the spool is disabled or the directory is unusable
+ */
+int DlSpoolStart(const dlspoolcfg_s *cfg)
+{
+	struct dirent **names;
+	char path[SPOOLNAMESZ];
+	uint32_t seg, cseg;
+	uint64_t coff, total = 0;
+	FILE *fp;
+	int n, i, fd;
+
+	spcfg = cfg ? *cfg : defcfg;
+	if (spcfg.dir == NULL) {
+		return 0;
+	}
+	if (spcfg.segbytes == 0) {
+		spcfg.segbytes = SPOOLSEGBYTES;
+	}
+	if (mkdir(spcfg.dir, 0755) != 0 && errno != EEXIST) {
+		perror(spcfg.dir);
+		spcfg.dir = NULL;
+		return 0;
+	}
+	first = 1;
+	last = 0;
+	n = scandir(spcfg.dir, &names, DlSpoolFilter, alphasort);
+	for (i = 0; i < n; i++) {
+		seg = (uint32_t)strtoul(names[i]->d_name, NULL, 10);
+		if (i == 0) {
+			first = seg;
+		}
+		last = seg;
+		free(names[i]);
+	}
+	if (n >= 0) {
+		free(names);
+	}
+	if (last < first) {
+		last = first;
+	}
+	head = 0;
+	snprintf(path, sizeof(path), "%s/cursor", spcfg.dir);
+	if ((fp = fopen(path, "r")) != NULL) {
+		if (fscanf(fp, "%" SCNu32 " %" SCNu64, &cseg, &coff) == 2 && cseg >= first && cseg <= last) {
+			for (; first < cseg; first++) {  // drained before a crash, not yet deleted
+				unlink(DlSpoolPath(path, first));
+			}
+			head = coff;
+		}
+		fclose(fp);
+	}
+	for (seg = first; seg <= last; seg++) {
+		if ((fd = DlSpoolOpenSeg(seg, O_RDONLY)) >= 0) {
+			total += DlSpoolSize(fd);
+			close(fd);
+		}
+	}
+	wfd = DlSpoolOpenSeg(last, O_RDWR | O_CREAT);
+	rfd = DlSpoolOpenSeg(first, O_RDONLY);
+	if (wfd < 0 || rfd < 0) {
+		perror(spcfg.dir);
+		DlSpoolStop();
+		spcfg.dir = NULL;
+		return 0;
+	}
+	wsize = DlSpoolSize(wfd);
+	if (head > DlSpoolSize(rfd)) {
+		head = 0;
+	}
+	total -= wsize;
+	DlSpoolRecover(first == last ? head : 0);
+	queued = total + wsize - head;
+	segments = last - first + 1;
+	lastsync = DlTimeNow();
+	lastfill = lastsync;
+	tokens = spcfg.rate;
+	return 1;
+}
+
+/** @brief Appends a payload the broker did not take. Past the budget the
+ *  oldest segment is deleted to make room.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * topic
+ *  @param const void * payload
+ *  @param size_t len
+ *  @return int 1 if spooled, 0 if the spool is disabled, the payload too large or the write failed
+ */
+int DlSpoolPut(const char *topic, const void *payload, size_t len)
+{
+	size_t tlen = strlen(topic);
+	uint32_t body = (uint32_t)(2 + tlen + len);
+	uint64_t size = (uint64_t)body + SPOOLRECOVERHEAD - 2;
+	int fd;
+
+	if (spcfg.dir == NULL || wfd < 0) {
+		return 0;
+	}
+	if (tlen > SPOOLTOPICSZ || len > SPOOLMAXPAYLOAD) {
+		refused++;
+		return 0;
+	}
+	if (wsize > 0 && wsize + size > spcfg.segbytes) {
+		// Until the next segment opens keep appending to this one, the next Put retries
+		if ((fd = DlSpoolOpenSeg(last + 1, O_RDWR | O_CREAT | O_TRUNC)) >= 0) {
+			fdatasync(wfd);
+			close(wfd);
+			wfd = fd;
+			last++;
+			wsize = 0;
+			segments++;
+		}
+	}
+	while (spcfg.budget && queued + size > spcfg.budget && first < last) {
+		lost += DlSpoolDropFirst();
+	}
+	DlSpoolPutLe32(rec, body);
+	rec[8] = (uint8_t)tlen;
+	rec[9] = (uint8_t)(tlen >> 8);
+	memcpy(rec + SPOOLRECHDR, topic, tlen);
+	memcpy(rec + SPOOLRECHDR + tlen, payload, len);
+	DlSpoolPutLe32(rec + 4, DlCrc32(rec + 8, body));
+	DlSpoolPutLe32(rec + size - 4, body);
+	if (pwrite(wfd, rec, size, wsize) != (ssize_t)size) {
+		if (ftruncate(wfd, wsize) != 0) {
+			dirty = true;
+		}
+		refused++;
+		return 0;
+	}
+	wsize += size;
+	queued += size;
+	spooled++;
+	dirty = true;
+	return 1;
+}
+
+/** @brief Returns the next payload to send in the configured order,
+ *  skipping damaged records and only their bytes. It stays queued until
+ *  DlSpoolPop.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char ** topic receives the topic
+ *  @param const void ** payload receives the payload, valid until the next spool call
+ *  @param size_t * len receives the payload length
+ *  @return int 1 if a payload is waiting, 0 if the spool is empty
+ */
+int DlSpoolPeek(const char **topic, const void **payload, size_t *len)
+{
+	uint64_t end, lo, size, next;
+	uint8_t trailer[4];
+	uint32_t body;
+	size_t tlen;
+
+	if (spcfg.dir == NULL || wfd < 0 || rfd < 0) {
+		return 0;
+	}
+	for (;;) {
+		if (spcfg.order == DLSPOOL_OLDEST) {
+			end = first == last ? wsize : DlSpoolSize(rfd);
+			if (head >= end) {
+				if (first == last) {
+					return 0;
+				}
+				DlSpoolDropFirst();
+				continue;
+			}
+			if ((size = DlSpoolRead(rfd, head, end)) == 0) {
+				next = DlSpoolResync(rfd, head + 1, end);
+				corrupt += next - head;
+				queued -= next - head;
+				head = next;
+				continue;
+			}
+			peekoff = head;
+		} else {
+			lo = first == last ? head : 0;
+			end = wsize;
+			if (end <= lo) {
+				if (first == last) {
+					return 0;
+				}
+				DlSpoolDropLast();
+				continue;
+			}
+			size = 0;
+			if (end - lo >= SPOOLRECOVERHEAD && pread(wfd, trailer, 4, end - 4) == 4) {
+				body = DlSpoolGetLe32(trailer);
+				if ((uint64_t)body + SPOOLRECOVERHEAD - 2 <= end - lo) {
+					peekoff = end - body - (SPOOLRECOVERHEAD - 2);
+					size = DlSpoolRead(wfd, peekoff, end);
+				}
+			}
+			if (size == 0) {
+				next = DlSpoolLastGood(wfd, lo, end);
+				corrupt += end - next;
+				queued -= end - next;
+				wsize = next;
+				if (ftruncate(wfd, next) != 0) {
+					return 0;
+				}
+				continue;
+			}
+		}
+		peeksize = size;
+		tlen = rec[8] | rec[9] << 8;
+		memcpy(topicbuf, rec + SPOOLRECHDR, tlen);
+		topicbuf[tlen] = '\0';
+		*topic = topicbuf;
+		*payload = rec + SPOOLRECHDR + tlen;
+		*len = size - SPOOLRECOVERHEAD - tlen;
+		return 1;
+	}
+}
+
+/** @brief Removes the payload returned by DlSpoolPeek once the broker took it
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void DlSpoolPop(void)
+{
+	if (peeksize == 0) {
+		return;
+	}
+	if (spcfg.order == DLSPOOL_OLDEST) {
+		head = peekoff + peeksize;
+		if (++sincecursor >= SPOOLCURSOREVERY) {
+			DlSpoolSaveCursor();
+		}
+	} else {
+		wsize = peekoff;
+		if (ftruncate(wfd, wsize) == 0) {
+			dirty = true;
+		}
+	}
+	queued -= peeksize;
+	peeksize = 0;
+	drained++;
+	if (tokens >= 1) {
+		tokens--;
+	}
+}
+
+/** @brief Checks for a backlog
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return int 1 if nothing is queued
+ */
+int DlSpoolEmpty(void)
+{
+	return queued.load() == 0;
+}
+
+/** @brief Backlog messages that may be sent now without passing the rate
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return int
+ */
+int DlSpoolAllowance(void)
+{
+	uint64_t now = DlTimeNow();
+
+	if (spcfg.rate == 0) {
+		return SPOOLMAXPAYLOAD;
+	}
+	tokens += (double)(now - lastfill) * spcfg.rate / NSPERSEC;
+	if (tokens > spcfg.rate) {
+		tokens = spcfg.rate;  // at most one second of burst
+	}
+	lastfill = now;
+	return (int)tokens;
+}
+
+/** @brief Syncs recent appends to disk at most every SPOOLSYNCMS
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void DlSpoolSync(void)
+{
+	uint64_t now = DlTimeNow();
+
+	if (dirty && wfd >= 0 && now - lastsync >= SPOOLSYNCMS * NSPERMS) {
+		fdatasync(wfd);
+		dirty = false;
+		lastsync = now;
+	}
+}
+
+/** @brief Syncs the backlog and the cursor and closes the segments
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void DlSpoolStop(void)
+{
+	if (wfd >= 0) {
+		fdatasync(wfd);
+		close(wfd);
+	}
+	if (rfd >= 0) {
+		DlSpoolSaveCursor();
+		close(rfd);
+	}
+	wfd = -1;
+	rfd = -1;
+}
+
+/** @brief Prints the backlog and its counters
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param FILE * fp
+ *  @return void
+ */
+void DlSpoolReport(FILE *fp)
+{
+	fprintf(fp, "spool: queued %" PRIu64 " bytes in %" PRIu32 " segments spooled %" PRIu64 " drained %" PRIu64
+		" lost %" PRIu64 " bytes corrupt %" PRIu64 " bytes refused %" PRIu64 "\n", queued.load(), segments.load(),
+		spooled.load(), drained.load(), lost.load(), corrupt.load(), refused.load());
+}
@@ -0,0 +1,67 @@
+#ifndef DLSPOOL_H
+#define DLSPOOL_H
+/** @file dlspool.h
+ *  @brief Constants, structures, function prototypes for the MQTT store-and-forward spool
+ *
+ *  Payloads the broker could not take are appended to numbered segment
+ *  files in dir, e.g. loggerspool/0000000042.q. Each record is
+ *
+ *  len(le32) crc32(le32) topiclen(le16) topic payload len(le32)
+ *
+ *  with len and crc covering topiclen, topic and payload. The trailing
+ *  len lets the newest record be found from the end of a segment.
+ *  Oldest-first draining moves a read cursor through the oldest segment
+ *  and deletes it once drained. The cursor is saved every
+ *  SPOOLCURSOREVERY records, so a crash may resend a few payloads, which
+ *  QoS 1 subscribers must handle anyway. Newest-first draining truncates
+ *  the newest segment behind each record sent. A record torn by a crash
+ *  fails its CRC and is cut off on the next start. A damaged record
+ *  elsewhere is skipped by scanning forward, SPOOLSCANSZ bytes a read, to
+ *  the next offset whose len, trailing len and CRC check out.
+ */
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+
+#define SPOOLDIR "loggerspool"
+#define SPOOLSEGBYTES (1024 * 1024)
+#define SPOOLBUDGET (UINT64_C(64) * 1024 * 1024)
+#define SPOOLRATE 50              ///< Backlog messages/s once the broker is back
+#define SPOOLPOLLMS 50            ///< Publish stage wake up while a backlog is waiting
+#define SPOOLSYNCMS 1000
+#define SPOOLCURSOREVERY 32
+#define SPOOLTOPICSZ 128
+#define SPOOLMAXPAYLOAD 65536
+#define SPOOLNAMESZ 128
+#define SPOOLRECHDR 10            ///< len, crc, topiclen
+#define SPOOLRECOVERHEAD 14       ///< SPOOLRECHDR plus the trailing len
+#define SPOOLSCANSZ 4096
+
+enum dlspoolorder_e
+{
+	DLSPOOL_OLDEST,  ///< Send the backlog in the order it was captured
+	DLSPOOL_NEWEST   ///< Send the most recent payloads first
+};
+
+typedef struct dlspoolcfg
+{
+	const char *dir;        ///< Segment directory, NULL disables the spool
+	uint64_t segbytes;      ///< Start a new segment past this size
+	uint64_t budget;        ///< Bytes the spool may use, the oldest segment goes first
+	uint32_t rate;          ///< Backlog messages/s, 0 unlimited
+	dlspoolorder_e order;
+} dlspoolcfg_s;
+
+///\cond INTERNAL
+// Function Prototypes
+int DlSpoolStart(const dlspoolcfg_s *cfg);
+int DlSpoolPut(const char *topic, const void *payload, size_t len);
+int DlSpoolPeek(const char **topic, const void **payload, size_t *len);
+void DlSpoolPop(void);
+int DlSpoolEmpty(void);
+int DlSpoolAllowance(void);
+void DlSpoolSync(void);
+void DlSpoolStop(void);
+void DlSpoolReport(FILE *fp);
+///\endcond
+#endif
@@ -0,0 +1,120 @@
+/** @file dltime.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Monotonic nanosecond timestamps and the monotonic to UTC offset
+ */
+#include "dltime.h"
+#include <atomic>
+#include <ctime>
+
+static std::atomic<int64_t> utcoffset(0);   // UTC minus CLOCK_MONOTONIC, ns
+static std::atomic<int> utcsource(DLTIME_NONE);
+static std::atomic<uint64_t> gpslast(0);     // Monotonic time of the last GPS discipline
+
+/** @brief Reads the monotonic clock
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return uint64_t CLOCK_MONOTONIC nanoseconds
+ */
+uint64_t DlTimeNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * NSPERSEC + ts.tv_nsec;
+}
+
+/** @brief Refreshes the UTC offset from CLOCK_REALTIME, unless GPS has
+ *  disciplined it within the last TIMEGPSHOLDMS
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void DlTimeSync(void)
+{
+	struct timespec rt;
+	uint64_t before, after, real;
+
+	before = DlTimeNow();
+	if (utcsource.load() == DLTIME_GPS && before - gpslast.load() < TIMEGPSHOLDMS * NSPERMS) {
+		return;
+	}
+	clock_gettime(CLOCK_REALTIME, &rt);
+	after = DlTimeNow();
+	real = (uint64_t)rt.tv_sec * NSPERSEC + rt.tv_nsec;
+	// The realtime read sits between the two monotonic reads
+	utcoffset.store((int64_t)(real - (before + (after - before) / 2)));
+	utcsource.store(DLTIME_SYSTEM);
+}
+
+/** @brief Disciplines the UTC offset from a GPS fix time. Errors over
+ *  TIMESTEPNS step the offset, smaller errors are slewed by 1/TIMESLEWDIV.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint64_t utcns fix time, ns since the epoch
+ *  @param uint64_t tns CLOCK_MONOTONIC time the fix was received
+ *  @return void
+ */
+void DlTimeDiscipline(uint64_t utcns, uint64_t tns)
+{
+	int64_t target = (int64_t)(utcns - tns);
+	int64_t err = target - utcoffset.load();
+
+	if (utcsource.load() != DLTIME_GPS || err > (int64_t)TIMESTEPNS || err < -(int64_t)TIMESTEPNS) {
+		utcoffset.store(target);
+	} else {
+		utcoffset.fetch_add(err / TIMESLEWDIV);
+	}
+	utcsource.store(DLTIME_GPS);
+	gpslast.store(tns);
+}
+
+/** @brief Gets the current monotonic to UTC offset
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return int64_t UTC minus CLOCK_MONOTONIC, ns
+ */
+int64_t DlTimeOffset(void)
+{
+	if (utcsource.load() == DLTIME_NONE) {
+		DlTimeSync();
+	}
+	return utcoffset.load();
+}
+
+/** @brief Gets where the current offset came from
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return int dltimesrc_e
+ */
+int DlTimeSource(void)
+{
+	return utcsource.load();
+}
+
+/** @brief Converts a monotonic timestamp to epoch milliseconds
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint64_t tns CLOCK_MONOTONIC ns
+ *  @param int64_t offset from DlTimeOffset when tns was taken
+ *  @return uint64_t ms since 1970-01-01 UTC
+ */
+uint64_t DlTimeEpochMs(uint64_t tns, int64_t offset)
+{
+	return (tns + offset) / NSPERMS;
+}
+
+/** @brief Converts a monotonic timestamp to epoch microseconds
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint64_t tns CLOCK_MONOTONIC ns
+ *  @param int64_t offset from DlTimeOffset when tns was taken
+ *  @return uint64_t us since 1970-01-01 UTC
+ */
+uint64_t DlTimeEpochUs(uint64_t tns, int64_t offset)
+{
+	return (tns + offset) / NSPERUS;
+}
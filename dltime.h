@@ -0,0 +1,37 @@
+#ifndef DLTIME_H
+#define DLTIME_H
+/** @file dltime.h
+ *  @brief Constants, function prototypes for monotonic timestamps and UTC mapping
+ *
+ *  Every record is stamped with CLOCK_MONOTONIC nanoseconds. The offset that
+ *  maps monotonic time onto UTC is refreshed from the system clock by
+ *  DlTimeSync, or disciplined from GPS fix times by DlTimeDiscipline.
+ */
+#include <cinttypes>
+
+#define NSPERUS UINT64_C(1000)
+#define NSPERMS UINT64_C(1000000)
+#define NSPERSEC UINT64_C(1000000000)
+#define TIMESYNCPERIODMS 10000
+#define TIMEGPSHOLDMS 5000
+#define TIMESTEPNS NSPERSEC
+#define TIMESLEWDIV 8
+
+enum dltimesrc_e
+{
+	DLTIME_NONE,    ///< Offset not set yet
+	DLTIME_SYSTEM,  ///< Offset taken from CLOCK_REALTIME
+	DLTIME_GPS      ///< Offset disciplined from GPS fix times
+};
+
+///\cond INTERNAL
+// Function Prototypes
+uint64_t DlTimeNow(void);
+void DlTimeSync(void);
+void DlTimeDiscipline(uint64_t utcns, uint64_t tns);
+int64_t DlTimeOffset(void);
+int DlTimeSource(void);
+uint64_t DlTimeEpochMs(uint64_t tns, int64_t offset);
+uint64_t DlTimeEpochUs(uint64_t tns, int64_t offset);
+///\endcond
+#endif
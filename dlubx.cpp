@@ -0,0 +1,301 @@
+/** @file dlubx.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Byte at a time u-blox UBX frame decoder, NAV-PVT to integers
+ */
+#include "dlubx.h"
+#include <cstring>
+
+/** @brief Sets up a decoder waiting for the first sync byte
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlubx_s * u
+ *  @return void
+ */
+void DlUbxInit(dlubx_s *u)
+{
+	memset(u, 0, sizeof(*u));
+	u->state = DLUBX_SYNC1;
+}
+
+/** @brief Little endian unsigned field of a payload
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const uint8_t * p
+ *  @param int bytes 1, 2 or 4
+ *  @return uint32_t
+ */
+static inline uint32_t DlUbxU(const uint8_t *p, int bytes)
+{
+	uint32_t v = 0;
+	int i;
+
+	for (i = bytes - 1; i >= 0; i--) {
+		v = v << 8 | p[i];
+	}
+	return v;
+}
+
+/** @brief Copies the NAV-PVT fields out of a checked payload
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const uint8_t * p UBXNAVPVTSZ bytes
+ *  @param dlubxpvt_s * pvt
+ *  @return void
+ */
+static void DlUbxPvt(const uint8_t *p, dlubxpvt_s *pvt)
+{
+	pvt->itow = DlUbxU(p, 4);
+	pvt->year = (uint16_t)DlUbxU(p + 4, 2);
+	pvt->month = p[6];
+	pvt->day = p[7];
+	pvt->hour = p[8];
+	pvt->min = p[9];
+	pvt->sec = p[10];
+	pvt->valid = p[11];
+	pvt->tacc = DlUbxU(p + 12, 4);
+	pvt->nano = (int32_t)DlUbxU(p + 16, 4);
+	pvt->fixtype = p[20];
+	pvt->flags = p[21];
+	pvt->numsv = p[23];
+	pvt->lon = (int32_t)DlUbxU(p + 24, 4);
+	pvt->lat = (int32_t)DlUbxU(p + 28, 4);
+	pvt->height = (int32_t)DlUbxU(p + 32, 4);
+	pvt->hmsl = (int32_t)DlUbxU(p + 36, 4);
+	pvt->hacc = DlUbxU(p + 40, 4);
+	pvt->vacc = DlUbxU(p + 44, 4);
+	pvt->gspeed = (int32_t)DlUbxU(p + 60, 4);
+	pvt->headmot = (int32_t)DlUbxU(p + 64, 4);
+	pvt->sacc = DlUbxU(p + 68, 4);
+	pvt->headacc = DlUbxU(p + 72, 4);
+	pvt->pdop = (uint16_t)DlUbxU(p + 76, 2);
+}
+
+/** @brief Acts on a frame whose checksum matched
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlubx_s * u
+ *  @param dlubx_f * cb
+ *  @param void * context
+ *  @return size_t 1 if a NAV-PVT went to cb
+ */
+static size_t DlUbxDispatch(dlubx_s *u, dlubx_f *cb, void *context)
+{
+	u->frames++;
+	if (u->cls == UBXACK) {
+		if (u->id == UBXACKACK) {
+			u->acks++;
+		} else if (u->id == UBXACKNAK) {
+			u->naks++;
+		}
+		return 0;
+	}
+	if (u->cls != UBXNAV || u->id != UBXNAVPVT) {
+		return 0;
+	}
+	if (u->len != UBXNAVPVTSZ) {
+		u->malformed++;
+		return 0;
+	}
+	DlUbxPvt(u->payload, &u->pvt);
+	u->pvts++;
+	if (cb != NULL) {
+		cb(context, &u->pvt);
+	}
+	return 1;
+}
+
+/** @brief Runs bytes through the frame state machine, stopping after a
+ *  frame that fails its checksum or has an oversized length
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlubx_s * u
+ *  @param const uint8_t * buf
+ *  @param size_t len
+ *  @param size_t * used receives the bytes taken
+ *  @param size_t * emitted NAV-PVT messages handed to cb are added to it
+ *  @param dlubx_f * cb
+ *  @param void * context
+ *  @return bool true if it stopped on a failed frame, its bytes are in u
+ */
+static bool DlUbxScan(dlubx_s *u, const uint8_t *buf, size_t len, size_t *used, size_t *emitted, dlubx_f *cb,
+	void *context)
+{
+	size_t i, k, n;
+	uint8_t a, b, c;
+
+	for (i = 0; i < len; i++) {
+		c = buf[i];
+		switch (u->state) {
+		case DLUBX_SYNC1:
+			if (c == UBXSYNC1) {
+				u->state = DLUBX_SYNC2;
+			}
+			break;
+		case DLUBX_SYNC2:
+			u->state = c == UBXSYNC2 ? DLUBX_HEADER : c == UBXSYNC1 ? DLUBX_SYNC2 : DLUBX_SYNC1;
+			u->hdr = 0;
+			u->cka = 0;
+			u->ckb = 0;
+			break;
+		case DLUBX_HEADER:
+			u->cka += c;
+			u->ckb += u->cka;
+			switch (u->hdr++) {
+			case 0:
+				u->cls = c;
+				break;
+			case 1:
+				u->id = c;
+				break;
+			case 2:
+				u->len = c;
+				break;
+			case 3:
+				u->len |= (uint16_t)c << 8;
+				u->got = 0;
+				u->hdr = 0;
+				if (u->len > UBXMAXPAYLOAD) {
+					u->malformed++;
+					u->state = DLUBX_SYNC1;
+					*used = i + 1;
+					return true;
+				}
+				u->state = u->len ? DLUBX_PAYLOAD : DLUBX_CK;
+				break;
+			}
+			break;
+		case DLUBX_PAYLOAD:
+			// take as much of the payload as this chunk holds in one go
+			n = len - i < (size_t)(u->len - u->got) ? len - i : (size_t)(u->len - u->got);
+			memcpy(u->payload + u->got, buf + i, n);
+			a = u->cka;
+			b = u->ckb;
+			for (k = 0; k < n; k++) {
+				a += buf[i + k];
+				b += a;
+			}
+			u->cka = a;
+			u->ckb = b;
+			u->got += n;
+			i += n - 1;
+			if (u->got == u->len) {
+				u->state = DLUBX_CK;
+			}
+			break;
+		case DLUBX_CK:
+			u->ck[u->hdr++] = c;
+			if (u->hdr < UBXCKSZ) {
+				break;
+			}
+			u->state = DLUBX_SYNC1;
+			if (u->ck[0] != u->cka || u->ck[1] != u->ckb) {
+				u->badsum++;
+				*used = i + 1;
+				return true;
+			}
+			*emitted += DlUbxDispatch(u, cb, context);
+			break;
+		}
+	}
+	*used = len;
+	return false;
+}
+
+/** @brief Lays out the bytes of the failed frame after its first sync
+ *  byte, followed by bytes not yet scanned
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlubx_s * u holding the failed frame
+ *  @param uint8_t * again output, UBXHDRSZ + UBXMAXPAYLOAD + UBXCKSZ bytes
+ *  @param const uint8_t * tail unscanned bytes, may lie inside again
+ *  @param size_t ntail
+ *  @return size_t bytes in again
+ */
+static size_t DlUbxRewind(const dlubx_s *u, uint8_t *again, const uint8_t *tail, size_t ntail)
+{
+	size_t n = UBXHDRSZ - 1;
+
+	if (u->len <= UBXMAXPAYLOAD) {
+		n += u->len + UBXCKSZ;
+	}
+	if (ntail > 0) {
+		memmove(again + n, tail, ntail);
+	}
+	again[0] = UBXSYNC2;
+	again[1] = u->cls;
+	again[2] = u->id;
+	again[3] = (uint8_t)(u->len & 0xFF);
+	again[4] = (uint8_t)(u->len >> 8);
+	if (u->len <= UBXMAXPAYLOAD) {
+		memcpy(again + UBXHDRSZ - 1, u->payload, u->len);
+		again[n - 2] = u->ck[0];
+		again[n - 1] = u->ck[1];
+	}
+	return n + ntail;
+}
+
+/** @brief Feeds bytes from the receiver, frames may be split across calls.
+ *  A frame that fails is scanned again from the byte after its sync, so a
+ *  frame cut short by a dropped byte loses only itself and not the frames
+ *  it swallowed as payload.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlubx_s * u
+ *  @param const uint8_t * buf bytes as read
+ *  @param size_t len
+ *  @param dlubx_f * cb called for each NAV-PVT that passed its checksum
+ *  @param void * context passed to cb
+ *  @return size_t NAV-PVT messages handed to cb
+ */
+size_t DlUbxFeed(dlubx_s *u, const uint8_t *buf, size_t len, dlubx_f *cb, void *context)
+{
+	uint8_t again[UBXHDRSZ + UBXMAXPAYLOAD + UBXCKSZ];
+	size_t used, n, emitted = 0;
+
+	while (len > 0 && DlUbxScan(u, buf, len, &used, &emitted, cb, context)) {
+		buf += used;
+		len -= used;
+		// a frame failing inside again began after its start, so what is left always fits
+		n = DlUbxRewind(u, again, NULL, 0);
+		while (DlUbxScan(u, again, n, &used, &emitted, cb, context)) {
+			n = DlUbxRewind(u, again, again + used, n - used);
+		}
+	}
+	return emitted;
+}
+
+/** @brief Builds a frame, sync bytes, length and Fletcher checksum added
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint8_t cls message class
+ *  @param uint8_t id message id
+ *  @param const uint8_t * payload
+ *  @param uint16_t len payload bytes
+ *  @param uint8_t * frame output
+ *  @param size_t size of frame
+ *  @return size_t frame bytes, 0 if it does not fit
+ */
+size_t DlUbxFrame(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len, uint8_t *frame, size_t size)
+{
+	uint8_t cka = 0, ckb = 0;
+	size_t i, n = UBXHDRSZ + len;
+
+	if (n + UBXCKSZ > size) {
+		return 0;
+	}
+	frame[0] = UBXSYNC1;
+	frame[1] = UBXSYNC2;
+	frame[2] = cls;
+	frame[3] = id;
+	frame[4] = (uint8_t)(len & 0xFF);
+	frame[5] = (uint8_t)(len >> 8);
+	memcpy(frame + UBXHDRSZ, payload, len);
+	for (i = 2; i < n; i++) {
+		cka += frame[i];
+		ckb += cka;
+	}
+	frame[n++] = cka;
+	frame[n++] = ckb;
+	return n;
+}
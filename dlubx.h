@@ -0,0 +1,93 @@
+#ifndef DLUBX_H
+#define DLUBX_H
+/** @file dlubx.h
+ *  @brief Constants, structures, function prototypes for the u-blox UBX decoder
+ *
+ *  DlUbxFeed takes raw chunks from the receiver like DlNmeaFeed. It finds
+ *  the 0xB5 0x62 sync, reads the class, id and length, and checks the
+ *  Fletcher checksum over the frame. A NAV-PVT, one per navigation epoch,
+ *  goes to the callback as integers straight from the payload: 1e-7
+ *  degree position, mm and mm/s, and 1e-5 degree heading, with no text
+ *  conversion. NMEA text mixed into the stream and other messages are
+ *  skipped. ACK-ACK and ACK-NAK are counted so configuration can be
+ *  checked.
+ */
+#include <cinttypes>
+#include <cstddef>
+#include "dlgnss.h"
+
+#define UBXNAV 0x01
+#define UBXNAVPVT 0x07
+#define UBXNAVPVTSZ 92
+#define UBXACK 0x05
+#define UBXACKNAK 0x00
+#define UBXACKACK 0x01
+#define UBXMAXPAYLOAD 512     ///< Longer frames are taken for noise and dropped
+#define UBXPVT_GNSSFIXOK 0x01 ///< flags, fix within the receiver's accuracy masks
+#define UBXPVT_VALIDDATE 0x01 ///< valid
+#define UBXPVT_VALIDTIME 0x02
+#define UBXPVT_RESOLVED 0x04  ///< valid, UTC fully resolved, no ambiguity in the second
+
+enum dlubxstate_e
+{
+	DLUBX_SYNC1,    ///< Waiting for 0xB5
+	DLUBX_SYNC2,    ///< Waiting for 0x62
+	DLUBX_HEADER,   ///< Class, id and two length bytes
+	DLUBX_PAYLOAD,
+	DLUBX_CK        ///< Two checksum bytes
+};
+
+/** NAV-PVT fields the logger uses, units as sent */
+typedef struct dlubxpvt
+{
+	uint32_t itow;       ///< GPS time of week, ms, the same for every message of an epoch
+	uint16_t year;       ///< UTC
+	uint8_t month, day, hour, min, sec;
+	uint8_t valid;       ///< UBXPVT_VALID... bits
+	int32_t nano;        ///< Fraction of the second, ns, may be negative
+	uint32_t tacc;       ///< Time accuracy, ns
+	uint8_t fixtype;     ///< 0 none, 1 dead reckoning, 2 2D, 3 3D, 4 GNSS and dead reckoning, 5 time only
+	uint8_t flags;       ///< UBXPVT_GNSSFIXOK
+	uint8_t numsv;       ///< Satellites used
+	int32_t lon;         ///< 1e-7 degrees
+	int32_t lat;         ///< 1e-7 degrees
+	int32_t height;      ///< Above the ellipsoid, mm
+	int32_t hmsl;        ///< Above mean sea level, mm
+	uint32_t hacc;       ///< Horizontal accuracy, mm
+	uint32_t vacc;       ///< Vertical accuracy, mm
+	int32_t gspeed;      ///< Ground speed, mm/s
+	int32_t headmot;     ///< Heading of motion, 1e-5 degrees
+	uint32_t sacc;       ///< Speed accuracy, mm/s
+	uint32_t headacc;    ///< Heading accuracy, 1e-5 degrees
+	uint16_t pdop;       ///< 0.01
+} dlubxpvt_s;
+
+/** Called from DlUbxFeed for each NAV-PVT that passed its checksum */
+typedef void dlubx_f(void *context, const dlubxpvt_s *pvt);
+
+typedef struct dlubx
+{
+	uint8_t state;       ///< dlubxstate_e
+	uint8_t cls, id;
+	uint8_t cka, ckb;    ///< Running Fletcher checksum over class to payload
+	uint8_t hdr;         ///< Header bytes seen
+	uint8_t ck[2];
+	uint16_t len;        ///< Payload length from the header
+	uint16_t got;        ///< Payload bytes so far
+	uint8_t payload[UBXMAXPAYLOAD];
+	dlubxpvt_s pvt;      ///< Last NAV-PVT decoded
+	uint64_t frames;     ///< Frames that passed their checksum, any class
+	uint64_t pvts;       ///< NAV-PVT handed to the callback
+	uint64_t acks;
+	uint64_t naks;
+	uint64_t badsum;
+	uint64_t malformed;  ///< Oversized frames and NAV-PVT of the wrong length
+} dlubx_s;
+
+///\cond INTERNAL
+// Function Prototypes
+void DlUbxInit(dlubx_s *u);
+size_t DlUbxFeed(dlubx_s *u, const uint8_t *buf, size_t len, dlubx_f *cb, void *context);
+size_t DlUbxFrame(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len, uint8_t *frame, size_t size);
+///\endcond
+#endif
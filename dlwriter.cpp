@@ -0,0 +1,183 @@
+/** @file dlwriter.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Log file writers that stay open and write in large aligned blocks
+ */
+#include "dlwriter.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "dltime.h"
+
+static const dlwriterpolicy_s defpolicy = { WRITERFLUSHBYTES, WRITERFLUSHMS, WRITERFSYNCMS };
+
+/** @brief Writes len bytes from the start of the buffer and keeps the rest
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlwriter_s * w
+ *  @param size_t len bytes to write
+ *  @return int 1 on success, 0 on error (w->err is set)
+ */
+static int DlWriterWrite(dlwriter_s *w, size_t len)
+{
+	size_t done = 0;
+	ssize_t n;
+
+	while (done < len) {
+		n = write(w->fd, w->buf + done, len - done);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			w->err = errno;
+			break;
+		}
+		done += n;
+		w->writes++;
+	}
+	w->bytes += done;
+	memmove(w->buf, w->buf + done, w->len - done);
+	w->len -= done;
+	w->lastflush = DlTimeNow();
+	return done == len;
+}
+
+/** @brief Opens a file for appending and allocates its block buffer
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlwriter_s * w
+ *  @param const char * path
+ *  @param const dlwriterpolicy_s * policy NULL for the defaults
+ *  @return int 1 on success, 0 on failure
+ */
+int DlWriterOpen(dlwriter_s *w, const char *path, const dlwriterpolicy_s *policy)
+{
+	void *buf;
+
+	memset(w, 0, sizeof(*w));
+	w->fd = -1;
+	w->path = path;
+	w->policy = policy ? *policy : defpolicy;
+	if (w->policy.flushbytes == 0 || w->policy.flushbytes > WRITERBUFSZ) {
+		w->policy.flushbytes = WRITERBUFSZ;
+	}
+	if (posix_memalign(&buf, WRITERALIGN, WRITERBUFSZ) != 0) {
+		return 0;
+	}
+	w->buf = (char *)buf;
+	w->fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (w->fd == -1) {
+		w->err = errno;
+		free(w->buf);
+		w->buf = NULL;
+		return 0;
+	}
+	w->lastflush = w->lastsync = DlTimeNow();
+	return 1;
+}
+
+/** @brief Buffers one record. Once flushbytes are buffered the whole
+ *  WRITERALIGN blocks are written and the tail stays buffered. A record
+ *  is buffered whole or not at all, so a failing write never leaves part
+ *  of a fixed size record in the file to shift the ones after it.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlwriter_s * w
+ *  @param const void * data
+ *  @param size_t len at most WRITERBUFSZ
+ *  @return int 1 on success, 0 on a write error or if the record was dropped
+ */
+int DlWriterAppend(dlwriter_s *w, const void *data, size_t len)
+{
+	int rc = 1;
+
+	if (w->fd == -1) {
+		return 0;
+	}
+	if (len > WRITERBUFSZ) {
+		w->err = EMSGSIZE;
+		return 0;
+	}
+	if (len > WRITERBUFSZ - w->len) {
+		rc = DlWriterWrite(w, w->len);
+		if (len > WRITERBUFSZ - w->len) {
+			return 0;  // write failing, buffer full, record dropped
+		}
+	}
+	memcpy(w->buf + w->len, data, len);
+	w->len += len;
+	w->records++;
+	if (w->len >= w->policy.flushbytes) {
+		rc &= DlWriterWrite(w, w->len - w->len % WRITERALIGN);
+	}
+	return rc;
+}
+
+/** @brief Applies the time based part of the policy, call periodically
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlwriter_s * w
+ *  @return int 1 on success, 0 on a write error
+ */
+int DlWriterPoll(dlwriter_s *w)
+{
+	uint64_t now = DlTimeNow();
+	int rc = 1;
+
+	if (w->fd == -1) {
+		return 0;
+	}
+	if (w->len > 0 && w->policy.flushms && now - w->lastflush >= w->policy.flushms * NSPERMS) {
+		rc = DlWriterWrite(w, w->len);
+	}
+	if (w->policy.fsyncms && w->lastsync < w->lastflush && now - w->lastsync >= w->policy.fsyncms * NSPERMS) {
+		fdatasync(w->fd);
+		w->syncs++;
+		w->lastsync = now;
+	}
+	return rc;
+}
+
+/** @brief Writes out everything buffered
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlwriter_s * w
+ *  @param int sync non zero to fdatasync afterwards
+ *  @return int 1 on success, 0 on a write error
+ */
+int DlWriterFlush(dlwriter_s *w, int sync)
+{
+	int rc = 1;
+
+	if (w->fd == -1) {
+		return 0;
+	}
+	if (w->len > 0) {
+		rc = DlWriterWrite(w, w->len);
+	}
+	if (sync) {
+		fdatasync(w->fd);
+		w->syncs++;
+		w->lastsync = DlTimeNow();
+	}
+	return rc;
+}
+
+/** @brief Flushes, syncs and closes the file
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlwriter_s * w
+ *  @return void
+ */
+void DlWriterClose(dlwriter_s *w)
+{
+	if (w->fd != -1) {
+		DlWriterFlush(w, 1);
+		close(w->fd);
+		w->fd = -1;
+	}
+	free(w->buf);
+	w->buf = NULL;
+}
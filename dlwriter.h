@@ -0,0 +1,46 @@
+#ifndef DLWRITER_H
+#define DLWRITER_H
+/** @file dlwriter.h
+ *  @brief Constants, structures, function prototypes for buffered log file writers
+ */
+#include <cinttypes>
+#include <cstddef>
+
+#define WRITERBUFSZ 65536
+#define WRITERALIGN 4096
+#define WRITERFLUSHBYTES 32768
+#define WRITERFLUSHMS 1000
+#define WRITERFSYNCMS 10000
+
+typedef struct dlwriterpolicy
+{
+	size_t flushbytes;  ///< Write out once this many bytes are buffered
+	uint32_t flushms;   ///< Write out buffered bytes at least this often, 0 never
+	uint32_t fsyncms;   ///< fdatasync at least this often, 0 only on close
+} dlwriterpolicy_s;
+
+typedef struct dlwriter
+{
+	const char *path;          ///< File appended to
+	int fd;                    ///< Kept open between records
+	char *buf;                 ///< WRITERALIGN aligned block buffer
+	size_t len;                ///< Bytes buffered
+	dlwriterpolicy_s policy;   ///< Flush policy
+	uint64_t lastflush;        ///< CLOCK_MONOTONIC ns of the last write out
+	uint64_t lastsync;         ///< CLOCK_MONOTONIC ns of the last fdatasync
+	uint64_t records;          ///< Records appended
+	uint64_t bytes;            ///< Bytes written to the file
+	uint64_t writes;           ///< write() calls
+	uint64_t syncs;            ///< fdatasync() calls
+	int err;                   ///< errno of the last failed write, 0 if none
+} dlwriter_s;
+
+///\cond INTERNAL
+// Function Prototypes
+int DlWriterOpen(dlwriter_s *w, const char *path, const dlwriterpolicy_s *policy);
+int DlWriterAppend(dlwriter_s *w, const void *data, size_t len);
+int DlWriterPoll(dlwriter_s *w);
+int DlWriterFlush(dlwriter_s *w, int sync);
+void DlWriterClose(dlwriter_s *w);
+///\endcond
+#endif
@@ -10,8 +10,13 @@
 #include <cstring>
 #include <ctime>
 #include <unistd.h>
+#include "dlchannel.h"
+#include "dlformat.h"
 #include "dlgps.h"
-#include "loggermqtt.h"
+#include "dlrecord.h"
+#include "dlrotate.h"
+#include "dltime.h"
+#include "dlwriter.h"
 
 #if SENSEHAT == 1
 #include "sensehat.h"
@@ -19,8 +24,16 @@ SenseHat Sh;
 #endif
 
 // Global Objects
+static dlwriter_s binlog;
+#if TEXTLOG == 1
+static dlwriter_s csvlog;
+static dlwriter_s jsonlog;
+#endif
+static int logopen = 0;
+static uint64_t logbytes = 0;   // bytes in the active logs
+static uint64_t logopened = 0;  // CLOCK_MONOTONIC ns the active logs were opened
 
-/** @brief Initialize data logger, currently prints header
+/** @brief Initialize data logger, starts the IMU sampling thread
  *  @author Robert Miller
  *  @date 23Jan2022
  *  @param void
@@ -28,6 +41,9 @@ SenseHat Sh;
  */
 int DlInitialization(void) {
 	// fprintf(stdout, "\nData Logger Initialization\n");
+#if SENSEHAT == 1
+	Sh.StartImuThread();
+#endif
   return 1;
 }
 
@@ -72,112 +88,149 @@ uint64_t DlGetSerial(void) {
  *  @return void
  */
 void DlDisplayLoggerReadings(reading_s dreads) {
+  char ltime[TIMESTRSZ];
+  char text[PAYLOADSTRSZ] = "";
+  uint64_t ms = DlTimeEpochMs(dreads.tns, dreads.toffset);
+  time_t secs = (time_t)(ms / 1000);
+  struct tm utc;
+  strftime(ltime, sizeof(ltime), "%Y-%m-%d %H:%M:%S", gmtime_r(&secs, &utc));
   fprintf(stdout, "\nUnit:%lu \t", DlGetSerial());
-  fprintf(stdout, " %s", ctime(&dreads.rtime));
-  fprintf(stdout, "T: %0.1fC \t", dreads.temperature);
-  fprintf(stdout, "H: %0.0f%% \t", dreads.humidity);
-  fprintf(stdout, "P: %0.1f KPa\n", dreads.pressure);
-  fprintf(stdout, "Xa: %f g\t", dreads.xa);
-  fprintf(stdout, "Ya: %f g\t", dreads.ya);
-  fprintf(stdout, "Za: %f g\n", dreads.za);
-	fprintf(stdout, "Pitch: %f \t", dreads.pitch);
-	fprintf(stdout, "Roll: %f \t", dreads.roll);
-	fprintf(stdout, "Yaw: %f \t \n", dreads.yaw);
-	fprintf(stdout, "Xm: %f \t", dreads.xm);
-	fprintf(stdout, "Ym: %f \t", dreads.ym);
-	fprintf(stdout, "Zm: %f \t \n", dreads.zm);
-  fprintf(stdout, "Latitude: %f \t", dreads.latitude);
-  fprintf(stdout, "Longitude: %f \t", dreads.longitude);
-  fprintf(stdout, "Altitude: %f \n", dreads.altitude);
-  fprintf(stdout, "Speed: %f \t", dreads.speed);
-  fprintf(stdout, "Heading: %f \n", dreads.heading);
+  fprintf(stdout, " %s.%03uZ\n", ltime, (unsigned)(ms % 1000));
+  DlFormatLoggerText(dreads, text, sizeof(text));
+  fputs(text, stdout);
 }
 
-/** @brief Gets the reading results from the system, and adds items (system
- * time, currently default data)
+/** @brief Gets the reading results from the system, merging the latest
+ * record of every sensor channel
  *  @author Robert Miller
- *  @date 23Jan2022
+ *  @date 17Oct2026
  *  @param void
  *  @return struct reading_s
  */
 reading_s DlGetLoggerReadings(void) {
-  reading_s creads;
-	loc_t gpsdata;
-	gpsdata = {0};
-  creads.rtime = time(NULL);
-#if SENSEHAT == 1
-  usleep(IMUDELAY);
-  creads.temperature = Sh.GetTemperature();
-  creads.humidity = Sh.GetHumidity();
-  creads.pressure = Sh.GetPressure();
-  Sh.GetAcceleration(creads.xa, creads.ya, creads.za);
-  Sh.GetOrientation(creads.pitch, creads.roll, creads.yaw);
-  Sh.GetMagnetism(creads.xm, creads.ym, creads.zm);
-#else
-  creads.temperature = DTEMP;
-  creads.humidity = DHUMID;
-	creads.pressure = DPRESS;
-  creads.xa = DXA;
-  creads.ya = DYA;
-  creads.za = DZA;
-  creads.pitch = DPITCH;
-  creads.roll = DROLL;
-  creads.yaw = DYAW;
-  creads.xm = DXM;
-  creads.ym = DYM;
-	creads.zm = DZM;
-#endif
-#if GPSDEVICE == 1
-	DlGpsInit();
-	gpsdata = DlGpsLocation();
-	creads.latitude = gpsdata.latitude;
-	creads.longitude = gpsdata.longitude;
-	creads.altitude = gpsdata.altitude;
-	creads.heading = gpsdata.course;
-	creads.speed = gpsdata.speed;
-#else
-  creads.latitude = DLAT;
-  creads.longitude = DLONG;
-  creads.altitude = DALT;
-  creads.speed = DSPEED;
-  creads.heading = DHEADING;
+  return DlChannelSnapshot(DlTimeNow());
+}
+
+/** @brief Opens the binary log (and the .csv and .json logs when TEXTLOG is set),
+ *  they stay open until DlCloseLoggerData. A new segment starts with its header.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return int 1 on success, 0 if a file could not be opened
+ */
+int DlOpenLoggerData(void) {
+	uint8_t hdr[RECHDRSZ];
+	if (!DlWriterOpen(&binlog, BINLOGFILE, NULL)) {
+		return 0;
+	}
+	logbytes = lseek(binlog.fd, 0, SEEK_END);
+	if (logbytes == 0) {
+		logbytes = DlRecordHeader(hdr, DlGetSerial());
+		DlWriterAppend(&binlog, hdr, logbytes);
+		binlog.records = 0;
+	}
+#if TEXTLOG == 1
+	if (!DlWriterOpen(&csvlog, CSVLOGFILE, NULL)) {
+		DlWriterClose(&binlog);
+		return 0;
+	}
+	if (!DlWriterOpen(&jsonlog, JSONLOGFILE, NULL)) {
+		DlWriterClose(&csvlog);
+		DlWriterClose(&binlog);
+		return 0;
+	}
+	logbytes += lseek(csvlog.fd, 0, SEEK_END) + lseek(jsonlog.fd, 0, SEEK_END);
 #endif
-  return creads;
+	logopened = DlTimeNow();
+	logopen = 1;
+	return 1;
 }
 
-/** @brief Saves logger data to a .csv and a .json
+/** @brief Saves logger data as a binary record (and to the .csv and .json when TEXTLOG is set)
  *  @author Robert Miller
- *  @date 23Jan2022
+ *  @date 17Oct2026
  *  @param struct reading_s creads
- *  @return int
+ *  @return int 1 on success, 0 if the logs are not open, -1 on a write error
  */
 int DlSaveLoggerData(reading_s creads) {
-	FILE *fp;
-	char ltime[TIMESTRSZ];
-	char jsondata[PAYLOADSTRSZ];
-	fp = fopen("loggerdata.csv", "a");
-	if (fp == NULL) {
+	uint8_t record[RECSIZE];
+	if (!logopen && !DlOpenLoggerData()) {
 		return 0;
 	}
-	strncpy(ltime, ctime(&creads.rtime), TIMESTRSZ);
-	ltime[3] = ',';
-	ltime[7] = ',';
-  ltime[10] = ',';
-  ltime[19] = ',';
-	fprintf(fp, "%.24s,%3.1f,%3.0f,%3.1f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f\n", ltime, creads.temperature, creads.humidity, creads.pressure, creads.xa, creads.ya, creads.za, creads.pitch, creads.yaw, creads.roll, creads.xm, creads.ym, creads.zm, creads.latitude, creads.longitude, creads.altitude, creads.speed, creads.heading);
-	fclose(fp);
-	sprintf(jsondata, "{\"temperature\":%-3.1f,\"humidity\":%-3.0f,\"pressure\":%-3.1f,\"xa\":%-f,\"ya\":%-f,\"za\":%-f,\
-\"pitch\":%-f,\"roll\":%-f,\"yaw\":%-f,\"xm\":%-f,\"ym\":%-f,\"zm\":%-f,\"latitude\":%-f,\"longitude\":%-f,\"altitude\":%-f,\"speed\":%-f,\"heading\":%-f,\"active\": true}", creads.temperature, creads.humidity, creads.pressure, creads.pitch, creads.yaw, creads.roll, creads.xm, creads.ym, creads.zm, creads.latitude, creads.longitude, creads.altitude, creads.speed, creads.heading);
-	fp = fopen("loggerdata.json", "a");
-	if (fp == NULL) {
+	DlRecordEncode(creads, record);
+	if (!DlWriterAppend(&binlog, record, RECSIZE)) {
+		return -1;
+	}
+	logbytes += RECSIZE;
+#if TEXTLOG == 1
+	char csvdata[PAYLOADSTRSZ];
+	char jsondata[PAYLOADSTRSZ];
+	int len;
+	len = DlFormatLoggerCsv(creads, csvdata, sizeof(csvdata));
+	if (!DlWriterAppend(&csvlog, csvdata, len)) {
 		return -1;
 	}
-	fprintf(fp, "%s", jsondata);
-	fclose(fp);
+	logbytes += len;
+	len = DlFormatLoggerJson(creads, jsondata, sizeof(jsondata));
+	if (!DlWriterAppend(&jsonlog, jsondata, len)) {
+		return -1;
+	}
+	logbytes += len;
+#endif
+	if (DlRotateDue(logbytes, logopened)) {
+		DlRotateLoggerData();
+	}
+  return 1;
+}
 
-	int rc = DlPublishLoggerData(jsondata);
+/** @brief Applies the size/time flush policy of the logs, call periodically
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void DlFlushLoggerData(void) {
+	if (logopen) {
+		DlWriterPoll(&binlog);
+#if TEXTLOG == 1
+		DlWriterPoll(&csvlog);
+		DlWriterPoll(&jsonlog);
+#endif
+	}
+}
 
-  return rc;
+/** @brief Flushes, syncs and closes the logs
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void DlCloseLoggerData(void) {
+	if (logopen) {
+		DlWriterClose(&binlog);
+#if TEXTLOG == 1
+		DlWriterClose(&csvlog);
+		DlWriterClose(&jsonlog);
+#endif
+		logopen = 0;
+	}
+}
+
+/** @brief Closes the active logs, renames them to dated segments for the
+ *  compression thread and starts new ones
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return int 1 on success, 0 if the new logs could not be opened
+ */
+int DlRotateLoggerData(void) {
+	DlCloseLoggerData();
+	DlRotateSegment(BINLOGFILE);
+#if TEXTLOG == 1
+	DlRotateSegment(CSVLOGFILE);
+	DlRotateSegment(JSONLOGFILE);
+#endif
+	return DlOpenLoggerData();
 }
 
 /** @brief Displays the Humber logo on the SenseHat Screen
@@ -227,3 +280,31 @@ void DlUpdateLevel(float xa, float ya) {
     Sh.LightPixel(x, y+1, HY);
     Sh.LightPixel(x+1, y+1, HY);
 }
+
+/** @brief Gets the SenseHat joystick descriptor for the event loop
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return int evdev descriptor, -1 without a SenseHat
+ */
+int DlJoystickFd(void) {
+#if SENSEHAT == 1
+	return Sh.GetJoystickFd();
+#else
+	return -1;
+#endif
+}
+
+/** @brief Reads one pending joystick event, call when the descriptor is readable
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return int key code of a key press, 0 for other events
+ */
+int DlJoystickRead(void) {
+#if SENSEHAT == 1
+	return (unsigned char)Sh.ScanJoystick();
+#else
+	return 0;
+#endif
+}
@@ -34,28 +34,45 @@
 #define HY 0xC4A0
 #define HW 0xFFFF
 #define GPSDEVICE 1
-#define TIMESTRSZ 25
-#define PAYLOADSTRSZ 400
+#define TIMESTRSZ 32
+#define PAYLOADSTRSZ 768
+#define CSVLOGFILE "loggerdata.csv"
+#define JSONLOGFILE "loggerdata.json"
+#define BINLOGFILE "loggerdata.vdl"
+#define TEXTLOG 0
+
+/** Every float in reading_s, in record order. The struct, the CSV, JSON,
+ *  binary and console layouts and the per-channel deadbands are all
+ *  generated from this one table, so a new channel is added here and
+ *  nowhere else.
+ *  X(name, decimals, label, unit, newline, absolute deadband, relative deadband, description)
+ */
+#define DLREADINGFIELDS(X) \
+	X(temperature, 1, "T",         "C",    0, 0.2f,     0,     "Degrees Celsius") \
+	X(humidity,    0, "H",         "%",    0, 1.0f,     0,     "Per cent relative humidity") \
+	X(pressure,    1, "P",         " KPa", 1, 0.5f,     0,     "Kilo Pascals") \
+	X(xa,          6, "Xa",        " g",   0, 0.02f,    0,     "X-axis accelaration") \
+	X(ya,          6, "Ya",        " g",   0, 0.02f,    0,     "Y-axis accelaration") \
+	X(za,          6, "Za",        " g",   1, 0.02f,    0,     "Z-axis accelaration") \
+	X(pitch,       6, "Pitch",     "",     0, 0.01f,    0,     "Pitch angle") \
+	X(roll,        6, "Roll",      "",     0, 0.01f,    0,     "Roll angle") \
+	X(yaw,         6, "Yaw",       "",     1, 0.01f,    0,     "Yaw angle") \
+	X(xm,          6, "Xm",        "",     0, 1.0f,     0,     "X axis micro Teslas") \
+	X(ym,          6, "Ym",        "",     0, 1.0f,     0,     "Y axis micro Teslas") \
+	X(zm,          6, "Zm",        "",     1, 1.0f,     0,     "Z axis micro Teslas") \
+	X(latitude,    6, "Latitude",  "",     0, 0.00005f, 0,     "Latitude") \
+	X(longitude,   6, "Longitude", "",     0, 0.00005f, 0,     "Longitude") \
+	X(altitude,    6, "Altitude",  "",     1, 2.0f,     0,     "Altitude") \
+	X(speed,       6, "Speed",     "",     0, 1.0f,     0.02f, "Speed kph") \
+	X(heading,     6, "Heading",   "",     1, 2.0f,     0,     "Heading degrees True")
+#define DLFIELDMEMBER(name, decimals, label, unit, newline, absdb, reldb, desc) float name;
+#define DLFIELDCOUNT(name, decimals, label, unit, newline, absdb, reldb, desc) + 1
+#define DLNFIELDS (0 DLREADINGFIELDS(DLFIELDCOUNT))
 
 struct readings {
-  time_t rtime;      ///< Reading time
-  float temperature; ///< Degrees Celsius
-  float humidity;    ///< Per cent relative humidity
-  float pressure;    ///< Kilo Pascals
-  float xa;          ///< X-axis accelaration
-  float ya;          ///< Y-axis accelaration
-  float za;          ///< Z-axis accelaration
-  float pitch;       ///< Pitch angle
-  float roll;        ///< Roll angle
-  float yaw;         ///< Yaw angle
-  float xm;          ///< X axis micro Teslas
-  float ym;          ///< Y axis micro Teslas
-  float zm;          ///< Z axis micro Teslas
-  float latitude;    ///< Latitude
-  float longitude;   ///< Longitude
-  float altitude;    ///< Altitude
-  float speed;       ///< Speed kph
-	float heading;     ///< Heading degrees True
+  uint64_t tns;      ///< Reading time, CLOCK_MONOTONIC ns
+  int64_t toffset;   ///< UTC minus CLOCK_MONOTONIC ns when the reading was taken
+  DLREADINGFIELDS(DLFIELDMEMBER)
 };
 typedef struct readings reading_s;
 
@@ -65,8 +82,14 @@ int DlInitialization(void);
 uint64_t DlGetSerial(void);
 reading_s DlGetLoggerReadings(void);
 void DlDisplayLoggerReadings(reading_s dreads);
+int DlOpenLoggerData(void);
 int DlSaveLoggerData(reading_s creads);
+void DlFlushLoggerData(void);
+void DlCloseLoggerData(void);
+int DlRotateLoggerData(void);
 void DlDisplayLogo(void);
 void DlUpdateLevel(float xa, float ya);
+int DlJoystickFd(void);
+int DlJoystickRead(void);
 ///\endcond
 #endif
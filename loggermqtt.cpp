@@ -1,35 +1,786 @@
 #include "loggermqtt.h"
-#include <MQTTClient.h>
+#include <MQTTAsync.h>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <unistd.h>
+#include "dltime.h"
 
-/** @brief Publishes logger data via the MQTT protocol
+// Global Objects
+static MqttPublisher publisher;
+static const int laneqos[DLLANE_COUNT] = { ALERTQOS, QOS, BACKLOGQOS };
+static const char *lanename[DLLANE_COUNT] = { "alert", "live", "backlog" };
+static const float lanereserve[DLLANE_COUNT] = { BUDGETFORCE, 0.0f, BUDGETDECIMATEAT };  // budget each lane leaves
+
+/** @brief Creates the publisher, the session is opened by the first Publish
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * address broker URI
+ *  @param const char * clientid
+ *  @param int window QoS 1/2 messages allowed in flight
+ *  @param int version MQTTVERSION_3_1_1 or MQTTVERSION_5
+ */
+MqttPublisher::MqttPublisher(const char *address, const char *clientid, int window, int version)
+	: address(address), clientid(clientid), client(NULL), created(false), window(MQTTWINDOW), version(version),
+	  aliasmax(0), budget(NULL), ackhook(NULL), ackcontext(NULL), inflight(0),
+	  state(DLMQTT_DISCONNECTED), nextattempt(0), backoffms(MQTTBACKOFFMINMS), upsince(0), uptime(0),
+	  lastrc(MQTTASYNC_SUCCESS), connects(0), connectfails(0), losses(0), published(0), delivered(0), failed(0),
+	  abandoned(0), dropped(0), windowfull(0), latsum(0), latmax(0), aliased(0), lastbacklog(0)
+{
+	int i;
+
+	memset(slot, 0, sizeof(slot));
+	memset(parked, 0, sizeof(parked));
+	memset(alias, 0, sizeof(alias));
+	nparked = 0;
+	pending = 0;
+	session = 0;
+	for (i = 0; i < DLLANE_COUNT; i++) {
+		lanepub[i] = 0;
+		laneack[i] = 0;
+		lanefull[i] = 0;
+		lanelat[i] = 0;
+		lanemax[i] = 0;
+	}
+	pthread_mutex_init(&lock, NULL);
+	SetWindow(window);
+}
+
+/** @brief Closes the session and frees the Paho client
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ */
+MqttPublisher::~MqttPublisher(void)
+{
+	Disconnect();
+	if (created) {
+		MQTTAsync_destroy(&client);
+		created = false;
+	}
+	pthread_mutex_destroy(&lock);
+}
+
+/** @brief Sets how many QoS 1/2 messages may wait for their PUBACK, Paho
+ *  is given the same limit at the next connect. Shrinking waits until the
+ *  messages in the slots above the new size have been acknowledged, or
+ *  until the session is lost.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int window 1 to MQTTWINDOWMAX
+ *  @return void
+ */
+void MqttPublisher::SetWindow(int window)
+{
+	bool busy = true;
+	int i;
+
+	if (window < 1) {
+		window = 1;
+	}
+	if (window > MQTTWINDOWMAX) {
+		window = MQTTWINDOWMAX;
+	}
+	pthread_mutex_lock(&lock);
+	this->window.store(window);
+	pthread_mutex_unlock(&lock);
+	while (busy) {
+		busy = false;
+		pthread_mutex_lock(&lock);
+		for (i = window; i < MQTTWINDOWMAX && !busy; i++) {
+			busy = slot[i].pending || (slot[i].token != 0 && state.load() == DLMQTT_CONNECTED);
+		}
+		pthread_mutex_unlock(&lock);
+		if (busy) {
+			usleep(1000);
+		}
+	}
+}
+
+/** @brief Starts opening the session, the result arrives in OnConnect or
+ *  OnConnectFailure. The Paho client is created once and reused.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return int MQTTASYNC_SUCCESS if the attempt was started, or the Paho error code
+ */
+int MqttPublisher::Connect(void)
+{
+	MQTTAsync_connectOptions conn_opts = MQTTAsync_connectOptions_initializer;
+	MQTTAsync_connectOptions conn_opts5 = MQTTAsync_connectOptions_initializer5;
+	MQTTAsync_createOptions create_opts = MQTTAsync_createOptions_initializer;
+	int rc;
+
+	if (state.load() != DLMQTT_DISCONNECTED) {
+		return MQTTASYNC_SUCCESS;
+	}
+	if (!created) {
+		create_opts.MQTTVersion = version;
+		rc = MQTTAsync_createWithOptions(&client, address, clientid, MQTTCLIENT_PERSISTENCE_NONE, NULL, &create_opts);
+		if (rc != MQTTASYNC_SUCCESS) {
+			lastrc = rc;
+			Backoff();
+			return rc;
+		}
+		MQTTAsync_setCallbacks(client, this, ConnectionLost, MessageArrived, DeliveryComplete);
+		created = true;
+	}
+	if (version >= MQTTVERSION_5) {
+		conn_opts = conn_opts5;
+		conn_opts.cleanstart = 1;
+		conn_opts.onSuccess5 = OnConnect5;
+		conn_opts.onFailure5 = OnConnectFailure5;
+	} else {
+		conn_opts.cleansession = 1;
+		conn_opts.onSuccess = OnConnect;
+		conn_opts.onFailure = OnConnectFailure;
+	}
+	conn_opts.keepAliveInterval = MQTTKEEPALIVE;
+	conn_opts.connectTimeout = MQTTCONNECTTIMEOUT;
+	conn_opts.maxInflight = window.load();
+	conn_opts.context = this;
+	state.store(DLMQTT_CONNECTING);
+	rc = MQTTAsync_connect(client, &conn_opts);
+	if (rc != MQTTASYNC_SUCCESS) {
+		state.store(DLMQTT_DISCONNECTED);
+		connectfails++;
+		lastrc = rc;
+		Backoff();
+	}
+	return rc;
+}
+
+/** @brief Closes the session, giving messages in flight MQTTDISCONNECTMS
+ *  to be acknowledged
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void MqttPublisher::Disconnect(void)
+{
+	MQTTAsync_disconnectOptions opts = MQTTAsync_disconnectOptions_initializer;
+	int waitms;
+
+	if (created && state.load() == DLMQTT_CONNECTED) {
+		opts.timeout = MQTTDISCONNECTMS;
+		if (MQTTAsync_disconnect(client, &opts) == MQTTASYNC_SUCCESS) {
+			for (waitms = 0; waitms < 2 * MQTTDISCONNECTMS && MQTTAsync_isConnected(client); waitms += 10) {
+				usleep(10000);
+			}
+		}
+	}
+	Down();
+	Abandon();
+}
+
+/** @brief In-flight messages a lane may fill the window up to
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dllane_e lane
+ *  @return int at least 1
+ */
+int MqttPublisher::LaneLimit(dllane_e lane)
+{
+	int limit = window.load();
+	uint64_t last = lastbacklog.load();
+
+	if (lane != DLLANE_ALERT) {
+		limit -= MQTTALERTSLOTS;
+	}
+	if (lane == DLLANE_LIVE && last && DlTimeNow() - last < MQTTBACKLOGACTIVEMS * NSPERMS) {
+		limit -= MQTTBACKLOGSLOTS;
+	}
+	return limit < 1 ? 1 : limit;
+}
+
+/** @brief Hands one message to Paho without waiting for the broker
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * topic
+ *  @param const void * payload
+ *  @param int len payload bytes
+ *  @param int qos
+ *  @param dllane_e lane share of the window the message may use
+ *  @param uint64_t created CLOCK_MONOTONIC ns the payload was created, 0 now
+ *  @return int MQTTASYNC_SUCCESS, MQTTASYNC_DISCONNECTED while the session is down,
+ *  MQTTASYNC_MAX_BUFFERED_MESSAGES when the lane's share of the window is full, MQTTBUDGETREFUSED
+ *  when the lane's share of the uplink budget is spent, or the Paho error code
+ */
+int MqttPublisher::Publish(const char *topic, const void *payload, int len, int qos, dllane_e lane, uint64_t created)
+{
+	MQTTAsync_message pubmsg = MQTTAsync_message_initializer;
+	MQTTAsync_responseOptions opts = MQTTAsync_responseOptions_initializer;
+	MQTTProperty prop;
+	dlparked_s ack;
+	dlinflight_s msg;
+	const char *name = topic;
+	size_t cost;
+	uint32_t ses;
+	bool early = false;
+	int rc;
+	int i = 0, a = 0;
+
+	if (state.load() != DLMQTT_CONNECTED) {
+		if (state.load() == DLMQTT_DISCONNECTED && DlTimeNow() >= nextattempt.load()) {
+			Connect();
+		}
+		dropped++;
+		return MQTTASYNC_DISCONNECTED;
+	}
+	// Reserve the slot, alias and budget under the lock, then send without it:
+	// the Paho callbacks take the lock while holding Paho's own mutex
+	pthread_mutex_lock(&lock);
+	if (qos > 0) {
+		for (i = 0; i < window.load() && (slot[i].token != 0 || slot[i].pending); i++) {
+		}
+		if (i >= window.load() || inflight.load() >= LaneLimit(lane)) {
+			pthread_mutex_unlock(&lock);
+			windowfull++;
+			lanefull[lane]++;
+			return MQTTASYNC_MAX_BUFFERED_MESSAGES;
+		}
+	}
+	if (version >= MQTTVERSION_5 && (a = Alias(topic)) > 0 && alias[a - 1].established) {
+		name = "";
+	}
+	cost = len + strlen(name) + MQTTPUBOVERHEAD + (version >= MQTTVERSION_5 ? MQTTV5OVERHEAD : 0);
+	if (budget != NULL && !DlBudgetTake(budget, cost, lanereserve[lane])) {
+		pthread_mutex_unlock(&lock);
+		return MQTTBUDGETREFUSED;
+	}
+	if (qos > 0) {
+		slot[i].pending = true;
+		slot[i].sent = DlTimeNow();
+		slot[i].created = created ? created : slot[i].sent;
+		slot[i].lane = lane;
+		pending++;
+		inflight++;
+	}
+	ses = session;
+	pthread_mutex_unlock(&lock);
+
+	pubmsg.payload = payload;
+	pubmsg.payloadlen = len;
+	pubmsg.qos = qos;
+	pubmsg.retained = 0;
+	opts.context = this;
+	if (version >= MQTTVERSION_5) {
+		opts.onFailure5 = OnSendFailure5;
+		prop.identifier = MQTTPROPERTY_CODE_MESSAGE_EXPIRY_INTERVAL;
+		prop.value.integer4 = MQTTEXPIRYSEC;
+		MQTTProperties_add(&pubmsg.properties, &prop);
+		prop.identifier = MQTTPROPERTY_CODE_USER_PROPERTY;
+		prop.value.data.data = (char *)MQTTSCHEMAKEY;
+		prop.value.data.len = (int)strlen(MQTTSCHEMAKEY);
+		prop.value.value.data = (char *)MQTTSCHEMA;
+		prop.value.value.len = (int)strlen(MQTTSCHEMA);
+		MQTTProperties_add(&pubmsg.properties, &prop);
+		if (a > 0) {
+			prop.identifier = MQTTPROPERTY_CODE_TOPIC_ALIAS;
+			prop.value.integer2 = (unsigned short)a;
+			MQTTProperties_add(&pubmsg.properties, &prop);
+		}
+	} else {
+		opts.onFailure = OnSendFailure;
+	}
+	rc = MQTTAsync_sendMessage(client, name, &pubmsg, &opts);
+	if (version >= MQTTVERSION_5) {
+		MQTTProperties_free(&pubmsg.properties);
+	}
+	if (rc != MQTTASYNC_SUCCESS && budget != NULL) {
+		DlBudgetRefund(budget, cost);
+	}
+
+	// Record the token, unless Abandon has already forgotten the slot
+	pthread_mutex_lock(&lock);
+	if (ses == session) {
+		if (rc == MQTTASYNC_SUCCESS && a > 0) {
+			if (alias[a - 1].established) {
+				aliased++;
+			}
+			alias[a - 1].established = true;
+		}
+		if (qos > 0) {
+			slot[i].pending = false;
+			pending--;
+			if (rc == MQTTASYNC_SUCCESS) {
+				slot[i].token = opts.token;
+				early = Unpark(i, &ack, &msg);
+			} else {
+				inflight--;
+			}
+			if (pending == 0) {
+				nparked = 0;
+			}
+		}
+	}
+	pthread_mutex_unlock(&lock);
+	if (rc != MQTTASYNC_SUCCESS) {
+		failed++;
+		lastrc = rc;
+		if (rc == MQTTASYNC_DISCONNECTED) {
+			Down();
+		}
+		return rc;
+	}
+	published++;
+	lanepub[lane]++;
+	if (lane == DLLANE_BACKLOG) {
+		lastbacklog = DlTimeNow();
+	}
+	if (early && ack.rc == MQTTASYNC_SUCCESS) {
+		Acked(&msg, ack.at);
+	} else if (early) {
+		failed++;
+		lastrc = ack.rc;
+	}
+	return rc;
+}
+
+/** @brief Frees the in-flight slot of a message. An ack for a token not
+ *  yet recorded is parked while a send is in progress, its Publish
+ *  collects it.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param MQTTAsync_token token
+ *  @param int rc MQTTASYNC_SUCCESS for an ack, else the failure code
+ *  @param dlinflight_s * msg receives the slot, may be NULL
+ *  @return bool false if the message was not in flight
+ */
+bool MqttPublisher::Release(MQTTAsync_token token, int rc, dlinflight_s *msg)
+{
+	bool found = false;
+	int i;
+
+	pthread_mutex_lock(&lock);
+	for (i = 0; i < MQTTWINDOWMAX; i++) {
+		if (slot[i].token == token && token != 0) {
+			if (msg != NULL) {
+				*msg = slot[i];
+			}
+			slot[i].token = 0;
+			inflight--;
+			found = true;
+			break;
+		}
+	}
+	if (!found && token != 0 && pending > 0 && nparked < MQTTWINDOWMAX) {
+		parked[nparked].token = token;
+		parked[nparked].rc = rc;
+		parked[nparked].at = DlTimeNow();
+		nparked++;
+	}
+	pthread_mutex_unlock(&lock);
+	return found;
+}
+
+/** @brief Takes the parked ack of the token just recorded in a slot and
+ *  frees the slot, call with lock held
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int i slot
+ *  @param dlparked_s * ack receives the parked ack
+ *  @param dlinflight_s * msg receives the slot
+ *  @return bool false if no ack was parked for it
+ */
+bool MqttPublisher::Unpark(int i, dlparked_s *ack, dlinflight_s *msg)
+{
+	int k;
+
+	for (k = 0; k < nparked; k++) {
+		if (parked[k].token == slot[i].token) {
+			*ack = parked[k];
+			parked[k] = parked[--nparked];
+			*msg = slot[i];
+			slot[i].token = 0;
+			inflight--;
+			return true;
+		}
+	}
+	return false;
+}
+
+/** @brief Forgets every message in flight, their acknowledgements will
+ *  not come on a new clean session
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void MqttPublisher::Abandon(void)
+{
+	int i;
+
+	pthread_mutex_lock(&lock);
+	for (i = 0; i < MQTTWINDOWMAX; i++) {
+		if (slot[i].token != 0 || slot[i].pending) {
+			slot[i].token = 0;
+			slot[i].pending = false;
+			abandoned++;
+		}
+	}
+	pending = 0;
+	nparked = 0;
+	session++;
+	inflight.store(0);
+	pthread_mutex_unlock(&lock);
+}
+
+/** @brief Finds or assigns the topic alias of a topic, call with lock held
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * topic
+ *  @return int alias 1 to aliasmax, 0 if the topic goes without one
+ */
+int MqttPublisher::Alias(const char *topic)
+{
+	int i;
+
+	for (i = 0; i < aliasmax; i++) {
+		if (strcmp(alias[i].topic, topic) == 0) {
+			return i + 1;
+		}
+		if (alias[i].topic[0] == '\0') {
+			if (topic[0] == '\0' || strlen(topic) >= MQTTTOPICSZ) {
+				return 0;
+			}
+			strcpy(alias[i].topic, topic);
+			alias[i].established = false;
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+/** @brief Marks the session up, aliases start afresh on every session
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int aliases Topic Alias Maximum from the CONNACK, 0 on MQTT 3.1.1
+ *  @return void
+ */
+void MqttPublisher::Up(int aliases)
+{
+	pthread_mutex_lock(&lock);
+	memset(alias, 0, sizeof(alias));
+	aliasmax = aliases > MQTTALIASMAX ? MQTTALIASMAX : aliases;
+	pthread_mutex_unlock(&lock);
+	connects++;
+	backoffms = MQTTBACKOFFMINMS;
+	nextattempt = 0;
+	upsince = DlTimeNow();
+	state.store(DLMQTT_CONNECTED);
+}
+
+/** @brief Marks the session down and adds its time to the uptime
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void MqttPublisher::Down(void)
+{
+	uint64_t since = upsince.exchange(0);
+
+	state.store(DLMQTT_DISCONNECTED);
+	if (since) {
+		uptime += DlTimeNow() - since;
+	}
+}
+
+/** @brief Schedules the next connect attempt, doubling the delay up to
+ *  MQTTBACKOFFMAXMS with +/-25% jitter
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void MqttPublisher::Backoff(void)
+{
+	uint32_t ms = backoffms.load();
+	uint32_t delay = ms - ms / 4 + (uint32_t)(rand() % (ms / 2 + 1));
+
+	nextattempt = DlTimeNow() + delay * NSPERMS;
+	backoffms.store(ms * 2 > MQTTBACKOFFMAXMS ? MQTTBACKOFFMAXMS : ms * 2);
+}
+
+/** @brief Paho callback, CONNACK received
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context MqttPublisher
+ *  @param MQTTAsync_successData * response
+ *  @return void
+ */
+void MqttPublisher::OnConnect(void *context, MQTTAsync_successData *response)
+{
+	((MqttPublisher *)context)->Up(0);
+}
+
+/** @brief Paho callback, MQTT 5 CONNACK received
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context MqttPublisher
+ *  @param MQTTAsync_successData5 * response
+ *  @return void
+ */
+void MqttPublisher::OnConnect5(void *context, MQTTAsync_successData5 *response)
+{
+	int aliases = 0;
+
+	if (response != NULL && MQTTProperties_hasProperty(&response->properties, MQTTPROPERTY_CODE_TOPIC_ALIAS_MAXIMUM)) {
+		aliases = MQTTProperties_getNumericValue(&response->properties, MQTTPROPERTY_CODE_TOPIC_ALIAS_MAXIMUM);
+	}
+	((MqttPublisher *)context)->Up(aliases);
+}
+
+/** @brief Paho callback, the connect attempt failed
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context MqttPublisher
+ *  @param MQTTAsync_failureData * response may be NULL
+ *  @return void
+ */
+void MqttPublisher::OnConnectFailure(void *context, MQTTAsync_failureData *response)
+{
+	MqttPublisher *p = (MqttPublisher *)context;
+
+	p->connectfails++;
+	p->lastrc = response ? response->code : MQTTASYNC_FAILURE;
+	p->Backoff();
+	p->state.store(DLMQTT_DISCONNECTED);
+}
+
+/** @brief Paho callback, the MQTT 5 connect attempt failed
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context MqttPublisher
+ *  @param MQTTAsync_failureData5 * response may be NULL
+ *  @return void
+ */
+void MqttPublisher::OnConnectFailure5(void *context, MQTTAsync_failureData5 *response)
+{
+	MqttPublisher *p = (MqttPublisher *)context;
+
+	p->connectfails++;
+	p->lastrc = response ? response->code : MQTTASYNC_FAILURE;
+	p->Backoff();
+	p->state.store(DLMQTT_DISCONNECTED);
+}
+
+/** @brief Paho callback, a message could not be sent
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context MqttPublisher
+ *  @param MQTTAsync_failureData * response may be NULL
+ *  @return void
+ */
+void MqttPublisher::OnSendFailure(void *context, MQTTAsync_failureData *response)
+{
+	MqttPublisher *p = (MqttPublisher *)context;
+
+	if (response != NULL && p->Release(response->token, response->code, NULL)) {
+		p->failed++;
+		p->lastrc = response->code;
+	}
+}
+
+/** @brief Paho callback, an MQTT 5 message could not be sent
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context MqttPublisher
+ *  @param MQTTAsync_failureData5 * response may be NULL
+ *  @return void
+ */
+void MqttPublisher::OnSendFailure5(void *context, MQTTAsync_failureData5 *response)
+{
+	MqttPublisher *p = (MqttPublisher *)context;
+
+	if (response != NULL && p->Release(response->token, response->code, NULL)) {
+		p->failed++;
+		p->lastrc = response->code;
+	}
+}
+
+/** @brief Paho callback, the broker connection dropped
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context MqttPublisher
+ *  @param char * cause may be NULL
+ *  @return void
+ */
+void MqttPublisher::ConnectionLost(void *context, char *cause)
+{
+	MqttPublisher *p = (MqttPublisher *)context;
+
+	p->Down();
+	p->Abandon();
+	p->losses++;
+	fprintf(stderr, "mqtt: connection lost%s%s\n", cause ? ", " : "", cause ? cause : "");
+}
+
+/** @brief Paho callback, nothing is subscribed so messages are discarded
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @return int 1, the message has been handled
+ */
+int MqttPublisher::MessageArrived(void *context, char *topic, int topiclen, MQTTAsync_message *message)
+{
+	MQTTAsync_freeMessage(&message);
+	MQTTAsync_free(topic);
+	return 1;
+}
+
+/** @brief Paho callback, the broker acknowledged a QoS 1 or 2 message
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context MqttPublisher
+ *  @param MQTTAsync_token token
+ *  @return void
+ */
+void MqttPublisher::DeliveryComplete(void *context, MQTTAsync_token token)
+{
+	MqttPublisher *p = (MqttPublisher *)context;
+	dlinflight_s msg;
+	uint64_t now = DlTimeNow();
+
+	if (p->Release(token, MQTTASYNC_SUCCESS, &msg)) {
+		p->Acked(&msg, now);
+	}
+}
+
+/** @brief Counts an acknowledged message and its latencies
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const dlinflight_s * msg its freed slot
+ *  @param uint64_t now CLOCK_MONOTONIC ns the ack arrived
+ *  @return void
+ */
+void MqttPublisher::Acked(const dlinflight_s *msg, uint64_t now)
+{
+	uint64_t lat = now - msg->sent;
+	uint64_t max;
+
+	delivered++;
+	latsum += lat;
+	max = latmax.load();
+	while (lat > max && !latmax.compare_exchange_weak(max, lat)) {
+	}
+	if (ackhook != NULL) {
+		ackhook(ackcontext, msg->lane, lat);
+	}
+	lat = now - msg->created;
+	laneack[msg->lane]++;
+	lanelat[msg->lane] += lat;
+	max = lanemax[msg->lane].load();
+	while (lat > max && !lanemax[msg->lane].compare_exchange_weak(max, lat)) {
+	}
+}
+
+/** @brief Prints the session state, window and counters
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param FILE * fp
+ *  @return void
+ */
+void MqttPublisher::Report(FILE *fp)
+{
+	static const char *statename[] = { "disconnected", "connecting", "connected" };
+	uint64_t since = upsince.load();
+	uint64_t up = uptime.load() + (since ? DlTimeNow() - since : 0);
+	uint64_t acked = delivered.load();
+	int i;
+
+	fprintf(fp, "mqtt: %s up %.1fs connects %" PRIu64 " failed %" PRIu64 " lost %" PRIu64 " backoff %ums rc %d\n",
+		statename[state.load()], (double)up / NSPERSEC, connects.load(), connectfails.load(), losses.load(),
+		backoffms.load(), lastrc.load());
+	fprintf(fp, "mqtt: inflight %d/%d published %" PRIu64 " delivered %" PRIu64 " failed %" PRIu64 " abandoned %" PRIu64
+		" dropped %" PRIu64 " windowfull %" PRIu64 "\n", inflight.load(), window.load(), published.load(), acked, failed.load(),
+		abandoned.load(), dropped.load(), windowfull.load());
+	fprintf(fp, "mqtt: ack latency avg %.2fms max %.2fms\n",
+		acked ? (double)latsum.load() / acked / NSPERMS : 0.0, (double)latmax.load() / NSPERMS);
+	for (i = 0; i < DLLANE_COUNT; i++) {
+		acked = laneack[i].load();
+		fprintf(fp, "mqtt: lane %-7s published %" PRIu64 " delivered %" PRIu64 " full %" PRIu64
+			" latency avg %.2fms max %.2fms\n", lanename[i], lanepub[i].load(), acked, lanefull[i].load(),
+			acked ? (double)lanelat[i].load() / acked / NSPERMS : 0.0, (double)lanemax[i].load() / NSPERMS);
+	}
+	if (version >= MQTTVERSION_5) {
+		fprintf(fp, "mqtt: v5 aliases %d aliased %" PRIu64 " expiry %ds schema %s\n", aliasmax, aliased.load(),
+			MQTTEXPIRYSEC, MQTTSCHEMA);
+	}
+}
+
+/** @brief Publishes logger data on the persistent MQTT session, never blocks
  *  @author Robert Miller
  *  @date 12Mar2022
  *  @param char * mqttdata
- *  @return int
+ *  @return int MQTTASYNC_SUCCESS or the reason the reading was not sent
  */
 int DlPublishLoggerData(const char * mqttdata) {
-	MQTTClient client;
-	MQTTClient_connectOptions conn_opts = MQTTClient_connectOptions_initializer;
-	MQTTClient_message pubmsg = MQTTClient_message_initializer;
-	MQTTClient_deliveryToken token;
-	int rc;
-	MQTTClient_create(&client, ADDRESS, CLIENTID, MQTTCLIENT_PERSISTENCE_NONE, NULL);
-	conn_opts.keepAliveInterval = 20;
-	conn_opts.cleansession = 1;
-  if ((rc = MQTTClient_connect(client, &conn_opts)) != MQTTCLIENT_SUCCESS) {
-		fprintf(stdout,"Failed to connect, return code %d\n", rc);
-		return -1;
-  }
-	pubmsg.payload = (void *) mqttdata;
-  pubmsg.payloadlen = strlen(mqttdata);
-  pubmsg.qos = QOS;
-  pubmsg.retained = 0;
-	MQTTClient_publishMessage(client, TOPIC, &pubmsg, &token);
-  fprintf(stdout,"Waiting for up to %d seconds for publication of %s\n on topic %s for client with ClientID: %s\n", (int)(TIMEOUT/1000), mqttdata, TOPIC, CLIENTID);
-  rc = MQTTClient_waitForCompletion(client, token, TIMEOUT);
-  fprintf(stdout,"Message with delivery token %d delivered\n", token);
-  MQTTClient_disconnect(client, 10000);
-  MQTTClient_destroy(&client);
-  return rc;
+	return publisher.Publish(TOPIC, mqttdata, strlen(mqttdata), QOS);
+}
+
+/** @brief Publishes a batch payload built by dlbatch, never blocks
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * topic BATCHTOPIC for JSON, CBORTOPIC for CBOR
+ *  @param const void * payload
+ *  @param size_t len
+ *  @return int MQTTASYNC_SUCCESS or the reason the batch was not sent
+ */
+int DlPublishLoggerBatch(const char *topic, const void *payload, size_t len) {
+	return publisher.Publish(topic, payload, (int)len, QOS);
+}
+
+/** @brief Publishes a payload on a lane with the lane's QoS, never blocks
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dllane_e lane
+ *  @param const char * topic
+ *  @param const void * payload
+ *  @param size_t len
+ *  @param uint64_t created CLOCK_MONOTONIC ns the payload was created, for the lane latency, 0 now
+ *  @return int MQTTASYNC_SUCCESS or the reason the payload was not sent
+ */
+int DlPublishLane(dllane_e lane, const char *topic, const void *payload, size_t len, uint64_t created) {
+	return publisher.Publish(topic, payload, (int)len, laneqos[lane], lane, created);
+}
+
+/** @brief Free in-flight slots, 0 while the session is down
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return int
+ */
+int DlMqttRoom(void) {
+	return publisher.Room();
+}
+
+/** @brief Meters every later publish against an uplink budget
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlbudget_s * b NULL to stop metering
+ *  @return void
+ */
+void DlMqttBudget(dlbudget_s *b) {
+	publisher.SetBudget(b);
+}
+
+/** @brief Closes the MQTT session, call after the publish stage has stopped
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return void
+ */
+void DlMqttStop(void) {
+	publisher.Disconnect();
+}
+
+/** @brief Prints the MQTT session metrics
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param FILE * fp
+ *  @return void
+ */
+void DlMqttReport(FILE *fp) {
+	publisher.Report(fp);
 }
@@ -1,14 +1,203 @@
-#include <MQTTClient.h>
+#include <MQTTAsync.h>
 
 #ifndef LOGGERMQTT_H
 #define LOGGERMQTT_H
 
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <pthread.h>
+#include "dlbudget.h"
+
 #define ADDRESS "tcp://localhost:1883"
 #define CLIENTID "VehicleDataLogger"
 #define TOPIC "Logger Data"
+#define BATCHTOPIC "Logger Data/batch"
+#define CBORTOPIC "Logger Data/cbor"
+#define ALERTTOPIC "Logger Data/alert"
+#define CHANNELTOPIC "Logger Data/%" PRIx64 "/%s"  ///< Unit serial, field name
+#define CHANNELTOPICSZ 64
 #define QOS 1
+#define ALERTQOS 1
+#define BACKLOGQOS 1
 #define TIMEOUT 10000L
+#define MQTTKEEPALIVE 20
+#define MQTTCONNECTTIMEOUT 5
+#define MQTTDISCONNECTMS 1000
+#define MQTTBACKOFFMINMS 500
+#define MQTTBACKOFFMAXMS 30000
+#define MQTTWINDOW 16
+#define MQTTWINDOWMAX 256
+#define MQTTALERTSLOTS 2       ///< In-flight slots only alerts may use
+#define MQTTBACKLOGSLOTS 4     ///< In-flight slots live data leaves to a draining backlog
+#define MQTTBACKLOGACTIVEMS 1000  ///< A backlog publish this recent counts as draining
+#define MQTTPROTOCOL MQTTVERSION_3_1_1  ///< MQTTVERSION_5 adds topic aliases, expiry and user properties
+#define MQTTEXPIRYSEC 30       ///< MQTT 5, the broker drops messages still queued after this
+#define MQTTSCHEMAKEY "schema" ///< MQTT 5 user property naming the payload schema
+#define MQTTSCHEMA "1"
+#define MQTTALIASMAX 32        ///< MQTT 5 topic aliases used, fewer if the broker allows fewer
+#define MQTTTOPICSZ 64         ///< Longest topic given an alias
+#define MQTTPUBOVERHEAD 10     ///< PUBLISH fixed header, topic length and packet id, and the PUBACK
+#define MQTTV5OVERHEAD 22      ///< MQTT 5 property length, expiry, schema and alias properties
+#define MQTTBUDGETREFUSED -100 ///< Publish result when the uplink budget is spent
+
+enum dlmqttstate_e
+{
+	DLMQTT_DISCONNECTED,  ///< No session, next attempt after the backoff
+	DLMQTT_CONNECTING,    ///< MQTTAsync_connect issued, waiting for CONNACK
+	DLMQTT_CONNECTED      ///< Session up, publishes go straight out
+};
+
+/** Publish lanes, highest priority first. Each lane has its own QoS and
+ *  its own share of the in-flight window: alerts may use every slot,
+ *  live data all but MQTTALERTSLOTS, and while a backlog is draining live
+ *  data also leaves it MQTTBACKLOGSLOTS, its guaranteed minimum share.
+ */
+enum dllane_e
+{
+	DLLANE_ALERT,    ///< Driving events
+	DLLANE_LIVE,     ///< Readings as they are taken
+	DLLANE_BACKLOG,  ///< Spooled payloads
+	DLLANE_COUNT
+};
+
+typedef struct dlinflight
+{
+	MQTTAsync_token token;  ///< Paho token of the QoS 1/2 message, 0 if the slot is free
+	uint64_t sent;          ///< CLOCK_MONOTONIC ns it was handed to Paho
+	uint64_t created;       ///< CLOCK_MONOTONIC ns the payload was created
+	dllane_e lane;
+	bool pending;           ///< Reserved by a Publish still handing the message to Paho
+} dlinflight_s;
+
+/** An ack or send failure that arrived before the Publish that sent the
+ *  message had recorded its token
+ */
+typedef struct dlparked
+{
+	MQTTAsync_token token;
+	int rc;                 ///< MQTTASYNC_SUCCESS for an ack, else the failure code
+	uint64_t at;            ///< CLOCK_MONOTONIC ns it arrived
+} dlparked_s;
+
+/** Called on the Paho thread for each acknowledged message with its
+ *  publish to PUBACK (PUBCOMP at QoS 2) latency in ns
+ */
+typedef void dlackhook_f(void *context, dllane_e lane, uint64_t latns);
+
+typedef struct dlalias
+{
+	char topic[MQTTTOPICSZ];  ///< Topic of alias index + 1, empty if unused
+	bool established;         ///< The broker has seen the topic with its alias
+} dlalias_s;
+
+/** @brief One long lived asynchronous MQTT session. Publish never waits:
+ *  it hands the message to Paho, or refuses it when the in-flight window
+ *  is full or the session is down. Acknowledgements and connection changes
+ *  arrive on the Paho thread and feed the latency and ack counters. A
+ *  lost session is reopened by a later Publish once the backoff expires.
+ *  On MQTT 5 each topic is sent once per session with a topic alias and
+ *  then only the alias, every message carries MQTTEXPIRYSEC and the
+ *  schema user property. With a dlbudget set each message is charged its
+ *  wire size and refused once its lane's share of the budget is spent.
+ */
+class MqttPublisher
+{
+public:
+	MqttPublisher(const char *address = ADDRESS, const char *clientid = CLIENTID, int window = MQTTWINDOW,
+		int version = MQTTPROTOCOL);
+	~MqttPublisher(void);
+
+	MqttPublisher(const MqttPublisher &) = delete;
+	MqttPublisher &operator=(const MqttPublisher &) = delete;
+
+	int  Connect(void);
+	void Disconnect(void);
+	int  Publish(const char *topic, const void *payload, int len, int qos = QOS, dllane_e lane = DLLANE_LIVE,
+		uint64_t created = 0);
+	void SetWindow(int window);
+	void SetBudget(dlbudget_s *b) { budget = b; }
+	void SetAckHook(dlackhook_f *hook, void *context) { ackcontext = context; ackhook = hook; }
+	dlmqttstate_e State(void) const { return state.load(); }
+	int  InFlight(void) const { return inflight.load(); }
+	int  Version(void) const { return version; }
+	int  Room(void) const { return state.load() == DLMQTT_CONNECTED ? window.load() - inflight.load() : 0; }
+	uint64_t LaneAcked(dllane_e lane) const { return laneack[lane].load(); }
+	uint64_t LaneLatency(dllane_e lane) const { return lanelat[lane].load(); }
+	uint64_t LaneMax(dllane_e lane) const { return lanemax[lane].load(); }
+	void Report(FILE *fp);
+
+private:
+	static void OnConnect(void *context, MQTTAsync_successData *response);
+	static void OnConnectFailure(void *context, MQTTAsync_failureData *response);
+	static void OnSendFailure(void *context, MQTTAsync_failureData *response);
+	static void OnConnect5(void *context, MQTTAsync_successData5 *response);
+	static void OnConnectFailure5(void *context, MQTTAsync_failureData5 *response);
+	static void OnSendFailure5(void *context, MQTTAsync_failureData5 *response);
+	static void ConnectionLost(void *context, char *cause);
+	static int  MessageArrived(void *context, char *topic, int topiclen, MQTTAsync_message *message);
+	static void DeliveryComplete(void *context, MQTTAsync_token token);
+	bool Release(MQTTAsync_token token, int rc, dlinflight_s *msg);
+	bool Unpark(int i, dlparked_s *ack, dlinflight_s *msg);
+	void Acked(const dlinflight_s *msg, uint64_t now);
+	int  LaneLimit(dllane_e lane);
+	void Abandon(void);
+	void Backoff(void);
+	void Up(int aliases);
+	void Down(void);
+	int  Alias(const char *topic);
+
+	const char *address;
+	const char *clientid;
+	MQTTAsync client;
+	bool created;
+	std::atomic<int> window;             // QoS 1/2 messages allowed in flight, set under lock
+	int version;                         // MQTTVERSION_3_1_1 or MQTTVERSION_5
+	int aliasmax;                        // topic aliases this session, guarded by lock
+	dlbudget_s *budget;                  // charged the wire size of each message, NULL unmetered
+	dlackhook_f *ackhook;                // told every ack latency, NULL none
+	void *ackcontext;
+	dlalias_s alias[MQTTALIASMAX];       // topic of each alias, guarded by lock
+	dlinflight_s slot[MQTTWINDOWMAX];    // messages in flight, guarded by lock
+	dlparked_s parked[MQTTWINDOWMAX];    // early acks, guarded by lock
+	int nparked;                         // guarded by lock
+	int pending;                         // slots reserved by a send in progress, guarded by lock
+	uint32_t session;                    // bumped by Abandon, guarded by lock
+	pthread_mutex_t lock;
+	std::atomic<int> inflight;
+	std::atomic<dlmqttstate_e> state;
+	std::atomic<uint64_t> nextattempt;   // CLOCK_MONOTONIC ns of the next connect attempt
+	std::atomic<uint32_t> backoffms;     // delay after the next failure
+	std::atomic<uint64_t> upsince;       // CLOCK_MONOTONIC ns the session came up
+	std::atomic<uint64_t> uptime;        // ns connected in earlier sessions
+	std::atomic<int> lastrc;             // return code of the last failed call
+	std::atomic<uint64_t> connects;
+	std::atomic<uint64_t> connectfails;
+	std::atomic<uint64_t> losses;
+	std::atomic<uint64_t> published;
+	std::atomic<uint64_t> delivered;
+	std::atomic<uint64_t> failed;
+	std::atomic<uint64_t> abandoned;     // in flight when the session was lost
+	std::atomic<uint64_t> dropped;       // refused while disconnected
+	std::atomic<uint64_t> windowfull;    // refused because the window was full
+	std::atomic<uint64_t> latsum;        // ns, publish to PUBACK, delivered messages
+	std::atomic<uint64_t> latmax;
+	std::atomic<uint64_t> aliased;       // sent with an empty topic and its alias
+	std::atomic<uint64_t> lastbacklog;   // CLOCK_MONOTONIC ns of the last backlog publish
+	std::atomic<uint64_t> lanepub[DLLANE_COUNT];
+	std::atomic<uint64_t> laneack[DLLANE_COUNT];
+	std::atomic<uint64_t> lanefull[DLLANE_COUNT];  // refused, the lane's share was in flight
+	std::atomic<uint64_t> lanelat[DLLANE_COUNT];   // ns, created to PUBACK
+	std::atomic<uint64_t> lanemax[DLLANE_COUNT];
+};
 
 int DlPublishLoggerData(const char * mqttdata);
+int DlPublishLoggerBatch(const char *topic, const void *payload, size_t len);
+int DlPublishLane(dllane_e lane, const char *topic, const void *payload, size_t len, uint64_t created);
+int DlMqttRoom(void);
+void DlMqttBudget(dlbudget_s *b);
+void DlMqttStop(void);
+void DlMqttReport(FILE *fp);
 
 #endif
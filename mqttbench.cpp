@@ -0,0 +1,470 @@
+/** @file mqttbench.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Compares one JSON message per reading against batched JSON and CBOR
+ *  payloads and per-channel topics with deadbands
+ *
+ *  usage: mqttbench [readings] [batch] [broker] [3|5]
+ *
+ *  Always measures encoding, messages/s and bytes/reading including the
+ *  MQTT 3.1.1 PUBLISH and PUBACK overhead. With a broker URI, e.g.
+ *  tcp://localhost:1883, every path is also published at QoS 1 and timed
+ *  until every message is acknowledged, and the bytes the process wrote
+ *  (wchar in /proc/self/io) give the real PUBLISH size. 5 connects with
+ *  MQTT 5, topic aliases, expiry and the schema user property.
+ *
+ *  With a broker the readings are also replayed as a spooled backlog
+ *  drained as fast as the window allows, with an alert raised every
+ *  BENCHALERTEVERY messages. fifo sends each alert behind the backlog
+ *  still queued, as a single queue would, lanes sends it at once on the
+ *  alert lane. Alert latency runs from the alert being raised to its
+ *  PUBACK.
+ */
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "dlalert.h"
+#include "dlbatch.h"
+#include "dldeadband.h"
+#include "dlformat.h"
+#include "dltime.h"
+#include "loggermqtt.h"
+
+#define BENCHREADINGS 10000
+#define BENCHBATCH 32
+#define BENCHPERIODMS 10
+#define BENCHCLIENTID "VehicleDataLoggerBench"
+#define BENCHWAITMS 10000
+#define BENCHALERTEVERY 500
+#define BENCHALERTSZ 64          ///< Alerts a fifo run can hold behind the backlog
+
+typedef struct benchresult
+{
+	uint64_t messages;   ///< PUBLISH packets
+	uint64_t payload;    ///< Payload bytes
+	uint64_t wire;       ///< Payload plus PUBLISH and PUBACK overhead
+	double encodes;      ///< Seconds spent encoding
+	double sends;        ///< Seconds until every message was acknowledged, 0 if not published
+	uint64_t written;    ///< Bytes the process wrote while publishing
+} benchresult_s;
+
+/** @brief Bytes an MQTT 3.1.1 QoS 1 PUBLISH and its PUBACK take on the wire
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param size_t payload
+ *  @param const char * topic
+ *  @return size_t
+ */
+static size_t BenchWire(size_t payload, const char *topic)
+{
+	size_t remaining = 2 + strlen(topic) + 2 + payload;
+	size_t lenbytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : remaining < 2097152 ? 3 : 4;
+
+	return 1 + lenbytes + remaining + 4;
+}
+
+/** @brief Bytes the process has written to files and sockets
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void
+ *  @return uint64_t wchar from /proc/self/io, 0 if unavailable
+ */
+static uint64_t BenchWchar(void)
+{
+	char line[64];
+	uint64_t wchar = 0;
+	FILE *fp = fopen("/proc/self/io", "r");
+
+	if (fp == NULL) {
+		return 0;
+	}
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "wchar: %" SCNu64, &wchar) == 1) {
+			break;
+		}
+	}
+	fclose(fp);
+	return wchar;
+}
+
+/** @brief Fills readings spaced BENCHPERIODMS apart with plausible values
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param reading_s * r
+ *  @param int n
+ *  @return void
+ */
+static void BenchReadings(reading_s *r, int n)
+{
+	uint64_t now = DlTimeNow();
+	int i;
+
+	memset(r, 0, n * sizeof(*r));
+	for (i = 0; i < n; i++) {
+		r[i].tns = now + (uint64_t)i * BENCHPERIODMS * NSPERMS;
+		r[i].toffset = DlTimeOffset();
+		r[i].temperature = 20.7f + 0.01f * (i % 50);
+		r[i].humidity = 28;
+		r[i].pressure = 1003.0f;
+		r[i].xa = -0.003172f + 0.0001f * sinf(i);
+		r[i].ya = 0.006344f;
+		r[i].za = 0.992836f;
+		r[i].pitch = -0.059473f;
+		r[i].roll = -0.003667f;
+		r[i].yaw = -0.044193f + 0.001f * i;
+		r[i].xm = 24.693150f;
+		r[i].ym = 32.525532f;
+		r[i].zm = 44.811523f;
+		r[i].latitude = 43.7289f;
+		r[i].longitude = -79.6074f;
+		r[i].altitude = 166;
+		r[i].speed = 99;
+		r[i].heading = 320;
+	}
+}
+
+/** @brief Publishes one payload, waiting while the window is full
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param MqttPublisher * pub NULL to only encode
+ *  @param const char * topic
+ *  @param const char * payload
+ *  @param size_t len
+ *  @return void
+ */
+static void BenchSend(MqttPublisher *pub, const char *topic, const char *payload, size_t len)
+{
+	if (pub == NULL) {
+		return;
+	}
+	while (pub->Publish(topic, payload, (int)len, QOS) == MQTTASYNC_MAX_BUFFERED_MESSAGES) {
+		usleep(50);
+	}
+}
+
+/** @brief Publishes one message on a lane, waiting for room in its share of the window
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param MqttPublisher * pub
+ *  @param dllane_e lane
+ *  @param const char * topic
+ *  @param const char * payload
+ *  @param size_t len
+ *  @param uint64_t created
+ *  @return void
+ */
+static void BenchSendLane(MqttPublisher *pub, dllane_e lane, const char *topic, const char *payload, size_t len,
+	uint64_t created)
+{
+	while (pub->Publish(topic, payload, (int)len, QOS, lane, created) == MQTTASYNC_MAX_BUFFERED_MESSAGES) {
+		usleep(50);
+	}
+}
+
+/** @brief Waits until every QoS 1 message has been acknowledged
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param MqttPublisher * pub
+ *  @return void
+ */
+static void BenchDrain(MqttPublisher *pub)
+{
+	int waitms;
+
+	for (waitms = 0; pub != NULL && pub->InFlight() > 0 && waitms < BENCHWAITMS; waitms++) {
+		usleep(1000);
+	}
+}
+
+/** @brief One JSON message per reading, the current path
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s * r
+ *  @param int n
+ *  @param MqttPublisher * pub NULL to only encode
+ *  @return benchresult_s
+ */
+static benchresult_s BenchSingle(const reading_s *r, int n, MqttPublisher *pub)
+{
+	benchresult_s res = { 0, 0, 0, 0, 0, 0 };
+	char jsondata[PAYLOADSTRSZ];
+	uint64_t start, enc = 0, t, wchar = BenchWchar();
+	int i, len;
+
+	start = DlTimeNow();
+	for (i = 0; i < n; i++) {
+		t = DlTimeNow();
+		len = DlFormatLoggerJson(r[i], jsondata, sizeof(jsondata));
+		enc += DlTimeNow() - t;
+		BenchSend(pub, TOPIC, jsondata, len);
+		res.messages++;
+		res.payload += len;
+		res.wire += BenchWire(len, TOPIC);
+	}
+	BenchDrain(pub);
+	res.encodes = (double)enc / NSPERSEC;
+	res.sends = pub ? (double)(DlTimeNow() - start) / NSPERSEC : 0;
+	res.written = pub ? BenchWchar() - wchar : 0;
+	return res;
+}
+
+/** @brief Readings packed into batches of up to records
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s * r
+ *  @param int n
+ *  @param int records
+ *  @param dlencoding_e encoding
+ *  @param const char * topic
+ *  @param MqttPublisher * pub NULL to only encode
+ *  @return benchresult_s
+ */
+static benchresult_s BenchBatch(const reading_s *r, int n, int records, dlencoding_e encoding, const char *topic,
+	MqttPublisher *pub)
+{
+	static dlbatch_s batch;
+	dlbatchcfg_s cfg = { records, BATCHLINGERMS };
+	benchresult_s res = { 0, 0, 0, 0, 0, 0 };
+	const char *payload;
+	uint64_t start, enc = 0, t, wchar = BenchWchar();
+	size_t len;
+	int i, full;
+
+	DlBatchInit(&batch, &cfg, 0xe69836d, encoding);
+	start = DlTimeNow();
+	for (i = 0; i < n; i++) {
+		t = DlTimeNow();
+		full = DlBatchAdd(&batch, r[i]);
+		payload = (full || i == n - 1) ? DlBatchFinish(&batch, &len) : NULL;
+		enc += DlTimeNow() - t;
+		if (payload != NULL) {
+			BenchSend(pub, topic, payload, len);
+			res.messages++;
+			res.payload += len;
+			res.wire += BenchWire(len, topic);
+			DlBatchReset(&batch);
+		}
+	}
+	BenchDrain(pub);
+	res.encodes = (double)enc / NSPERSEC;
+	res.sends = pub ? (double)(DlTimeNow() - start) / NSPERSEC : 0;
+	res.written = pub ? BenchWchar() - wchar : 0;
+	return res;
+}
+
+/** @brief Each field on its own topic when it leaves its deadband, heartbeats
+ *  timed on the reading clock
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const reading_s * r
+ *  @param int n
+ *  @param MqttPublisher * pub NULL to only encode
+ *  @return benchresult_s
+ */
+static benchresult_s BenchChannels(const reading_s *r, int n, MqttPublisher *pub)
+{
+	static dldeadband_s deadband;
+	char topic[DLNFIELDS][CHANNELTOPICSZ];
+	char jsondata[PAYLOADSTRSZ];
+	benchresult_s res = { 0, 0, 0, 0, 0, 0 };
+	uint64_t start, enc = 0, t, wchar = BenchWchar();
+	int i, k, len;
+
+	DlDeadbandInit(&deadband, NULL);
+	for (k = 0; k < DLNFIELDS; k++) {
+		snprintf(topic[k], CHANNELTOPICSZ, CHANNELTOPIC, (uint64_t)0xe69836d, dlfields[k].name);
+	}
+	start = DlTimeNow();
+	for (i = 0; i < n; i++) {
+		for (k = 0; k < DLNFIELDS; k++) {
+			t = DlTimeNow();
+			len = DlDeadbandUpdate(&deadband, k, r[i].*dlfields[k].member, r[i].tns) ?
+				DlFormatChannel(r[i], k, jsondata, sizeof(jsondata)) : 0;
+			enc += DlTimeNow() - t;
+			if (len > 0) {
+				BenchSend(pub, topic[k], jsondata, len);
+				res.messages++;
+				res.payload += len;
+				res.wire += BenchWire(len, topic[k]);
+			}
+		}
+	}
+	BenchDrain(pub);
+	res.encodes = (double)enc / NSPERSEC;
+	res.sends = pub ? (double)(DlTimeNow() - start) / NSPERSEC : 0;
+	res.written = pub ? BenchWchar() - wchar : 0;
+	return res;
+}
+
+/** @brief Drains the readings as a backlog of JSON messages while raising
+ *  alerts, and prints the alert latency
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * name
+ *  @param const reading_s * r
+ *  @param int n
+ *  @param MqttPublisher * pub fresh session, the lane counters start at 0
+ *  @param bool lanes send alerts at once rather than behind the backlog
+ *  @return void
+ */
+static void BenchLanes(const char *name, const reading_s *r, int n, MqttPublisher *pub, bool lanes)
+{
+	char jsondata[PAYLOADSTRSZ];
+	char alertdata[ALERTPAYLOADSZ];
+	dlalert_s alert[BENCHALERTSZ];
+	uint64_t start, acked;
+	int i, len, queued = 0, raised = 0;
+
+	start = DlTimeNow();
+	for (i = 0; i < n; i++) {
+		if (i % BENCHALERTEVERY == BENCHALERTEVERY / 2 && queued < BENCHALERTSZ) {
+			alert[queued].tns = DlTimeNow();
+			alert[queued].toffset = r[i].toffset;
+			alert[queued].kind = DLALERT_HARSH;
+			alert[queued].g = 0.5f;
+			queued++;
+			raised++;
+		}
+		while (lanes && queued > 0) {
+			queued--;
+			len = DlFormatAlert(alert[queued], alertdata, sizeof(alertdata));
+			BenchSendLane(pub, DLLANE_ALERT, ALERTTOPIC, alertdata, len, alert[queued].tns);
+		}
+		len = DlFormatLoggerJson(r[i], jsondata, sizeof(jsondata));
+		BenchSendLane(pub, DLLANE_BACKLOG, TOPIC, jsondata, len, 0);
+	}
+	while (queued > 0) {
+		queued--;
+		len = DlFormatAlert(alert[queued], alertdata, sizeof(alertdata));
+		BenchSendLane(pub, DLLANE_ALERT, ALERTTOPIC, alertdata, len, alert[queued].tns);
+	}
+	BenchDrain(pub);
+	acked = pub->LaneAcked(DLLANE_ALERT);
+	fprintf(stdout, "%-10s %8d %10.0f %8d %8" PRIu64 " %12.2f %12.2f\n", name, n,
+		n / ((double)(DlTimeNow() - start) / NSPERSEC), raised, acked,
+		acked ? (double)pub->LaneLatency(DLLANE_ALERT) / acked / NSPERMS : 0.0,
+		(double)pub->LaneMax(DLLANE_ALERT) / NSPERMS);
+}
+
+/** @brief Starts a session and waits for it to come up
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * uri
+ *  @param int version
+ *  @return MqttPublisher * connected publisher, NULL on failure
+ */
+static MqttPublisher *BenchConnect(const char *uri, int version)
+{
+	MqttPublisher *pub = new MqttPublisher(uri, BENCHCLIENTID, MQTTWINDOW, version);
+	int waitms;
+
+	pub->Connect();
+	for (waitms = 0; pub->State() != DLMQTT_CONNECTED && waitms < BENCHWAITMS; waitms += 10) {
+		usleep(10000);
+	}
+	if (pub->State() != DLMQTT_CONNECTED) {
+		fprintf(stderr, "could not connect to %s\n", uri);
+		delete pub;
+		return NULL;
+	}
+	return pub;
+}
+
+/** @brief Ends a session started by BenchConnect
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param MqttPublisher * pub
+ *  @return void
+ */
+static void BenchDisconnect(MqttPublisher *pub)
+{
+	pub->Disconnect();
+	delete pub;
+}
+
+/** @brief Prints one result line
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * name
+ *  @param const benchresult_s * res
+ *  @param int n readings
+ *  @return void
+ */
+static void BenchPrint(const char *name, const benchresult_s *res, int n)
+{
+	fprintf(stdout, "%-10s %8" PRIu64 " %12.0f %12.0f %10.1f %10.1f", name, res->messages,
+		res->encodes > 0 ? res->messages / res->encodes : 0.0, res->encodes > 0 ? n / res->encodes : 0.0,
+		(double)res->payload / n, (double)res->wire / n);
+	if (res->sends > 0) {
+		fprintf(stdout, " %10.0f %10.0f %10.1f", res->messages / res->sends, n / res->sends,
+			res->messages ? (double)res->written / res->messages : 0.0);
+	}
+	fprintf(stdout, "\n");
+}
+
+/** @brief Runs every path and prints messages/s and bytes/reading
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int argc
+ *  @param char ** argv optional readings, batch size, broker URI and MQTT version
+ *  @return int program status
+ */
+int main(int argc, char **argv)
+{
+	int n = argc > 1 ? atoi(argv[1]) : BENCHREADINGS;
+	int records = argc > 2 ? atoi(argv[2]) : BENCHBATCH;
+	int version = argc > 4 && atoi(argv[4]) == 5 ? MQTTVERSION_5 : MQTTVERSION_3_1_1;
+	MqttPublisher *pub = NULL;
+	benchresult_s single, batched, cbor1, cbor, channels;
+	reading_s *r;
+
+	if (n <= 0 || records <= 1 || records > BATCHMAXRECORDS) {
+		fprintf(stderr, "usage: %s [readings] [batch 2..%d] [broker] [3|5]\n", argv[0], BATCHMAXRECORDS);
+		return 1;
+	}
+	r = (reading_s *)malloc(n * sizeof(*r));
+	if (r == NULL) {
+		return 1;
+	}
+	BenchReadings(r, n);
+	if (argc > 3 && (pub = BenchConnect(argv[3], version)) == NULL) {
+		free(r);
+		return 1;
+	}
+	single = BenchSingle(r, n, pub);
+	batched = BenchBatch(r, n, records, DLENC_JSON, BATCHTOPIC, pub);
+	cbor1 = BenchBatch(r, n, 1, DLENC_CBOR, CBORTOPIC, pub);
+	cbor = BenchBatch(r, n, records, DLENC_CBOR, CBORTOPIC, pub);
+	channels = BenchChannels(r, n, pub);
+	fprintf(stdout, "readings %d batch %d%s%s%s\n", n, records, pub ? " broker " : "", pub ? argv[3] : "",
+		pub ? (version == MQTTVERSION_5 ? " mqtt 5" : " mqtt 3.1.1") : "");
+	fprintf(stdout, "%-10s %8s %12s %12s %10s %10s", "path", "msgs", "enc msg/s", "enc rdg/s", "B/rdg", "wire B/rdg");
+	if (pub != NULL) {
+		fprintf(stdout, " %10s %10s %10s", "pub msg/s", "pub rdg/s", "sent B/msg");
+	}
+	fprintf(stdout, "\n");
+	BenchPrint("single", &single, n);
+	BenchPrint("batch", &batched, n);
+	BenchPrint("cbor1", &cbor1, n);
+	BenchPrint("cbor", &cbor, n);
+	BenchPrint("channels", &channels, n);
+	if (pub != NULL) {
+		pub->Report(stdout);
+		BenchDisconnect(pub);
+		fprintf(stdout, "%-10s %8s %10s %8s %8s %12s %12s\n", "backlog", "msgs", "msg/s", "alerts", "acked",
+			"alert avg ms", "alert max ms");
+		if ((pub = BenchConnect(argv[3], version)) != NULL) {
+			BenchLanes("fifo", r, n, pub, false);
+			BenchDisconnect(pub);
+		}
+		if ((pub = BenchConnect(argv[3], version)) != NULL) {
+			BenchLanes("lanes", r, n, pub, true);
+			BenchDisconnect(pub);
+		}
+	}
+	free(r);
+	return 0;
+}
@@ -0,0 +1,414 @@
+/** @file mqttsweep.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Sweeps MqttPublisher throughput and publish to ack latency
+ *  across payload size, QoS, batch size and in-flight window
+ *
+ *  usage: mqttsweep [-b broker] [-p port] [-n readings] [-s sizes]
+ *                   [-q qoses] [-B batches] [-w windows] [-j]
+ *
+ *  Without -b a private mosquitto is started on port (SWEEPPORT) and
+ *  stopped at the end. Each list is comma separated. A reading is a JSON
+ *  record of size bytes and batch of them are sent as one JSON array, so
+ *  every run sends readings/batch messages of about size * batch bytes.
+ *  One CSV line per run goes to stdout, or one JSON object per line with
+ *  -j. Latency runs from the publish to the PUBACK, PUBCOMP at QoS 2, and
+ *  is not measured at QoS 0. Messages go on the alert lane, the live lane
+ *  keeps MQTTALERTSLOTS of the window back, so a run's window is the
+ *  number actually in flight. The session is opened once with Paho
+ *  allowing MQTTWINDOWMAX in flight, and each run narrows the window
+ *  with SetWindow. Progress and errors go to stderr.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "dltime.h"
+#include "loggermqtt.h"
+
+#define SWEEPREADINGS 10000
+#define SWEEPSIZES "64,256,1024,4096"
+#define SWEEPQOS "0,1,2"
+#define SWEEPBATCHES "1,8,32"
+#define SWEEPWINDOWS "1,16,64"
+#define SWEEPPORT "18830"
+#define SWEEPBROKER "mosquitto"
+#define SWEEPCLIENTID "VehicleDataLoggerSweep"
+#define SWEEPWAITMS 10000
+#define SWEEPLISTMAX 16
+#define SWEEPMINSIZE 16           ///< {"pad":""} and room for the padding
+#define SWEEPMAXSIZE 65536
+
+typedef struct sweeprun
+{
+	int size;            ///< Bytes per reading
+	int qos;
+	int batch;           ///< Readings per message
+	int window;          ///< QoS 1/2 messages in flight
+	uint64_t messages;   ///< Published
+	uint64_t acked;      ///< Acknowledged, 0 at QoS 0
+	uint64_t bytes;      ///< Payload bytes published
+	double seconds;      ///< First publish until the last ack
+	uint64_t p50;        ///< ns
+	uint64_t p99;
+	uint64_t p999;
+	uint64_t max;
+} sweeprun_s;
+
+typedef struct sweeplat
+{
+	uint64_t *ns;                 ///< One sample per acknowledged message
+	size_t cap;
+	std::atomic<size_t> count;
+} sweeplat_s;
+
+/** @brief Records one publish to ack latency, runs on the Paho thread
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context sweeplat_s
+ *  @param dllane_e lane unused
+ *  @param uint64_t latns
+ *  @return void
+ */
+static void SweepAck(void *context, dllane_e lane, uint64_t latns)
+{
+	sweeplat_s *lat = (sweeplat_s *)context;
+	size_t i = lat->count++;
+
+	if (i < lat->cap) {
+		lat->ns[i] = latns;
+	}
+}
+
+/** @brief Parses a comma separated list of positive integers
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * text
+ *  @param int * list receives the values
+ *  @param int min smallest value accepted
+ *  @param int max largest value accepted
+ *  @return int number of values, 0 if the list is empty or a value is out of range
+ */
+static int SweepList(const char *text, int *list, int min, int max)
+{
+	char *end;
+	long v;
+	int n = 0;
+
+	while (*text != '\0' && n < SWEEPLISTMAX) {
+		v = strtol(text, &end, 10);
+		if (end == text || v < min || v > max || (*end != ',' && *end != '\0')) {
+			return 0;
+		}
+		list[n++] = (int)v;
+		text = *end == ',' ? end + 1 : end;
+	}
+	return *text == '\0' ? n : 0;
+}
+
+/** @brief Builds a payload of batch records of size bytes, one record on its own
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param char * buf
+ *  @param int size bytes per record, at least SWEEPMINSIZE
+ *  @param int batch records, more than one are sent as a JSON array
+ *  @return size_t payload length
+ */
+static size_t SweepPayload(char *buf, int size, int batch)
+{
+	size_t len = 0;
+	int i;
+
+	if (batch > 1) {
+		buf[len++] = '[';
+	}
+	for (i = 0; i < batch; i++) {
+		if (i > 0) {
+			buf[len++] = ',';
+		}
+		memcpy(buf + len, "{\"pad\":\"", 8);
+		memset(buf + len + 8, 'x', size - 10);
+		memcpy(buf + len + size - 2, "\"}", 2);
+		len += size;
+	}
+	if (batch > 1) {
+		buf[len++] = ']';
+	}
+	return len;
+}
+
+/** @brief Sorts the latency samples
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const void * a
+ *  @param const void * b
+ *  @return int
+ */
+static int SweepCompare(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/** @brief Sample at a quantile of sorted samples, nearest rank
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const uint64_t * ns sorted
+ *  @param size_t n
+ *  @param double q 0..1
+ *  @return uint64_t ns, 0 with no samples
+ */
+static uint64_t SweepQuantile(const uint64_t *ns, size_t n, double q)
+{
+	size_t rank = (size_t)(q * n + 0.999999);
+
+	if (n == 0) {
+		return 0;
+	}
+	return ns[rank == 0 ? 0 : std::min(rank, n) - 1];
+}
+
+/** @brief Publishes every message of one run and waits for the acks
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param MqttPublisher * pub connected, nothing in flight
+ *  @param sweeplat_s * lat
+ *  @param const char * payload
+ *  @param size_t len
+ *  @param sweeprun_s * run size, qos, batch and window in, results out
+ *  @param int readings
+ *  @return bool false if the session was lost
+ */
+static bool SweepRun(MqttPublisher *pub, sweeplat_s *lat, const char *payload, size_t len, sweeprun_s *run,
+	int readings)
+{
+	uint64_t messages = (readings + run->batch - 1) / run->batch;
+	uint64_t start, i;
+	size_t n;
+	int rc, waitms;
+
+	pub->SetWindow(run->window);
+	lat->count = 0;
+	run->messages = 0;
+	run->bytes = 0;
+	start = DlTimeNow();
+	for (i = 0; i < messages; i++) {
+		// the alert lane is the only one allowed the whole window
+		while ((rc = pub->Publish(TOPIC, payload, (int)len, run->qos, DLLANE_ALERT)) ==
+			MQTTASYNC_MAX_BUFFERED_MESSAGES) {
+			usleep(20);
+		}
+		if (rc != MQTTASYNC_SUCCESS) {
+			return false;
+		}
+		run->messages++;
+		run->bytes += len;
+	}
+	for (waitms = 0; pub->InFlight() > 0 && waitms < SWEEPWAITMS; waitms++) {
+		usleep(1000);
+	}
+	run->seconds = (double)(DlTimeNow() - start) / NSPERSEC;
+	n = std::min(lat->count.load(), lat->cap);
+	run->acked = n;
+	qsort(lat->ns, n, sizeof(*lat->ns), SweepCompare);
+	run->p50 = SweepQuantile(lat->ns, n, 0.50);
+	run->p99 = SweepQuantile(lat->ns, n, 0.99);
+	run->p999 = SweepQuantile(lat->ns, n, 0.999);
+	run->max = n ? lat->ns[n - 1] : 0;
+	return true;
+}
+
+/** @brief Writes one result as CSV or a JSON object
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const sweeprun_s * run
+ *  @param int readings
+ *  @param bool json
+ *  @return void
+ */
+static void SweepPrint(const sweeprun_s *run, int readings, bool json)
+{
+	double s = run->seconds > 0 ? run->seconds : 1e-9;
+
+	if (json) {
+		fprintf(stdout, "{\"size\":%d,\"qos\":%d,\"batch\":%d,\"window\":%d,\"messages\":%" PRIu64 ",\"acked\":%" PRIu64
+			",\"bytes\":%" PRIu64 ",\"seconds\":%.6f,\"msg_s\":%.1f,\"bytes_s\":%.1f,\"readings_s\":%.1f,\"p50_us\":%.1f"
+			",\"p99_us\":%.1f,\"p999_us\":%.1f,\"max_us\":%.1f}\n", run->size, run->qos, run->batch, run->window,
+			run->messages, run->acked, run->bytes, run->seconds, run->messages / s, run->bytes / s, readings / s,
+			(double)run->p50 / NSPERUS, (double)run->p99 / NSPERUS, (double)run->p999 / NSPERUS,
+			(double)run->max / NSPERUS);
+	} else {
+		fprintf(stdout, "%d,%d,%d,%d,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%.6f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+			run->size, run->qos, run->batch, run->window, run->messages, run->acked, run->bytes, run->seconds,
+			run->messages / s, run->bytes / s, readings / s, (double)run->p50 / NSPERUS, (double)run->p99 / NSPERUS,
+			(double)run->p999 / NSPERUS, (double)run->max / NSPERUS);
+	}
+	fflush(stdout);
+}
+
+/** @brief Starts a private broker with its output discarded
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * port
+ *  @return pid_t broker process, -1 on failure
+ */
+static pid_t SweepStartBroker(const char *port)
+{
+	pid_t pid = fork();
+	int fd;
+
+	if (pid == 0) {
+		fd = open("/dev/null", O_RDWR);
+		if (fd >= 0) {
+			dup2(fd, STDOUT_FILENO);
+			dup2(fd, STDERR_FILENO);
+		}
+		execlp(SWEEPBROKER, SWEEPBROKER, "-p", port, (char *)NULL);
+		_exit(127);
+	}
+	return pid;
+}
+
+/** @brief Prints usage to stderr
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * prog
+ *  @return void
+ */
+static void SweepUsage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-b broker] [-p port] [-n readings] [-s sizes] [-q qoses] [-B batches] [-w windows] [-j]\n"
+		"  lists are comma separated, defaults -s %s -q %s -B %s -w %s\n", prog, SWEEPSIZES, SWEEPQOS, SWEEPBATCHES,
+		SWEEPWINDOWS);
+}
+
+/** @brief Runs every combination of the lists and prints one line per run
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int argc
+ *  @param char ** argv
+ *  @return int 0 on success, 1 on a usage or connection error
+ */
+int main(int argc, char **argv)
+{
+	const char *broker = NULL, *port = SWEEPPORT;
+	const char *sizes = SWEEPSIZES, *qoses = SWEEPQOS, *batches = SWEEPBATCHES, *windows = SWEEPWINDOWS;
+	int size[SWEEPLISTMAX], qos[SWEEPLISTMAX], batch[SWEEPLISTMAX], window[SWEEPLISTMAX];
+	int nsize, nqos, nbatch, nwindow;
+	int readings = SWEEPREADINGS;
+	char uri[128];
+	char *payload;
+	size_t len, maxlen;
+	bool json = false;
+	sweeplat_s lat;
+	sweeprun_s run;
+	MqttPublisher *pub;
+	pid_t pid = -1;
+	int opt, a, b, c, d, waitms, rc = 0;
+
+	while ((opt = getopt(argc, argv, "b:p:n:s:q:B:w:j")) != -1) {
+		switch (opt) {
+		case 'b':
+			broker = optarg;
+			break;
+		case 'p':
+			port = optarg;
+			break;
+		case 'n':
+			readings = atoi(optarg);
+			break;
+		case 's':
+			sizes = optarg;
+			break;
+		case 'q':
+			qoses = optarg;
+			break;
+		case 'B':
+			batches = optarg;
+			break;
+		case 'w':
+			windows = optarg;
+			break;
+		case 'j':
+			json = true;
+			break;
+		default:
+			SweepUsage(argv[0]);
+			return 1;
+		}
+	}
+	nsize = SweepList(sizes, size, SWEEPMINSIZE, SWEEPMAXSIZE);
+	nqos = SweepList(qoses, qos, 0, 2);
+	nbatch = SweepList(batches, batch, 1, SWEEPMAXSIZE);
+	nwindow = SweepList(windows, window, 1, MQTTWINDOWMAX);
+	if (readings <= 0 || nsize == 0 || nqos == 0 || nbatch == 0 || nwindow == 0) {
+		SweepUsage(argv[0]);
+		return 1;
+	}
+	maxlen = (size_t)*std::max_element(size, size + nsize) * *std::max_element(batch, batch + nbatch) +
+		*std::max_element(batch, batch + nbatch) + 2;
+	payload = (char *)malloc(maxlen);
+	lat.cap = readings;
+	lat.ns = (uint64_t *)malloc(lat.cap * sizeof(*lat.ns));
+	if (payload == NULL || lat.ns == NULL) {
+		return 1;
+	}
+	if (broker == NULL) {
+		pid = SweepStartBroker(port);
+		snprintf(uri, sizeof(uri), "tcp://localhost:%s", port);
+		broker = uri;
+	}
+	// Paho takes its in-flight limit at connect, give it the largest window and let SetWindow limit each run
+	pub = new MqttPublisher(broker, SWEEPCLIENTID, MQTTWINDOWMAX);
+	pub->SetAckHook(SweepAck, &lat);
+	for (waitms = 0; pub->State() != DLMQTT_CONNECTED && waitms < SWEEPWAITMS; waitms += 10) {
+		pub->Connect();
+		usleep(10000);
+	}
+	if (pub->State() != DLMQTT_CONNECTED) {
+		fprintf(stderr, "%s: could not connect to %s\n", argv[0], broker);
+		rc = 1;
+	} else if (!json) {
+		fprintf(stdout, "size,qos,batch,window,messages,acked,bytes,seconds,msg_s,bytes_s,readings_s,"
+			"p50_us,p99_us,p999_us,max_us\n");
+	}
+	for (a = 0; rc == 0 && a < nsize; a++) {
+		for (b = 0; rc == 0 && b < nbatch; b++) {
+			len = SweepPayload(payload, size[a], batch[b]);
+			for (c = 0; rc == 0 && c < nqos; c++) {
+				for (d = 0; rc == 0 && d < nwindow; d++) {
+					if (qos[c] == 0 && d > 0) {
+						break;  // the window only limits QoS 1/2
+					}
+					run.size = size[a];
+					run.qos = qos[c];
+					run.batch = batch[b];
+					run.window = qos[c] == 0 ? 0 : window[d];
+					fprintf(stderr, "size %d batch %d qos %d window %d\n", run.size, run.batch, run.qos, run.window);
+					if (!SweepRun(pub, &lat, payload, len, &run, readings)) {
+						fprintf(stderr, "%s: session lost\n", argv[0]);
+						rc = 1;
+						break;
+					}
+					SweepPrint(&run, readings, json);
+				}
+			}
+		}
+	}
+	pub->Disconnect();
+	delete pub;
+	if (pid > 0) {
+		kill(pid, SIGTERM);
+		waitpid(pid, NULL, 0);
+	}
+	free(lat.ns);
+	free(payload);
+	return rc;
+}
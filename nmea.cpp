@@ -8,6 +8,16 @@
 #include <cmath>
 #include "nmea.h"
 
+/** @brief Steps to the next comma separated field
+ *  @param char * p Pointer into the message
+ *  @return char * Start of the next field, NULL if the message ends first
+ */
+static char *nmea_next_field(char *p)
+{
+    p = strchr(p, ',');
+    return p == NULL ? NULL : p + 1;
+}
+
 /** @brief Parses GPGGA Message
  *  @author Paul Moggach
  *  @date 25MAR2019
@@ -18,13 +28,13 @@ void nmea_parse_gpgga(char *nmea, gpgga_t *loc)
 {
     char *p = nmea;
 
-    p = strchr(p, ',')+1; // time
+    if ((p = nmea_next_field(p)) == NULL) { return; } // time
 	loc->utc = atof(p);
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     loc->latitude = atof(p);
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     switch (p[0])
 	{
         case 'N':
@@ -38,10 +48,10 @@ void nmea_parse_gpgga(char *nmea, gpgga_t *loc)
             break;
     }
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     loc->longitude = atof(p);
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     switch (p[0])
 	{
         case 'W':
@@ -55,15 +65,15 @@ void nmea_parse_gpgga(char *nmea, gpgga_t *loc)
             break;
     }
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     loc->quality = (uint8_t)atoi(p);
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     loc->satellites = (uint8_t)atoi(p);
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     loc->altitude = atof(p);
 }
 
@@ -77,11 +87,12 @@ void nmea_parse_gprmc(char *nmea, gprmc_t *loc)
 {
     char *p = nmea;
 
-    p = strchr(p, ',')+1; // skip time
-	p = strchr(p, ',')+1; //skip status
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; } // time
+	loc->utc = atof(p);
+	if ((p = nmea_next_field(p)) == NULL) { return; } //skip status
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     loc->latitude = atof(p);
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     switch (p[0])
 	{
         case 'N':
@@ -95,9 +106,9 @@ void nmea_parse_gprmc(char *nmea, gprmc_t *loc)
             break;
     }
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     loc->longitude = atof(p);
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     switch (p[0])
 	{
         case 'W':
@@ -111,13 +122,13 @@ void nmea_parse_gprmc(char *nmea, gprmc_t *loc)
             break;
     }
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     loc->speed = atof(p);
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     loc->course = atof(p);
 
-    p = strchr(p, ',')+1;
+    if ((p = nmea_next_field(p)) == NULL) { return; }
     loc->date = atof(p);
 }
 
@@ -145,7 +156,9 @@ uint8_t nmea_get_message_type(const char *message)
  */
 uint8_t nmea_valid_checksum(const char *message)
 {
-    uint8_t checksum= (uint8_t)strtol(strchr(message, '*')+1, NULL, 16);
+    const char *star = strchr(message, '*');
+    if (star == NULL || *message != '$') { return NMEA_MESSAGE_ERR; }
+    uint8_t checksum= (uint8_t)strtol(star+1, NULL, 16);
 
     char p;
     uint8_t sum = 0;
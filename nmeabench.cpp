@@ -0,0 +1,235 @@
+/** @file nmeabench.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Compares sentences per second of the strchr/atof NMEA parser
+ *  against the DlNmea stream parser
+ *
+ *  usage: nmeabench [sentences] [chunk]
+ *
+ *  A corpus of alternating GGA and RMC sentences is built in memory. The
+ *  line path splits it into lines the way DlGpsEvent used to and runs
+ *  nmea_get_message_type and nmea_parse_*, the stream path feeds it to
+ *  DlNmeaFeed chunk bytes at a time as serial reads would. Both decode
+ *  the same positions. The stream parser is then fed the corpus with
+ *  every tenth sentence cut short, which the line parser cannot survive.
+ */
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "dlnmea.h"
+#include "dltime.h"
+#include "nmea.h"
+
+#define BENCHSENTENCES 200000
+#define BENCHCHUNK 64
+#define BENCHPASSES 5
+#define BENCHCUTEVERY 10
+#define BENCHCUTAT 20      ///< Bytes kept of a cut sentence
+#define BENCHLINESZ 256
+
+typedef struct benchsum
+{
+	uint64_t n;
+	double lat;   ///< Sum of the decoded latitudes, checks both paths agree
+} benchsum_s;
+
+/** @brief Appends one sentence with its checksum and CR LF
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param char * p where to write
+ *  @param const char * body sentence between '$' and '*'
+ *  @return size_t bytes written
+ */
+static size_t BenchSentence(char *p, const char *body)
+{
+	uint8_t sum = 0;
+	const char *b;
+
+	for (b = body; *b; b++) {
+		sum ^= (uint8_t)*b;
+	}
+	return sprintf(p, "$%s*%02X\r\n", body, sum);
+}
+
+/** @brief Builds the corpus, a fix every 100ms moving north east
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int sentences
+ *  @param size_t * len bytes in the corpus
+ *  @return char * corpus, free with free
+ */
+static char *BenchCorpus(int sentences, size_t *len)
+{
+	char *buf = (char *)malloc((size_t)sentences * NMEAMSGSZ + 1);
+	char body[NMEAMSGSZ];
+	double lat, lon, t;
+	int i, s;
+
+	*len = 0;
+	for (i = 0; buf != NULL && i < sentences; i++) {
+		t = (i / 2) * 0.1;
+		s = (int)t;
+		lat = 4124.8963 + i * 0.00001;
+		lon = 8151.6838 + i * 0.00001;
+		if (i % 2 == 0) {
+			snprintf(body, sizeof(body), "GPGGA,%02d%02d%05.2f,%.4f,N,%.4f,W,1,08,0.9,%.1f,M,-34.0,M,,",
+				(s / 3600) % 24, (s / 60) % 60, fmod(t, 60.0), lat, lon, 280.2 + i % 100);
+		} else {
+			snprintf(body, sizeof(body), "GPRMC,%02d%02d%05.2f,A,%.4f,N,%.4f,W,%.2f,%.1f,171026,003.1,W",
+				(s / 3600) % 24, (s / 60) % 60, fmod(t, 60.0), lat, lon, 22.4 + i % 7, 84.4);
+		}
+		*len += BenchSentence(buf + *len, body);
+	}
+	return buf;
+}
+
+/** @brief ddmm.mmmm to degrees, as DlGpsDegDec does
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param double v
+ *  @return double
+ */
+static double BenchDegrees(double v)
+{
+	double deg = floor(v / 100);
+
+	return deg + (v - deg * 100) / 60;
+}
+
+/** @brief Splits the corpus into lines and parses each with nmea.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * corpus
+ *  @param size_t len
+ *  @param benchsum_s * sum
+ *  @return void
+ */
+static void BenchLines(const char *corpus, size_t len, benchsum_s *sum)
+{
+	char line[BENCHLINESZ];
+	gpgga_t gpgga;
+	gprmc_t gprmc;
+	size_t i;
+	int linelen = 0;
+
+	for (i = 0; i < len; i++) {
+		if (corpus[i] != '\n') {
+			if (linelen < BENCHLINESZ - 1) {
+				line[linelen++] = corpus[i];
+			}
+			continue;
+		}
+		line[linelen] = '\0';
+		linelen = 0;
+		switch (nmea_get_message_type(line)) {
+		case NMEA_GPGGA:
+			nmea_parse_gpgga(line, &gpgga);
+			sum->lat += BenchDegrees(gpgga.latitude);
+			sum->n++;
+			break;
+		case NMEA_GPRMC:
+			nmea_parse_gprmc(line, &gprmc);
+			sum->lat += BenchDegrees(gprmc.latitude);
+			sum->n++;
+			break;
+		}
+	}
+}
+
+/** @brief Stream parser callback
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context benchsum_s
+ *  @param const dlnmeafix_s * fix
+ *  @return void
+ */
+static void BenchFix(void *context, const dlnmeafix_s *fix)
+{
+	benchsum_s *sum = (benchsum_s *)context;
+
+	if (fix->present & NMEA_HASPOS) {
+		sum->lat += (double)fix->lat / NMEAPOS_SCALE;
+	}
+	sum->n++;
+}
+
+/** @brief Feeds the corpus to the stream parser chunk bytes at a time
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param dlnmea_s * p
+ *  @param const char * corpus
+ *  @param size_t len
+ *  @param size_t chunk
+ *  @param benchsum_s * sum
+ *  @return void
+ */
+static void BenchStream(dlnmea_s *p, const char *corpus, size_t len, size_t chunk, benchsum_s *sum)
+{
+	size_t i;
+
+	for (i = 0; i < len; i += chunk) {
+		DlNmeaFeed(p, corpus + i, len - i < chunk ? len - i : chunk, BenchFix, sum);
+	}
+}
+
+/** @brief Runs both parsers over the corpus and prints sentences per second
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int argc
+ *  @param char ** argv optional sentence count and chunk size
+ *  @return int program status
+ */
+int main(int argc, char **argv)
+{
+	int sentences = argc > 1 ? atoi(argv[1]) : BENCHSENTENCES;
+	size_t chunk = argc > 2 ? (size_t)atoi(argv[2]) : BENCHCHUNK;
+	benchsum_s lines = { 0, 0.0 }, stream = { 0, 0.0 }, cut = { 0, 0.0 };
+	double tlines, tstream;
+	uint64_t start;
+	size_t len, i, at, pos;
+	char *corpus;
+	dlnmea_s p;
+	int pass;
+
+	corpus = BenchCorpus(sentences, &len);
+	if (corpus == NULL || chunk == 0) {
+		fprintf(stderr, "nmeabench: no corpus\n");
+		return 1;
+	}
+	start = DlTimeNow();
+	for (pass = 0; pass < BENCHPASSES; pass++) {
+		BenchLines(corpus, len, &lines);
+	}
+	tlines = (double)(DlTimeNow() - start) / NSPERSEC;
+	DlNmeaInit(&p);
+	start = DlTimeNow();
+	for (pass = 0; pass < BENCHPASSES; pass++) {
+		BenchStream(&p, corpus, len, chunk, &stream);
+	}
+	tstream = (double)(DlTimeNow() - start) / NSPERSEC;
+	fprintf(stdout, "sentences %d bytes %zu chunk %zu\n", sentences, len, chunk);
+	fprintf(stdout, "strchr/atof %.0f sentences/s %.1f MB/s\n", lines.n / tlines, BENCHPASSES * len / tlines / 1e6);
+	fprintf(stdout, "dlnmea %.0f sentences/s %.1f MB/s\n", stream.n / tstream, BENCHPASSES * len / tstream / 1e6);
+	fprintf(stdout, "speedup %.1fx mean latitude %.7f %.7f\n", tlines / tstream,
+		lines.n ? lines.lat / lines.n : 0.0, stream.n ? stream.lat / stream.n : 0.0);
+
+	// keep only the first BENCHCUTAT bytes and the line end of every BENCHCUTEVERY sentence
+	for (i = 0, at = 0, pos = 0, sentences = 0; i < len; i++, pos++) {
+		if (corpus[i] == '$') {
+			sentences++;
+			pos = 0;
+		}
+		if (sentences % BENCHCUTEVERY == 0 && pos >= BENCHCUTAT && corpus[i] != '\n') {
+			continue;
+		}
+		corpus[at++] = corpus[i];
+	}
+	DlNmeaInit(&p);
+	BenchStream(&p, corpus, at, chunk, &cut);
+	fprintf(stdout, "truncated: decoded %" PRIu64 " malformed %" PRIu64 " bad checksum %" PRIu64 "\n",
+		p.sentences, p.malformed, p.badsum);
+	free(corpus);
+	return 0;
+}
@@ -182,6 +182,10 @@ SenseHat::SenseHat(void)
   buffer=" ";
   color=BLUE;
   rotation = 0;
+  imurunning = false;
+  imuring = NULL;
+  imuseq = 0;
+  memset(&imulatest, 0, sizeof(imulatest));
 }
 
 /**
@@ -190,6 +194,7 @@ SenseHat::SenseHat(void)
  */
 SenseHat::~SenseHat(void)
 {
+    StopImuThread();
 #if SENSEHAT_EMULATOR
 	Py_Finalize();
 #else
@@ -395,6 +400,16 @@ char SenseHat::ScanJoystick(void)
 	return handle_events(joystick);
 }
 
+/**
+ * @brief SenseHat::GetJoystickFd
+ * @return the joystick evdev descriptor, to wait for key events with
+ * poll/epoll before calling ScanJoystick
+ */
+int SenseHat::GetJoystickFd(void)
+{
+	return joystick;
+}
+
 /**
  * @brief SenseHat::ConvertRGB565
  * @param red uint8_t component
@@ -632,6 +647,15 @@ void SenseHat::GetOrientation(float &pitch, float &roll, float &yaw)
 	fscanf(fp, "%f %f %f", &pitch,&roll,&yaw);
 	fclose(fp);
 #else
+    imusample_t sample;
+
+    if (GetImuSnapshot(sample))
+    {
+        pitch = sample.gx;
+        roll  = sample.gy;
+        yaw   = sample.gz;
+        return;
+    }
     while (imu->IMURead())
     {
         RTIMU_DATA imuData = imu->getIMUData();
@@ -666,6 +690,15 @@ void SenseHat::GetAcceleration(float &x, float &y, float &z)
 	fscanf(fp, "%f %f %f", &z,&y,&z);
 	fclose(fp);
 #else
+    imusample_t sample;
+
+    if (GetImuSnapshot(sample))
+    {
+        x = sample.ax;
+        y = sample.ay;
+        z = sample.az;
+        return;
+    }
     while (imu->IMURead())
     {
         RTIMU_DATA imuData = imu->getIMUData();
@@ -701,6 +734,15 @@ void SenseHat::GetMagnetism(float &x, float &y, float &z)
 	fscanf(fp, "%f %f %f", &z,&y,&z);
 	fclose(fp);
 #else
+    imusample_t sample;
+
+    if (GetImuSnapshot(sample))
+    {
+        x = sample.mx;
+        y = sample.my;
+        z = sample.mz;
+        return;
+    }
     while (imu->IMURead())
     {
         RTIMU_DATA imuData = imu->getIMUData();
@@ -728,6 +770,145 @@ void SenseHat::GetSphericalMagnetism(float &ro, float &teta, float &delta)
 #endif
 }
 
+/**
+ * @brief SenseHat::StartImuThread
+ * @param capacity number of samples kept for GetImuSamples
+ * @return true if the thread runs
+ * @details starts a thread that reads the IMU at its own poll interval and
+ * keeps every sample. Once it runs, GetOrientation, GetAcceleration and
+ * GetMagnetism return the latest sample instead of reading the IMU.
+ */
+bool SenseHat::StartImuThread(size_t capacity)
+{
+#if SENSEHAT_EMULATOR
+    return false;
+#else
+    if (imurunning) { return true; }
+    imuring = new DlRing<imusample_t>(capacity, DLBP_DROPOLDEST);
+    imurunning = true;
+    if (pthread_create(&imuthread, NULL, ImuThread, this) != 0)
+    {
+        imurunning = false;
+        delete imuring;
+        imuring = NULL;
+        return false;
+    }
+    return true;
+#endif
+}
+
+/**
+ * @brief SenseHat::StopImuThread
+ * @details stops and joins the IMU thread
+ */
+void SenseHat::StopImuThread(void)
+{
+    if (!imurunning) { return; }
+    imurunning = false;
+    pthread_join(imuthread, NULL);
+    delete imuring;
+    imuring = NULL;
+}
+
+/**
+ * @brief SenseHat::GetImuSnapshot
+ * @param sample receives the latest accel/gyro/compass sample, all three from the same read
+ * @return false if the IMU thread is not running or has no sample yet
+ * @details never blocks, retries only if the IMU thread was writing at the same moment
+ */
+bool SenseHat::GetImuSnapshot(imusample_t &sample)
+{
+    uint32_t seq;
+
+    if (!imurunning) { return false; }
+    do
+    {
+        seq = imuseq.load(std::memory_order_acquire);
+        if (seq & 1) { continue; }
+        sample = imulatest;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    while ((seq & 1) || seq != imuseq.load(std::memory_order_relaxed));
+    return seq != 0;
+}
+
+/**
+ * @brief SenseHat::GetImuSamples
+ * @param samples array receiving the oldest queued samples
+ * @param max size of samples
+ * @return number of samples copied, without waiting
+ * @details every sample read by the IMU thread is returned exactly once unless
+ * more than the ring capacity piled up, see GetImuDropped. Call from one thread only.
+ */
+size_t SenseHat::GetImuSamples(imusample_t *samples, size_t max)
+{
+    size_t n = 0;
+
+    if (imuring == NULL) { return 0; }
+    while (n < max && imuring->Pop(samples[n])) { n++; }
+    return n;
+}
+
+/**
+ * @brief SenseHat::GetImuDropped
+ * @return number of samples overwritten before GetImuSamples collected them
+ */
+uint64_t SenseHat::GetImuDropped(void)
+{
+    return imuring ? imuring->Dropped() : 0;
+}
+
+/**
+ * @brief SenseHat::ImuThread
+ * @param arg SenseHat
+ * @details reads every new IMU sample at IMUGetPollInterval on absolute deadlines
+ */
+void *SenseHat::ImuThread(void *arg)
+{
+#if SENSEHAT_EMULATOR
+    return NULL;
+#else
+    SenseHat *sh = (SenseHat *)arg;
+    struct timespec next, now;
+    long interval = sh->imu->IMUGetPollInterval() * 1000000L;
+    imusample_t sample;
+
+    if (interval <= 0) { interval = 1000000L; }
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (sh->imurunning)
+    {
+        while (sh->imu->IMURead())
+        {
+            RTIMU_DATA imuData = sh->imu->getIMUData();
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            sample.tns = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+            sample.ax = imuData.accel.x();
+            sample.ay = imuData.accel.y();
+            sample.az = imuData.accel.z();
+            sample.gx = imuData.gyro.x();
+            sample.gy = imuData.gyro.y();
+            sample.gz = imuData.gyro.z();
+            sample.mx = imuData.compass.x();
+            sample.my = imuData.compass.y();
+            sample.mz = imuData.compass.z();
+            sh->imuring->Push(sample);
+            sh->imuseq.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            sh->imulatest = sample;
+            sh->imuseq.fetch_add(1, std::memory_order_release);
+        }
+        next.tv_nsec += interval;
+        while (next.tv_nsec >= 1000000000L)
+        {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    return NULL;
+#endif
+}
+
 #if SENSEHAT_EMULATOR
 #else
 /**
@@ -31,6 +31,9 @@
 #include <RTIMULib.h>
 #include <iostream>
 #include <iomanip>
+#include <atomic>
+#include <pthread.h>
+#include "dlring.h"
 
 // Constants
 #define SENSEHAT_EMULATOR 0
@@ -42,6 +45,7 @@
 #define DEV_INPUT_EVENT "/dev/input"
 #define EVENT_DEV_NAME "event"
 #define IMUDELAY 200000
+#define IMURINGSZ 1024
 
 #define COLOR_SENSEHAT uint16_t
 #define PI 3.14159265
@@ -62,6 +66,14 @@ struct fb_t
 	uint16_t pixel[8][8];
 };
 
+struct imusample_t
+{
+	uint64_t tns;        // CLOCK_MONOTONIC time of the read, ns
+	float ax, ay, az;    // acceleration, g
+	float gx, gy, gz;    // angular rate, rad/s
+	float mx, my, mz;    // magnetic field, uT
+};
+
 
 // Classes
 class SenseHat
@@ -87,6 +99,7 @@ public:
 	void RotatePattern(int rotation);
     char ScannerJoystick(void);
     char ScanJoystick(void);
+    int GetJoystickFd(void);
     COLOR_SENSEHAT ConvertRGB565(uint8_t red, uint8_t green,uint8_t blue);
 	COLOR_SENSEHAT ConvertRGB565(uint8_t color[]);
 	COLOR_SENSEHAT ConvertRGB565(std::string color);
@@ -101,6 +114,11 @@ public:
 	void  GetAcceleration(float &x, float &y, float &z);
 	void  GetMagnetism(float &x, float &y, float &z);
 	void  GetSphericalMagnetism(float &ro, float &teta, float &delta);
+	bool  StartImuThread(size_t capacity = IMURINGSZ);
+	void  StopImuThread(void);
+	bool  GetImuSnapshot(imusample_t &sample);
+	size_t GetImuSamples(imusample_t *samples, size_t max);
+	uint64_t GetImuDropped(void);
     void  Version(void);
     void  Flush(void);
 	void  SetColor(uint16_t);
@@ -119,6 +137,7 @@ private:
 	void ConvertCharacterToPattern(char c, uint16_t image[8][8], uint16_t colorText, uint16_t colorBackground);
 	bool EmptyColumn(int numcolumn, uint16_t image[8][8], uint16_t colorBackground);
 	void ImageContainment(int numcolumn, uint16_t image[][8][8], int taille);
+	static void *ImuThread(void *arg);
 
     struct fb_t *fb;
     int joystick;
@@ -129,6 +148,11 @@ private:
     RTPressure *pressure;
     RTHumidity *humidity;
 #endif
+    pthread_t imuthread;
+    std::atomic<bool> imurunning;
+    DlRing<imusample_t> *imuring;
+    std::atomic<uint32_t> imuseq;   // odd while imulatest is being written
+    imusample_t imulatest;
     std::string buffer;
     uint16_t color;
     int rotation;
@@ -1,16 +1,38 @@
 /** @file serial.cpp
  *  @brief serial Functions
 */
+#include <atomic>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cinttypes>
 #include <cstring>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include "serial.h"
 
 int uart0_filestream = -1;
+static uint32_t portbaud = 0;
+
+// Receive ring and transmit queue, indexes run freely and are masked on use
+static char rxbuf[SERIALRXSZ];
+static size_t rxhead = 0, rxtail = 0;
+static char txbuf[SERIALTXSZ];
+static size_t txhead = 0, txtail = 0;
+
+static std::atomic<uint64_t> rxbytes(0);
+static std::atomic<uint64_t> reads(0);
+static std::atomic<uint64_t> lines(0);
+static std::atomic<uint64_t> overlong(0);  // lines cut short or discarded
+static std::atomic<uint64_t> rxfull(0);    // fills with no room, the reader fell behind
+static std::atomic<uint64_t> txbytes(0);
+static std::atomic<uint64_t> writes(0);
+static std::atomic<uint64_t> txdropped(0); // writes refused, queue full or port closed
 
 /** @brief Serial port setup
  *  @author Paul Moggach
@@ -26,75 +48,371 @@ void serial_init(void)
     }
 }
 
-/** @brief Serial port configuration
+/** @brief termios speed for a baud rate
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint32_t baud
+ *  @return speed_t B0 if the rate is not supported
+ */
+static speed_t serial_speed(uint32_t baud)
+{
+	switch (baud)
+	{
+	case 4800: return B4800;
+	case 9600: return B9600;
+	case 19200: return B19200;
+	case 38400: return B38400;
+	case 57600: return B57600;
+	case 115200: return B115200;
+	case 230400: return B230400;
+	case 460800: return B460800;
+	case 921600: return B921600;
+	}
+	return B0;
+}
+
+/** @brief Serial port configuration, raw bytes, no flow control, reads
+ *  never wait
  *  @author Paul Moggach
  *  @date 01JAN2019
+ *  @param const serialcfg_s * cfg NULL for SERIALBAUD 8N1
+ *  @return int 0, -1 if the settings are not supported or were refused
  */
-void serial_config(void)
+int serial_config(const serialcfg_s *cfg)
 {
     struct termios options;
-    tcgetattr(uart0_filestream, &options);
-    options.c_cflag = B9600 | CS8 | CLOCAL | CREAD;
+    struct serial_struct ss;
+    uint32_t baud = cfg ? cfg->baud : SERIALBAUD;
+    speed_t speed = serial_speed(baud);
+
+    if (uart0_filestream == -1 || speed == B0 || tcgetattr(uart0_filestream, &options) != 0)
+    {
+        return -1;
+    }
+    cfmakeraw(&options);
+    options.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS);
+    options.c_cflag |= (cfg && cfg->databits == 7 ? CS7 : CS8) | CLOCAL | CREAD;
+    if (cfg && cfg->parity != 'N' && cfg->parity != 0)
+    {
+        options.c_cflag |= cfg->parity == 'O' ? PARENB | PARODD : PARENB;
+    }
+    if (cfg && cfg->stopbits == 2)
+    {
+        options.c_cflag |= CSTOPB;
+    }
     options.c_iflag = IGNPAR;
-    options.c_oflag = 0;
-    options.c_lflag = 0;
+    options.c_cc[VMIN] = 0;
+    options.c_cc[VTIME] = 0;
+    cfsetispeed(&options, speed);
+    cfsetospeed(&options, speed);
     tcflush(uart0_filestream, TCIFLUSH);
-    tcsetattr(uart0_filestream, TCSANOW, &options);
+    if (tcsetattr(uart0_filestream, TCSANOW, &options) != 0)
+    {
+        return -1;
+    }
+    // best effort, only some drivers have a low latency mode
+    if (cfg && ioctl(uart0_filestream, TIOCGSERIAL, &ss) == 0)
+    {
+        ss.flags = cfg->lowlatency ? ss.flags | ASYNC_LOW_LATENCY : ss.flags & ~ASYNC_LOW_LATENCY;
+        ioctl(uart0_filestream, TIOCSSERIAL, &ss);
+    }
+    portbaud = baud;
+    return 0;
+}
+
+/** @brief Baud rate set by the last serial_config
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @return uint32_t 0 if the port has not been configured
+ */
+uint32_t serial_baud(void)
+{
+	return portbaud;
 }
 
-/** @brief Writes a line to the serial port
+/** @brief Copies bytes into the transmit queue, the caller has checked for room
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * data
+ *  @param size_t len
+ */
+static void serial_queue(const char *data, size_t len)
+{
+	size_t at = txhead & (SERIALTXSZ - 1);
+	size_t first = len < SERIALTXSZ - at ? len : SERIALTXSZ - at;
+
+	memcpy(txbuf + at, data, first);
+	memcpy(txbuf, data + first, len - first);
+	txhead += len;
+}
+
+/** @brief Queues bytes for the port and sends what the port will take now
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const void * data
+ *  @param size_t len
+ *  @return int 0, -1 if the port is closed or the queue has no room, nothing
+ *  is queued then
+ */
+int serial_write(const void *data, size_t len)
+{
+	if (uart0_filestream == -1 || len > SERIALTXSZ - (txhead - txtail))
+	{
+		txdropped++;
+		return -1;
+	}
+	serial_queue((const char *)data, len);
+	serial_flush();
+	return 0;
+}
+
+/** @brief Queues a line for the serial port, CR LF is added
  *  @author Paul Moggach
  *  @date 01JAN2019
  *  @param line char * to buffer
- *  @param len number of characters to write
+ *  @param len number of characters to write, without a line end
+ *  @return int 0, -1 if the port is closed or the queue has no room
+ */
+int serial_println(const char *line, int len)
+{
+	if (uart0_filestream == -1 || len < 0 || (size_t)len + 2 > SERIALTXSZ - (txhead - txtail))
+	{
+		txdropped++;
+		return -1;
+	}
+	serial_queue(line, len);
+	serial_queue("\r\n", 2);
+	serial_flush();
+	return 0;
+}
+
+/** @brief Writes as much of the transmit queue as the port takes without waiting
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @return int bytes still queued, -1 on a write error
  */
-void serial_println(const char *line, int len)
+int serial_flush(void)
 {
-    if (uart0_filestream != -1)
+	struct iovec iov[2];
+	size_t at, queued;
+	ssize_t n;
+
+	while ((queued = txhead - txtail) > 0)
 	{
-        char *cpstr = (char *)malloc((len+1) * sizeof(char));
-        strcpy(cpstr, line);
-        cpstr[len-1] = '\r';
-        cpstr[len] = '\n';
+		at = txtail & (SERIALTXSZ - 1);
+		iov[0].iov_base = txbuf + at;
+		iov[0].iov_len = queued < SERIALTXSZ - at ? queued : SERIALTXSZ - at;
+		iov[1].iov_base = txbuf;
+		iov[1].iov_len = queued - iov[0].iov_len;
+		n = writev(uart0_filestream, iov, iov[1].iov_len ? 2 : 1);
+		if (n < 0)
+		{
+			if (errno == EAGAIN || errno == EINTR)
+			{
+				break;
+			}
+			return -1;
+		}
+		txtail += n;
+		txbytes += n;
+		writes++;
+		if ((size_t)n < queued)
+		{
+			break;
+		}
+	}
+	return (int)(txhead - txtail);
+}
+
+/** @brief Waits for the transmit queue and the driver to send everything,
+ *  before changing the baud rate
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int timeoutms longest wait for the queue to empty
+ *  @return int 0, -1 if the queue did not empty or the port failed
+ */
+int serial_drain(int timeoutms)
+{
+	struct pollfd pfd = { uart0_filestream, POLLOUT, 0 };
+	int queued;
 
-        int count = write(uart0_filestream, cpstr, len+1);
-        if (count < 0)
+	while ((queued = serial_flush()) > 0)
+	{
+		if (timeoutms <= 0 || poll(&pfd, 1, SERIALDRAINMS) < 0)
 		{
-            //TODO: handle errors...
-        }
-        free(cpstr);
-    }
+			return -1;
+		}
+		timeoutms -= SERIALDRAINMS;
+	}
+	if (queued < 0)
+	{
+		return -1;
+	}
+	return tcdrain(uart0_filestream) == 0 ? 0 : -1;
 }
 
-/** @brief Reads a line from the serial port.
+/** @brief Bytes waiting in the transmit queue, watch for POLLOUT while non zero
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @return size_t
+ */
+size_t serial_txqueued(void)
+{
+	return txhead - txtail;
+}
+
+/** @brief Moves everything the driver has buffered into the receive ring,
+ *  one readv however the ring has wrapped
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @return int bytes added, 0 if nothing was waiting or the ring is full,
+ *  -1 on a read error or hangup
+ */
+int serial_fill(void)
+{
+	struct iovec iov[2];
+	size_t at, room = SERIALRXSZ - (rxhead - rxtail);
+	ssize_t n;
+
+	if (room == 0)
+	{
+		rxfull++;
+		return 0;
+	}
+	at = rxhead & (SERIALRXSZ - 1);
+	iov[0].iov_base = rxbuf + at;
+	iov[0].iov_len = room < SERIALRXSZ - at ? room : SERIALRXSZ - at;
+	iov[1].iov_base = rxbuf;
+	iov[1].iov_len = room - iov[0].iov_len;
+	n = readv(uart0_filestream, iov, iov[1].iov_len ? 2 : 1);
+	if (n < 0 && (errno == EAGAIN || errno == EINTR))
+	{
+		return 0;
+	}
+	if (n <= 0)
+	{
+		return -1;
+	}
+	rxhead += n;
+	rxbytes += n;
+	reads++;
+	return (int)n;
+}
+
+/** @brief Oldest received bytes, in place, up to where the ring wraps
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char ** data set to the first byte
+ *  @return size_t bytes at data, call again after serial_consume for the rest
+ */
+size_t serial_peek(const char **data)
+{
+	size_t at = rxtail & (SERIALRXSZ - 1);
+	size_t used = rxhead - rxtail;
+
+	*data = rxbuf + at;
+	return used < SERIALRXSZ - at ? used : SERIALRXSZ - at;
+}
+
+/** @brief Drops bytes from the front of the receive ring
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param size_t len at most what serial_peek returned
+ */
+void serial_consume(size_t len)
+{
+	size_t used = rxhead - rxtail;
+
+	rxtail += len < used ? len : used;
+}
+
+/** @brief Takes one line from the receive ring without waiting, the line
+ *  end and any CR are removed. A line longer than the buffer is cut short,
+ *  a line longer than the ring is discarded.
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param char * buffer
+ *  @param int len size of buffer
+ *  @return int characters in buffer, -1 if no whole line has arrived
+ */
+int serial_takeln(char *buffer, int len)
+{
+	size_t at = rxtail & (SERIALRXSZ - 1);
+	size_t used = rxhead - rxtail;
+	size_t first = used < SERIALRXSZ - at ? used : SERIALRXSZ - at;
+	const char *nl;
+	size_t n, copy;
+
+	if (len <= 0)
+	{
+		return -1;
+	}
+	nl = (const char *)memchr(rxbuf + at, '\n', first);
+	if (nl != NULL)
+	{
+		n = nl - (rxbuf + at);
+	}
+	else if ((nl = (const char *)memchr(rxbuf, '\n', used - first)) != NULL)
+	{
+		n = first + (nl - rxbuf);
+	}
+	else
+	{
+		if (used == SERIALRXSZ)
+		{
+			overlong++;
+			rxtail = rxhead;
+		}
+		return -1;
+	}
+	copy = n < (size_t)len - 1 ? n : (size_t)len - 1;
+	if (copy < n)
+	{
+		overlong++;
+	}
+	if (copy > first)
+	{
+		memcpy(buffer, rxbuf + at, first);
+		memcpy(buffer + first, rxbuf, copy - first);
+	}
+	else
+	{
+		memcpy(buffer, rxbuf + at, copy);
+	}
+	if (copy > 0 && buffer[copy - 1] == '\r')
+	{
+		copy--;
+	}
+	buffer[copy] = '\0';
+	rxtail += n + 1;
+	lines++;
+	return (int)copy;
+}
+
+/** @brief Reads a line from the serial port, waiting for it to arrive
  *  @author Paul Moggach
  *  @date 01JAN2019
  *  @param buffer char *
- *  @param len int number of characters to read
+ *  @param len int size of buffer, longer lines are cut short
+ *  @return int characters in buffer, -1 if the port failed first
  */
-void serial_readln(char *buffer, int len)
+int serial_readln(char *buffer, int len)
 {
-    char c;
-    char *b = buffer;
-    int rx_length = -1;
-    while(1)
-	{
-        rx_length = read(uart0_filestream, (void*)(&c), 1);
+	struct pollfd pfd = { uart0_filestream, POLLIN, 0 };
+	int n;
 
-        if (rx_length <= 0)
+	while ((n = serial_takeln(buffer, len)) < 0)
+	{
+		if (len <= 0 || (poll(&pfd, 1, -1) < 0 && errno != EINTR))
 		{
-            //wait for messages
-            sleep(1);
-        } else
+			return -1;
+		}
+		if (serial_fill() < 0)
 		{
-            if (c == '\n')
-			{
-                *b++ = '\0';
-                break;
-            }
-            *b++ = c;
-        }
-    }
+			return -1;
+		}
+	}
+	return n;
 }
 
 /** @brief Closes serial port
@@ -104,4 +422,35 @@ void serial_readln(char *buffer, int len)
 void serial_close(void)
 {
     close(uart0_filestream);
+    uart0_filestream = -1;
+    portbaud = 0;
+    rxhead = rxtail = 0;
+    txhead = txtail = 0;
+}
+
+/** @brief Gets the serial port descriptor, for poll/epoll
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @return int descriptor, -1 if the port is not open
+ */
+int serial_fd(void)
+{
+    return uart0_filestream;
+}
+
+/** @brief Prints the bytes moved per read and write call and what was lost
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param FILE * fp
+ */
+void serial_report(FILE *fp)
+{
+	uint64_t r = reads.load(), w = writes.load();
+
+	fprintf(fp, "serial: %" PRIu32 " baud\n", portbaud);
+	fprintf(fp, "serial: rx %" PRIu64 " bytes in %" PRIu64 " reads (%.1f per read) lines %" PRIu64 " overlong %" PRIu64
+		" ring full %" PRIu64 "\n", rxbytes.load(), r, r ? (double)rxbytes.load() / r : 0.0, lines.load(),
+		overlong.load(), rxfull.load());
+	fprintf(fp, "serial: tx %" PRIu64 " bytes in %" PRIu64 " writes queued %zu dropped %" PRIu64 "\n", txbytes.load(),
+		w, serial_txqueued(), txdropped.load());
 }
@@ -2,19 +2,52 @@
 #define SERIAL_H
 /** @file serial.h
  *  @brief Constants, structures, function prototypes for serial functions
+ *
+ *  The port is non-blocking. serial_fill drains whatever the driver holds
+ *  into a receive ring with one read, lines and frames are taken from the
+ *  ring in place with serial_peek and serial_consume, or copied out by
+ *  serial_readln. Writes go into a fixed transmit queue and out as the
+ *  port takes them, nothing is allocated per line. One thread uses the
+ *  port at a time.
 */
 #include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
 
 #ifndef PORTNAME
 #define PORTNAME "/dev/ttyS0"
 #endif
+#define SERIALRXSZ 4096   ///< Receive ring, a power of two, about 0.4s at 115200 baud
+#define SERIALTXSZ 1024   ///< Transmit queue, a power of two
+#define SERIALDRAINMS 10  ///< serial_drain checks the queue this often
+#define SERIALBAUD 9600   ///< Most receivers power up at 9600 8N1
+
+typedef struct serialcfg
+{
+	uint32_t baud;      ///< 4800 to 921600
+	uint8_t databits;   ///< 7 or 8
+	char parity;        ///< 'N', 'E' or 'O'
+	uint8_t stopbits;   ///< 1 or 2
+	bool lowlatency;    ///< Ask the driver to pass bytes up at once, USB adapters batch for 16ms otherwise
+} serialcfg_s;
 
 ///\cond INTERNAL
 // Function Prototypes
 void serial_init(void);
-void serial_config(void);
-void serial_println(const char *, int);
-void serial_readln(char *, int);
+int serial_config(const serialcfg_s *);
+uint32_t serial_baud(void);
+int serial_write(const void *, size_t);
+int serial_println(const char *, int);
+int serial_flush(void);
+int serial_drain(int);
+size_t serial_txqueued(void);
+int serial_fill(void);
+size_t serial_peek(const char **);
+void serial_consume(size_t);
+int serial_takeln(char *, int);
+int serial_readln(char *, int);
 void serial_close(void);
+int serial_fd(void);
+void serial_report(FILE *);
 ///\endcond
 #endif
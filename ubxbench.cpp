@@ -0,0 +1,489 @@
+/** @file ubxbench.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Compares fixes per second decoded from u-blox NAV-PVT frames
+ *  against the same fixes sent as NMEA GGA and RMC, and replays recorded
+ *  receiver streams through the UBX decoder
+ *
+ *  usage: ubxbench [-n epochs] [-c chunk] [-w corpus] [-r replay] [-t replay]
+ *
+ *  Without -r, epochs fixes are built in memory both as NAV-PVT frames and
+ *  as GGA and RMC text and each stream is fed to its decoder chunk bytes
+ *  at a time, as serial reads would. -w also writes a replay corpus of
+ *  UBXREPLAYEPOCHS fixes with what a real port carries mixed in: ACKs,
+ *  other NAV messages, NMEA text, a corrupted checksum every
+ *  UBXREPLAYBADEVERY fixes and a frame cut short every
+ *  UBXREPLAYCUTEVERY. -r decodes a recorded or written corpus and prints
+ *  what it found; ubxreplay.ubx in the tree was written with -w and
+ *  decodes to 290 of its 300 fixes: 6 fail their checksum and 4 are cut.
+ *  The decoder rescans a failed frame, so the fix after a cut is still
+ *  found. -t decodes a corpus written with -w at every chunk size from 1
+ *  to chunk and fails unless exactly the damaged fixes are missing.
+ */
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "dlnmea.h"
+#include "dltime.h"
+#include "dlubx.h"
+
+#define BENCHEPOCHS 200000
+#define BENCHCHUNK 64
+#define BENCHPASSES 5
+#define BENCHLAT 481173000       ///< 1e-7 degrees, start of the drive
+#define BENCHLON 115166667
+#define UBXREPLAYEPOCHS 300      ///< 30s at 10Hz
+#define UBXREPLAYBADEVERY 50
+#define UBXREPLAYCUTEVERY 75
+#define UBXREPLAYCUTSZ (UBXHDRSZ + 30)  ///< Bytes of a cut frame that arrive
+#define UBXNAVSAT 0x35
+#define UBXREPLAYFILE "ubxreplay.ubx"
+
+typedef struct benchsum
+{
+	uint64_t n;
+	double lat;   ///< Sum of the decoded latitudes, checks both paths agree
+} benchsum_s;
+
+/** @brief Puts a little endian value into a payload
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint8_t * p
+ *  @param uint32_t v
+ *  @param int bytes 1, 2 or 4
+ *  @return void
+ */
+static void BenchPut(uint8_t *p, uint32_t v, int bytes)
+{
+	int i;
+
+	for (i = 0; i < bytes; i++) {
+		p[i] = (uint8_t)(v >> (8 * i));
+	}
+}
+
+/** @brief NAV-PVT payload of fix i, 10 fixes a second heading north east
+ *  at 50 kph from 12:00:00 17 Oct 2026
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int i
+ *  @param uint8_t * p UBXNAVPVTSZ bytes
+ *  @return void
+ */
+static void BenchPvt(int i, uint8_t *p)
+{
+	uint32_t ms = 12 * 3600000 + (uint32_t)i * 100 % (12 * 3600000);
+
+	memset(p, 0, UBXNAVPVTSZ);
+	BenchPut(p, 5 * 86400000 + ms + 18000, 4);
+	BenchPut(p + 4, 2026, 2);
+	p[6] = 10;
+	p[7] = 17;
+	p[8] = (uint8_t)(ms / 3600000);
+	p[9] = (uint8_t)(ms / 60000 % 60);
+	p[10] = (uint8_t)(ms / 1000 % 60);
+	p[11] = UBXPVT_VALIDDATE | UBXPVT_VALIDTIME | UBXPVT_RESOLVED;
+	BenchPut(p + 12, 20, 4);
+	BenchPut(p + 16, ms % 1000 * 1000000, 4);
+	p[20] = 3;
+	p[21] = UBXPVT_GNSSFIXOK;
+	p[23] = 12;
+	BenchPut(p + 24, BENCHLON + i * 10, 4);
+	BenchPut(p + 28, BENCHLAT + i * 10, 4);
+	BenchPut(p + 32, 592300, 4);
+	BenchPut(p + 36, 545400, 4);
+	BenchPut(p + 40, 1500, 4);
+	BenchPut(p + 44, 2500, 4);
+	BenchPut(p + 60, 13889, 4);
+	BenchPut(p + 64, 4500000, 4);
+	BenchPut(p + 68, 300, 4);
+	BenchPut(p + 72, 150000, 4);
+	BenchPut(p + 76, 120, 2);
+}
+
+/** @brief Appends one NMEA sentence with its checksum and CR LF
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param char * p where to write
+ *  @param const char * body sentence between '$' and '*'
+ *  @return size_t bytes written
+ */
+static size_t BenchSentence(char *p, const char *body)
+{
+	uint8_t sum = 0;
+	const char *b;
+
+	for (b = body; *b; b++) {
+		sum ^= (uint8_t)*b;
+	}
+	return sprintf(p, "$%s*%02X\r\n", body, sum);
+}
+
+/** @brief GGA and RMC carrying the same fix as BenchPvt(i)
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int i
+ *  @param char * p where to write, 2 * NMEAMSGSZ
+ *  @return size_t bytes written
+ */
+static size_t BenchNmea(int i, char *p)
+{
+	uint32_t ms = 12 * 3600000 + (uint32_t)i * 100 % (12 * 3600000);
+	int64_t lat = BENCHLAT + i * 10, lon = BENCHLON + i * 10;
+	char body[2 * NMEAMSGSZ], hms[16], pos[48];
+	size_t n;
+
+	snprintf(hms, sizeof(hms), "%02u%02u%02u.%02u", ms / 3600000, ms / 60000 % 60, ms / 1000 % 60, ms % 1000 / 10);
+	snprintf(pos, sizeof(pos), "%02d%09.6f,N,%03d%09.6f,E", (int)(lat / NMEAPOS_SCALE),
+		(double)(lat % NMEAPOS_SCALE) * 60 / NMEAPOS_SCALE, (int)(lon / NMEAPOS_SCALE),
+		(double)(lon % NMEAPOS_SCALE) * 60 / NMEAPOS_SCALE);
+	snprintf(body, sizeof(body), "GPGGA,%s,%s,1,12,1.2,545.4,M,46.9,M,,", hms, pos);
+	n = BenchSentence(p, body);
+	snprintf(body, sizeof(body), "GPRMC,%s,A,%s,27.000,45.00,171026,,,A", hms, pos);
+	return n + BenchSentence(p + n, body);
+}
+
+/** @brief UBX decoder callback
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context benchsum_s
+ *  @param const dlubxpvt_s * pvt
+ *  @return void
+ */
+static void BenchPvtFix(void *context, const dlubxpvt_s *pvt)
+{
+	benchsum_s *sum = (benchsum_s *)context;
+
+	sum->lat += (double)pvt->lat / NMEAPOS_SCALE;
+	sum->n++;
+}
+
+/** @brief NMEA parser callback, a fix is counted on its RMC
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context benchsum_s
+ *  @param const dlnmeafix_s * fix
+ *  @return void
+ */
+static void BenchNmeaFix(void *context, const dlnmeafix_s *fix)
+{
+	benchsum_s *sum = (benchsum_s *)context;
+
+	if (fix->type == NMEA_GPRMC) {
+		sum->lat += (double)fix->lat / NMEAPOS_SCALE;
+		sum->n++;
+	}
+}
+
+/** @brief Whether fix i of the replay corpus is written damaged
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int i
+ *  @return bool true if its checksum is corrupted or the frame is cut
+ */
+static bool BenchDamaged(int i)
+{
+	return i % UBXREPLAYBADEVERY == UBXREPLAYBADEVERY - 1 || i % UBXREPLAYCUTEVERY == UBXREPLAYCUTEVERY / 2;
+}
+
+/** @brief UBX decoder callback for the replay check, counts each fix by
+ *  its position
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * context uint8_t[UBXREPLAYEPOCHS]
+ *  @param const dlubxpvt_s * pvt
+ *  @return void
+ */
+static void BenchSeen(void *context, const dlubxpvt_s *pvt)
+{
+	uint8_t *seen = (uint8_t *)context;
+	int32_t i = (pvt->lat - BENCHLAT) / 10;
+
+	if (i >= 0 && i < UBXREPLAYEPOCHS && seen[i] < UINT8_MAX) {
+		seen[i]++;
+	}
+}
+
+/** @brief Builds the replay corpus
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param uint8_t * buf
+ *  @param size_t size
+ *  @return size_t bytes in buf
+ */
+static size_t BenchReplay(uint8_t *buf, size_t size)
+{
+	uint8_t payload[UBXNAVPVTSZ], ack[2] = { UBXCFG, UBXCFGRATE };
+	size_t n = 0, f;
+	int i;
+
+	n += DlUbxFrame(UBXACK, UBXACKACK, ack, sizeof(ack), buf + n, size - n);
+	for (i = 0; i < UBXREPLAYEPOCHS && size - n > 512; i++) {
+		BenchPvt(i, payload);
+		f = DlUbxFrame(UBXNAV, UBXNAVPVT, payload, UBXNAVPVTSZ, buf + n, size - n);
+		if (i % UBXREPLAYBADEVERY == UBXREPLAYBADEVERY - 1) {
+			buf[n + 40] ^= 0x10;
+		}
+		if (i % UBXREPLAYCUTEVERY == UBXREPLAYCUTEVERY / 2) {
+			// a frame lost mid payload, the next fix follows straight on
+			f = UBXREPLAYCUTSZ;
+		}
+		n += f;
+		if (i % 10 == 0) {
+			memset(payload, 0, 40);
+			n += DlUbxFrame(UBXNAV, UBXNAVSAT, payload, 40, buf + n, size - n);
+			n += BenchNmea(i, (char *)buf + n);
+		}
+	}
+	return n;
+}
+
+/** @brief Decodes a corpus and prints what it held
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const uint8_t * buf
+ *  @param size_t len
+ *  @param size_t chunk
+ *  @return void
+ */
+static void BenchDecode(const uint8_t *buf, size_t len, size_t chunk)
+{
+	benchsum_s sum = { 0, 0.0 };
+	uint32_t first = 0;
+	dlubx_s u;
+	size_t i;
+
+	DlUbxInit(&u);
+	for (i = 0; i < len; i += chunk) {
+		DlUbxFeed(&u, buf + i, len - i < chunk ? len - i : chunk, BenchPvtFix, &sum);
+		if (first == 0 && u.pvts) {
+			first = u.pvt.itow;
+		}
+	}
+	fprintf(stdout, "replay: %zu bytes frames %" PRIu64 " nav-pvt %" PRIu64 " acks %" PRIu64 " naks %" PRIu64
+		" bad checksum %" PRIu64 " malformed %" PRIu64 "\n", len, u.frames, u.pvts, u.acks, u.naks, u.badsum,
+		u.malformed);
+	if (u.pvts) {
+		fprintf(stdout, "replay: %.1fs of fixes, last %04u-%02u-%02u %02u:%02u:%02u.%03d fix %u sv %u "
+			"%.7f %.7f %.1fm %.2fm/s %.1fdeg hacc %.1fm\n", (u.pvt.itow - first) / 1000.0, u.pvt.year,
+			u.pvt.month, u.pvt.day, u.pvt.hour, u.pvt.min, u.pvt.sec, u.pvt.nano / 1000000, u.pvt.fixtype,
+			u.pvt.numsv, (double)u.pvt.lat / NMEAPOS_SCALE, (double)u.pvt.lon / NMEAPOS_SCALE,
+			u.pvt.hmsl / 1000.0, u.pvt.gspeed / 1000.0, u.pvt.headmot / 100000.0, u.pvt.hacc / 1000.0);
+	}
+}
+
+/** @brief Decodes a corpus written with -w at every chunk size and
+ *  checks that only the damaged fixes are lost
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const uint8_t * buf
+ *  @param size_t len
+ *  @param size_t chunk largest chunk tried
+ *  @return int 0 if every fix was found once except the damaged ones, 1 otherwise
+ */
+static int BenchCheck(const uint8_t *buf, size_t len, size_t chunk)
+{
+	uint8_t seen[UBXREPLAYEPOCHS];
+	int i, found, bad = 0;
+	size_t c, k;
+	dlubx_s u;
+
+	for (c = 1; c <= chunk; c++) {
+		memset(seen, 0, sizeof(seen));
+		DlUbxInit(&u);
+		for (k = 0; k < len; k += c) {
+			DlUbxFeed(&u, buf + k, len - k < c ? len - k : c, BenchSeen, seen);
+		}
+		for (i = 0; i < UBXREPLAYEPOCHS; i++) {
+			if (seen[i] != (BenchDamaged(i) ? 0 : 1)) {
+				fprintf(stderr, "check: chunk %zu fix %d decoded %u times\n", c, i, seen[i]);
+				bad++;
+			}
+		}
+	}
+	for (i = 0, found = 0; i < UBXREPLAYEPOCHS; i++) {
+		found += !BenchDamaged(i);
+	}
+	fprintf(stdout, "check: chunk 1 to %zu, %d of %d fixes expected each time, %s\n", chunk, found, UBXREPLAYEPOCHS,
+		bad ? "FAILED" : "ok, only the damaged fixes were lost");
+	return bad ? 1 : 0;
+}
+
+/** @brief Reads a whole file
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * path
+ *  @param size_t * len
+ *  @return uint8_t * contents, free with free, NULL on error
+ */
+static uint8_t *BenchRead(const char *path, size_t *len)
+{
+	FILE *fp = fopen(path, "rb");
+	uint8_t *buf = NULL;
+	long size;
+
+	if (fp == NULL) {
+		return NULL;
+	}
+	if (fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0) {
+		buf = (uint8_t *)malloc(size);
+		if (buf != NULL && fread(buf, 1, size, fp) != (size_t)size) {
+			free(buf);
+			buf = NULL;
+		}
+		*len = size;
+	}
+	fclose(fp);
+	return buf;
+}
+
+/** @brief Times both decoders over the same fixes
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int epochs
+ *  @param size_t chunk
+ *  @return int 0, 1 if out of memory
+ */
+static int BenchRate(int epochs, size_t chunk)
+{
+	uint8_t *ubx = (uint8_t *)malloc((size_t)epochs * (UBXHDRSZ + UBXNAVPVTSZ + UBXCKSZ));
+	char *nmea = (char *)malloc((size_t)epochs * 2 * NMEAMSGSZ);
+	benchsum_s usum = { 0, 0.0 }, nsum = { 0, 0.0 };
+	uint8_t payload[UBXNAVPVTSZ];
+	size_t ulen = 0, nlen = 0, i;
+	double tubx, tnmea;
+	uint64_t start;
+	dlnmea_s p;
+	dlubx_s u;
+	int e, pass;
+
+	if (ubx == NULL || nmea == NULL) {
+		free(ubx);
+		free(nmea);
+		return 1;
+	}
+	for (e = 0; e < epochs; e++) {
+		BenchPvt(e, payload);
+		ulen += DlUbxFrame(UBXNAV, UBXNAVPVT, payload, UBXNAVPVTSZ, ubx + ulen, UBXHDRSZ + UBXNAVPVTSZ + UBXCKSZ);
+		nlen += BenchNmea(e, nmea + nlen);
+	}
+	DlUbxInit(&u);
+	start = DlTimeNow();
+	for (pass = 0; pass < BENCHPASSES; pass++) {
+		for (i = 0; i < ulen; i += chunk) {
+			DlUbxFeed(&u, ubx + i, ulen - i < chunk ? ulen - i : chunk, BenchPvtFix, &usum);
+		}
+	}
+	tubx = (double)(DlTimeNow() - start) / NSPERSEC;
+	DlNmeaInit(&p);
+	start = DlTimeNow();
+	for (pass = 0; pass < BENCHPASSES; pass++) {
+		for (i = 0; i < nlen; i += chunk) {
+			DlNmeaFeed(&p, nmea + i, nlen - i < chunk ? nlen - i : chunk, BenchNmeaFix, &nsum);
+		}
+	}
+	tnmea = (double)(DlTimeNow() - start) / NSPERSEC;
+	fprintf(stdout, "epochs %d chunk %zu\n", epochs, chunk);
+	fprintf(stdout, "nmea gga+rmc %.0f fixes/s %.1f MB/s %.0f bytes/fix\n", nsum.n / tnmea,
+		BENCHPASSES * nlen / tnmea / 1e6, (double)nlen / epochs);
+	fprintf(stdout, "ubx nav-pvt %.0f fixes/s %.1f MB/s %.0f bytes/fix\n", usum.n / tubx,
+		BENCHPASSES * ulen / tubx / 1e6, (double)ulen / epochs);
+	fprintf(stdout, "speedup %.1fx mean latitude %.7f %.7f\n", tnmea / tubx, nsum.n ? nsum.lat / nsum.n : 0.0,
+		usum.n ? usum.lat / usum.n : 0.0);
+	free(ubx);
+	free(nmea);
+	return 0;
+}
+
+/** @brief Prints the options
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * prog argv[0]
+ *  @return void
+ */
+static void BenchUsage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-n epochs] [-c chunk] [-w corpus] [-r replay] [-t replay]\n"
+		"  -w writes %d fixes with noise mixed in, e.g. %s\n"
+		"  -t checks a corpus written with -w loses only its damaged fixes\n", prog, UBXREPLAYEPOCHS, UBXREPLAYFILE);
+}
+
+/** @brief Benchmarks the decoders, writes a corpus or replays one
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int argc
+ *  @param char ** argv
+ *  @return int program status
+ */
+int main(int argc, char **argv)
+{
+	int epochs = BENCHEPOCHS, opt, rc;
+	size_t chunk = BENCHCHUNK, len;
+	const char *corpus = NULL, *replay = NULL, *check = NULL;
+	uint8_t *buf;
+	FILE *fp;
+
+	while ((opt = getopt(argc, argv, "n:c:w:r:t:")) != -1) {
+		switch (opt) {
+		case 'n':
+			epochs = atoi(optarg);
+			break;
+		case 'c':
+			chunk = (size_t)atoi(optarg);
+			break;
+		case 'w':
+			corpus = optarg;
+			break;
+		case 'r':
+			replay = optarg;
+			break;
+		case 't':
+			check = optarg;
+			break;
+		default:
+			BenchUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (epochs <= 0 || chunk == 0) {
+		BenchUsage(argv[0]);
+		return 1;
+	}
+	if (corpus != NULL) {
+		buf = (uint8_t *)malloc(UBXREPLAYEPOCHS * 2 * (UBXHDRSZ + UBXNAVPVTSZ + UBXCKSZ + NMEAMSGSZ));
+		len = buf ? BenchReplay(buf, UBXREPLAYEPOCHS * 2 * (UBXHDRSZ + UBXNAVPVTSZ + UBXCKSZ + NMEAMSGSZ)) : 0;
+		fp = fopen(corpus, "wb");
+		if (fp == NULL || fwrite(buf, 1, len, fp) != len) {
+			fprintf(stderr, "ubxbench: cannot write %s\n", corpus);
+			return 1;
+		}
+		fclose(fp);
+		BenchDecode(buf, len, chunk);
+		free(buf);
+		return 0;
+	}
+	if (check != NULL) {
+		buf = BenchRead(check, &len);
+		if (buf == NULL) {
+			fprintf(stderr, "ubxbench: cannot read %s\n", check);
+			return 1;
+		}
+		rc = BenchCheck(buf, len, chunk);
+		free(buf);
+		return rc;
+	}
+	if (replay != NULL) {
+		buf = BenchRead(replay, &len);
+		if (buf == NULL) {
+			fprintf(stderr, "ubxbench: cannot read %s\n", replay);
+			return 1;
+		}
+		BenchDecode(buf, len, chunk);
+		free(buf);
+		return 0;
+	}
+	return BenchRate(epochs, chunk);
+}
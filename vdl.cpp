@@ -8,20 +8,133 @@
 #include "logger.h"
 #include "stdafx.h"
 //#include <ofArduino.h>
+#include <linux/input.h>
+#include "dlchannel.h"
 #include "dlfirmata.h"
+#include "dlgps.h"
+#include "dlpipeline.h"
+#include "dlreactor.h"
+#include "dlrotate.h"
+#include "dlsched.h"
+#include "dltime.h"
+#include "loggermqtt.h"
 
 ArduinoFirmata ard;
+dlsched_s sched;
+dlreactor_s reactor;
+
+/** @brief Scheduler task, takes a new set of readings
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg reading_s to fill
+ *  @return void
+ */
+static void SampleTask(void *arg)
+{
+	/*
+	ard.update();
+	*/
+	*(reading_s *)arg = DlGetLoggerReadings();
+}
+
+/** @brief Scheduler task, moves the level bubble on the SenseHat screen
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg latest reading_s
+ *  @return void
+ */
+static void LevelTask(void *arg)
+{
+	reading_s *reads = (reading_s *)arg;
+	DlUpdateLevel(reads->xa, reads->ya);
+}
+
+/** @brief Scheduler task, prints the latest readings to the console
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg latest reading_s
+ *  @return void
+ */
+static void DisplayTask(void *arg)
+{
+	DlDisplayLoggerReadings(*(reading_s *)arg);
+}
+
+/** @brief Scheduler task, hands the latest readings to the save/publish pipeline
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg latest reading_s
+ *  @return void
+ */
+static void SaveTask(void *arg)
+{
+	DlPipelinePush(*(reading_s *)arg);
+}
+
+/** @brief Scheduler task, prints scheduler and pipeline statistics
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg dlsched_s
+ *  @return void
+ */
+static void StatsTask(void *arg)
+{
+	DlSchedReport((dlsched_s *)arg, stdout);
+	DlChannelReport(stdout);
+	DlGpsReport(stdout);
+	DlPipelineReport(stdout);
+	DlRotateReport(stdout);
+	DlMqttReport(stdout);
+}
+
+/** @brief Scheduler task, refreshes the monotonic to UTC offset
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param void * arg unused
+ *  @return void
+ */
+static void ClockTask(void *arg)
+{
+	DlTimeSync();
+}
+
+/** @brief Event loop handler for the SenseHat joystick, pressing it prints
+ *  the statistics immediately
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int fd joystick evdev descriptor
+ *  @param uint32_t events ready events
+ *  @param void * arg dlsched_s
+ *  @return void
+ */
+static void JoystickEvent(int fd, uint32_t events, void *arg)
+{
+	if (DlJoystickRead() == KEY_ENTER) {
+		StatsTask(arg);
+	}
+}
+
+/** @brief SIGINT/SIGTERM handler, ends the event loop
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int sig
+ *  @return void
+ */
+static void StopHandler(int sig)
+{
+	DlSchedStop(&sched);
+	DlReactorStop(&reactor);
+}
 
 /** @brief Vehicle Data Logger main function
  *  @author Robert Miller
- *  @date 30Mar2022
+ *  @date 17Oct2026
  *  @param void
  *  @return int program status
  */
 int main(void)
 {
-  int tc = 0;
-  reading_s reads = {0};
+  static reading_s reads = {0};
   DlInitialization();
 	DlDisplayLogo();
 	sleep(3);
@@ -39,33 +152,33 @@ int main(void)
 
   ard.setupArduino(1);
 */
-  while (1) {
-	  /*
-		ard.update();
-		ard.sendDigital(WHITELED, 1);
-		*/
-    reads = DlGetLoggerReadings();
-    /*
-		if (ard.getDigital(LSWITCH) == 1) {
-			ard.sendDigital(BEEPER, 1);
-		} else {
-			ard.sendDigital(REDLED, 1);
-		}
-		*/
-    usleep(SLEEPTIME);
-    /*
-    ard.sendDigital(WHITELED, 0);
-    ard.sendDigital(REDLED, 0);
-    ard.sendDigital(BEEPER, 0);
-    */
-    DlUpdateLevel(reads.xa, reads.ya);
-		if (tc == LOGCOUNT) {
-			DlDisplayLoggerReadings(reads);
-			DlSaveLoggerData(reads);
-			tc =  0;
-    } else {
-			usleep(SLEEPTIME);
-			tc++;
-		}
-  }
+  DlSchedInit(&sched);
+  DlChannelAttach(&sched);
+  DlSchedAddTask(&sched, "sample", SAMPLEPERIODMS, SampleTask, &reads);
+  DlSchedAddTask(&sched, "level", LEVELPERIODMS, LevelTask, &reads);
+  DlSchedAddTask(&sched, "display", DISPLAYPERIODMS, DisplayTask, &reads);
+  DlSchedAddTask(&sched, "save", SAVEPERIODMS, SaveTask, &reads);
+  DlSchedAddTask(&sched, "stats", STATSPERIODMS, StatsTask, &sched);
+  DlSchedAddTask(&sched, "clock", TIMESYNCPERIODMS, ClockTask, NULL);
+  signal(SIGINT, StopHandler);
+  signal(SIGTERM, StopHandler);
+  DlReactorInit(&reactor);
+  DlSchedAttach(&sched, &reactor);
+  DlReactorAddFd(&reactor, DlJoystickFd(), EPOLLIN, JoystickEvent, &sched);
+  DlGpsStart(NULL);
+  DlRotateStart(NULL);
+  DlPipelineStart(NULL);
+  DlReactorRun(&reactor);
+  DlPipelineStop();
+  DlMqttStop();
+  DlRotateStop();
+  DlGpsStop();
+  DlReactorClose(&reactor);
+  DlSchedReport(&sched, stdout);
+  DlChannelReport(stdout);
+  DlGpsReport(stdout);
+  DlPipelineReport(stdout);
+  DlRotateReport(stdout);
+  DlMqttReport(stdout);
+  return 0;
 }
@@ -1,2 +1,6 @@
-#define SLEEPTIME 500000
-#define LOGCOUNT 10
+// Scheduler task periods in milliseconds
+#define SAMPLEPERIODMS 100
+#define LEVELPERIODMS 100
+#define DISPLAYPERIODMS 1000
+#define SAVEPERIODMS 100
+#define STATSPERIODMS 10000
@@ -0,0 +1,115 @@
+/** @file vdlexport.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Streams a binary log segment to the .csv or .json layout
+ *
+ *  usage: vdl-export [-j] segment.vdl[.gz] [output]
+ *
+ *  -j writes one JSON object per line, the default is CSV. Output goes to
+ *  stdout unless a file is given. Segments gzipped by rotation are read
+ *  as they are. Records with a bad CRC are skipped.
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <zlib.h>
+#include "dlformat.h"
+#include "dlrecord.h"
+
+#define EXPORTBUFSZ 65536
+
+/** @brief Prints usage to stderr
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param const char * prog
+ *  @return void
+ */
+static void DlExportUsage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-j] segment.vdl[.gz] [output]\n", prog);
+}
+
+/** @brief Converts every record of a segment
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int argc
+ *  @param char ** argv
+ *  @return int 0 on success, 1 on a usage or file error
+ */
+int main(int argc, char **argv)
+{
+	uint8_t record[RECSIZE];
+	char text[PAYLOADSTRSZ];
+	dlrechdr_s hdr;
+	reading_s creads;
+	uint64_t good = 0, bad = 0;
+	FILE *out = stdout;
+	gzFile in;
+	int n;
+	int json = 0;
+	int len;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j")) != -1) {
+		if (opt == 'j') {
+			json = 1;
+		} else {
+			DlExportUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind >= argc) {
+		DlExportUsage(argv[0]);
+		return 1;
+	}
+	in = gzopen(argv[optind], "rb");
+	if (in == NULL) {
+		perror(argv[optind]);
+		return 1;
+	}
+	gzbuffer(in, EXPORTBUFSZ);
+	if (!DlRecordReadHeader(in, &hdr)) {
+		fprintf(stderr, "%s: not a version %d segment\n", argv[optind], RECVERSION);
+		gzclose(in);
+		return 1;
+	}
+	if (optind + 1 < argc) {
+		out = fopen(argv[optind + 1], "w");
+		if (out == NULL) {
+			perror(argv[optind + 1]);
+			gzclose(in);
+			return 1;
+		}
+	}
+	while ((n = gzread(in, record, RECSIZE)) == RECSIZE) {
+		if (!DlRecordDecode(record, creads)) {
+			bad++;
+			continue;
+		}
+		if (json) {
+			len = DlFormatLoggerJson(creads, text, sizeof(text) - 1);
+			if (len > 0) {
+				text[len++] = '\n';
+			}
+		} else {
+			len = DlFormatLoggerCsv(creads, text, sizeof(text));
+		}
+		fwrite(text, 1, len, out);
+		good++;
+	}
+	if (n < 0) {
+		fprintf(stderr, "%s: %s\n", argv[optind], gzerror(in, &n));
+	} else if (n != 0) {
+		fprintf(stderr, "%s: truncated record at end of segment\n", argv[optind]);
+	}
+	if (bad) {
+		fprintf(stderr, "%s: skipped %" PRIu64 " records with a bad CRC\n", argv[optind], bad);
+	}
+	fprintf(stderr, "serial %" PRIx64 ", %" PRIu64 " records\n", hdr.serial, good);
+	gzclose(in);
+	if (out != stdout) {
+		fclose(out);
+	}
+	return 0;
+}
@@ -0,0 +1,85 @@
+/** @file writerbench.cpp
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @brief Compares records per second of fopen/fclose per record against DlWriter
+ *
+ *  usage: writerbench [records]
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "dltime.h"
+#include "dlwriter.h"
+
+#define BENCHRECORDS 20000
+#define BENCHFILE "writerbench.csv"
+#define BENCHLINE "1649116709000,20.7, 28,1003.0,-0.003172,0.006344,0.992836,-0.059473,-0.003667,-0.044193,24.693150,32.525532,44.811523,49.030521,12.077770,340.100006,13.839000,277.799988\n"
+
+/** @brief Writes records the way DlSaveLoggerData used to, one open/close each
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int records
+ *  @return double records per second
+ */
+static double BenchOpenClose(int records)
+{
+	uint64_t start = DlTimeNow();
+	FILE *fp;
+	int i;
+
+	for (i = 0; i < records; i++) {
+		fp = fopen(BENCHFILE, "a");
+		if (fp == NULL) {
+			return 0;
+		}
+		fputs(BENCHLINE, fp);
+		fclose(fp);
+	}
+	return records / ((double)(DlTimeNow() - start) / NSPERSEC);
+}
+
+/** @brief Writes records through a persistent buffered writer, synced on close
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int records
+ *  @return double records per second
+ */
+static double BenchWriter(int records)
+{
+	uint64_t start = DlTimeNow();
+	dlwriter_s w;
+	int i;
+
+	if (!DlWriterOpen(&w, BENCHFILE, NULL)) {
+		return 0;
+	}
+	for (i = 0; i < records; i++) {
+		DlWriterAppend(&w, BENCHLINE, sizeof(BENCHLINE) - 1);
+		DlWriterPoll(&w);
+	}
+	DlWriterClose(&w);
+	return records / ((double)(DlTimeNow() - start) / NSPERSEC);
+}
+
+/** @brief Runs both benchmarks and prints records per second
+ *  @author Robert Miller
+ *  @date 17Oct2026
+ *  @param int argc
+ *  @param char ** argv optional record count
+ *  @return int program status
+ */
+int main(int argc, char **argv)
+{
+	int records = argc > 1 ? atoi(argv[1]) : BENCHRECORDS;
+	double before, after;
+
+	unlink(BENCHFILE);
+	before = BenchOpenClose(records);
+	unlink(BENCHFILE);
+	after = BenchWriter(records);
+	unlink(BENCHFILE);
+	fprintf(stdout, "records %d\nfopen/fclose %.0f rec/s\ndlwriter %.0f rec/s\nspeedup %.1fx\n",
+		records, before, after, before > 0 ? after / before : 0.0);
+	return 0;
+}